@@ -38,9 +38,11 @@ SOURCES += \
     stream/audio_stream.cpp \
     stream/audio_stream_mixier.cpp \
     jam_manager.cpp \
+    instrument_previewer.cpp \
     pitch_converter.cpp \
     instrument/instruments_manager.cpp \
     command/command_manager.cpp \
+    command/packed_cells.cpp \
     command/instrument/add_instrument_command.cpp \
     command/instrument/remove_instrument_command.cpp \
     gui/command/instrument/add_instrument_qt_command.cpp \
@@ -57,6 +59,7 @@ SOURCES += \
     instrument/envelope_fm.cpp \
     gui/event_guard.cpp \
     tick_counter.cpp \
+    audio_profiler.cpp \
     module/module.cpp \
     module/song.cpp \
     module/pattern.cpp \
@@ -68,6 +71,7 @@ SOURCES += \
     gui/pattern_editor/pattern_editor.cpp \
     gui/instrument_editor/instrument_editor_ssg_form.cpp \
     gui/line_read_only_spin_box.cpp \
+    gui/channel_monitor.cpp \
     gui/command/pattern/set_key_off_to_step_qt_command.cpp \
     command/pattern/set_key_off_to_step_command.cpp \
     command/pattern/set_key_on_to_step_command.cpp \
@@ -147,6 +151,11 @@ SOURCES += \
     gui/comment_edit_dialog.cpp \
     io/file_io.cpp \
     io/binary_container.cpp \
+    io/mapped_file.cpp \
+    io/atomic_file_writer.cpp \
+    io/module_save_cache.cpp \
+    io/lz_compressor.cpp \
+    io/instrument_library.cpp \
     gui/command/pattern/interpolate_pattern_qt_command.cpp \
     command/pattern/interpolate_pattern_command.cpp \
     gui/command/pattern/reverse_pattern_qt_command.cpp \
@@ -154,6 +163,7 @@ SOURCES += \
     gui/command/pattern/replace_instrument_in_pattern_qt_command.cpp \
     command/pattern/replace_instrument_in_pattern_command.cpp \
     chips/export_container.cpp \
+    chips/output_monitor.cpp \
     gui/vgm_export_settings_dialog.cpp \
     gui/wave_export_settings_dialog.cpp \
     configuration.cpp \
@@ -179,10 +189,12 @@ HEADERS += \
     stream/audio_stream_mixier.hpp \
     chips/chip_def.h \
     jam_manager.hpp \
+    instrument_previewer.hpp \
     misc.hpp \
     pitch_converter.hpp \
     instrument/instruments_manager.hpp \
     command/command_manager.hpp \
+    command/packed_cells.hpp \
     command/instrument/add_instrument_command.hpp \
     command/instrument/remove_instrument_command.hpp \
     command/commands.hpp \
@@ -201,6 +213,7 @@ HEADERS += \
     instrument/envelope_fm.hpp \
     gui/event_guard.hpp \
     tick_counter.hpp \
+    audio_profiler.hpp \
     module/module.hpp \
     module/song.hpp \
     module/pattern.hpp \
@@ -212,6 +225,7 @@ HEADERS += \
     gui/pattern_editor/pattern_editor.hpp \
     gui/instrument_editor/instrument_editor_ssg_form.hpp \
     gui/line_read_only_spin_box.hpp \
+    gui/channel_monitor.hpp \
     gui/command/pattern/set_key_off_to_step_qt_command.hpp \
     command/pattern/set_key_off_to_step_command.hpp \
     gui/command/pattern/pattern_commands_qt.hpp \
@@ -297,6 +311,12 @@ HEADERS += \
     gui/comment_edit_dialog.hpp \
     io/file_io.hpp \
     io/binary_container.hpp \
+    io/binary_reader.hpp \
+    io/mapped_file.hpp \
+    io/atomic_file_writer.hpp \
+    io/module_save_cache.hpp \
+    io/lz_compressor.hpp \
+    io/instrument_library.hpp \
     version.hpp \
     gui/command/pattern/interpolate_pattern_qt_command.hpp \
     command/pattern/interpolate_pattern_command.hpp \
@@ -305,9 +325,11 @@ HEADERS += \
     gui/command/pattern/replace_instrument_in_pattern_qt_command.hpp \
     command/pattern/replace_instrument_in_pattern_command.hpp \
     chips/export_container.hpp \
+    chips/output_monitor.hpp \
     gui/vgm_export_settings_dialog.hpp \
     gui/wave_export_settings_dialog.hpp \
     io/gd3_tag.hpp \
+    io/wave_sample_format.hpp \
     configuration.hpp \
     gui/json.hpp \
     gui/color_palette.hpp \
@@ -0,0 +1,196 @@
+#include "audio_profiler.hpp"
+#include <limits>
+#include <sstream>
+#include <iomanip>
+
+AudioProfiler::Stage AudioProfiler::stages_[AudioProfiler::STAGE_COUNT] = {};
+std::atomic<uint64_t> AudioProfiler::underrunCnt_(0);
+std::atomic<uint64_t> AudioProfiler::deadlineMissCnt_(0);
+
+namespace
+{
+	const char* STAGE_NAMES_[AudioProfiler::STAGE_COUNT] = {
+		"stream_read", "tick", "chip_mix", "fm_update", "ssg_update",
+		"fm_resample", "ssg_resample", "final_mix", "export_record"
+	};
+
+	/// Minimum is stored inverted so that zero-initialized value means "unset"
+	inline uint64_t encodeMin(uint64_t ns)
+	{
+		return std::numeric_limits<uint64_t>::max() - ns;
+	}
+}
+
+AudioProfiler::Scope::Scope(AudioStage stage)
+	: stage_(stage),
+	  begin_(std::chrono::steady_clock::now())
+{
+}
+
+AudioProfiler::Scope::~Scope()
+{
+	auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				  std::chrono::steady_clock::now() - begin_).count();
+	record(stage_, static_cast<uint64_t>(ns));
+}
+
+void AudioProfiler::record(AudioStage stage, uint64_t ns)
+{
+	Stage& st = stages_[static_cast<int>(stage)];
+	st.buckets[getBucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+	st.sumNs.fetch_add(ns, std::memory_order_relaxed);
+
+	uint64_t inv = encodeMin(ns);
+	uint64_t cur = st.minNs.load(std::memory_order_relaxed);
+	while (cur < inv && !st.minNs.compare_exchange_weak(cur, inv, std::memory_order_relaxed)) {}
+	cur = st.maxNs.load(std::memory_order_relaxed);
+	while (cur < ns && !st.maxNs.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) {}
+
+	// Published last so that a reader never sees a count without its bucket
+	st.count.fetch_add(1, std::memory_order_release);
+}
+
+void AudioProfiler::countUnderrun()
+{
+	underrunCnt_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AudioProfiler::countDeadlineMiss()
+{
+	deadlineMissCnt_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AudioProfiler::getSnapshot(Snapshot& snap)
+{
+	for (int s = 0; s < STAGE_COUNT; ++s) {
+		Stage& st = stages_[s];
+		snap.count[s] = st.count.load(std::memory_order_acquire);
+		snap.sumNs[s] = st.sumNs.load(std::memory_order_relaxed);
+		uint64_t inv = st.minNs.load(std::memory_order_relaxed);
+		snap.minNs[s] = inv ? encodeMin(inv) : 0;
+		snap.maxNs[s] = st.maxNs.load(std::memory_order_relaxed);
+		for (int i = 0; i < BUCKET_COUNT; ++i)
+			snap.buckets[s][i] = st.buckets[i].load(std::memory_order_relaxed);
+	}
+	snap.underrunCount = underrunCnt_.load(std::memory_order_relaxed);
+	snap.deadlineMissCount = deadlineMissCnt_.load(std::memory_order_relaxed);
+}
+
+AudioProfiler::Statistics AudioProfiler::getStatistics(AudioStage stage, const Snapshot& cur, const Snapshot& prev)
+{
+	int s = static_cast<int>(stage);
+	uint64_t diff[BUCKET_COUNT];
+	uint64_t total = 0;
+	int lo = -1, hi = -1;
+	for (int i = 0; i < BUCKET_COUNT; ++i) {
+		// Buckets may be updated after the count was read, so recount them
+		diff[i] = cur.buckets[s][i] - prev.buckets[s][i];
+		if (diff[i]) {
+			if (lo == -1) lo = i;
+			hi = i;
+			total += diff[i];
+		}
+	}
+
+	Statistics stat;
+	stat.count = total;
+	if (!total) {
+		stat.minUs = stat.avgUs = stat.p99Us = stat.maxUs = 0.;
+		return stat;
+	}
+	uint64_t cnt = cur.count[s] - prev.count[s];
+	stat.avgUs = cnt ? (cur.sumNs[s] - prev.sumNs[s]) / 1000. / cnt : 0.;
+	stat.minUs = getBucketLowerBound(lo) / 1000.;
+	stat.maxUs = getBucketLowerBound(hi + 1) / 1000.;
+	stat.p99Us = getPercentile(diff, total, 0.99) / 1000.;
+	return stat;
+}
+
+AudioProfiler::Statistics AudioProfiler::getStatistics(AudioStage stage, const Snapshot& snap)
+{
+	int s = static_cast<int>(stage);
+	uint64_t total = 0;
+	for (int i = 0; i < BUCKET_COUNT; ++i) total += snap.buckets[s][i];
+
+	Statistics stat;
+	stat.count = snap.count[s];
+	if (!stat.count) {
+		stat.minUs = stat.avgUs = stat.p99Us = stat.maxUs = 0.;
+		return stat;
+	}
+	stat.minUs = snap.minNs[s] / 1000.;
+	stat.avgUs = snap.sumNs[s] / 1000. / snap.count[s];
+	stat.p99Us = getPercentile(snap.buckets[s], total, 0.99) / 1000.;
+	stat.maxUs = snap.maxNs[s] / 1000.;
+	return stat;
+}
+
+std::string AudioProfiler::toJson(const Snapshot& snap)
+{
+	std::ostringstream ss;
+	ss << std::fixed << std::setprecision(3);
+	ss << "{\n\t\"underruns\": " << snap.underrunCount
+	   << ",\n\t\"deadline_misses\": " << snap.deadlineMissCount
+	   << ",\n\t\"stages\": {";
+	for (int s = 0; s < STAGE_COUNT; ++s) {
+		auto stage = static_cast<AudioStage>(s);
+		Statistics stat = getStatistics(stage, snap);
+		ss << (s ? "," : "") << "\n\t\t\"" << getStageName(stage) << "\": {"
+		   << "\"count\": " << stat.count
+		   << ", \"min_us\": " << stat.minUs
+		   << ", \"avg_us\": " << stat.avgUs
+		   << ", \"p99_us\": " << stat.p99Us
+		   << ", \"max_us\": " << stat.maxUs
+		   << ", \"histogram_ns\": [";
+		bool isFirst = true;
+		for (int i = 0; i < BUCKET_COUNT; ++i) {
+			if (!snap.buckets[s][i]) continue;
+			ss << (isFirst ? "" : ", ") << "[" << getBucketLowerBound(i) << ", " << snap.buckets[s][i] << "]";
+			isFirst = false;
+		}
+		ss << "]}";
+	}
+	ss << "\n\t}\n}\n";
+	return ss.str();
+}
+
+const char* AudioProfiler::getStageName(AudioStage stage)
+{
+	return STAGE_NAMES_[static_cast<int>(stage)];
+}
+
+/// [0, 4): exact, [4, inf): 4 sub-buckets per octave
+int AudioProfiler::getBucketIndex(uint64_t ns)
+{
+	if (ns < 4) return static_cast<int>(ns);
+	int m = 63;
+	while (!(ns >> m)) --m;
+	int idx = 4 * (m - 1) + static_cast<int>((ns >> (m - 2)) & 3);
+	return (idx < BUCKET_COUNT) ? idx : BUCKET_COUNT - 1;
+}
+
+uint64_t AudioProfiler::getBucketLowerBound(int idx)
+{
+	if (idx < 4) return static_cast<uint64_t>(idx);
+	int m = idx / 4 + 1;
+	return static_cast<uint64_t>(4 + idx % 4) << (m - 2);
+}
+
+double AudioProfiler::getPercentile(const uint64_t* buckets, uint64_t count, double ratio)
+{
+	if (!count) return 0.;
+	auto target = static_cast<uint64_t>(count * ratio);
+	if (target >= count) target = count - 1;
+	uint64_t acc = 0;
+	for (int i = 0; i < BUCKET_COUNT; ++i) {
+		acc += buckets[i];
+		if (acc > target) {
+			// Interpolate linearly in the bucket
+			double lo = getBucketLowerBound(i);
+			double hi = getBucketLowerBound(i + 1);
+			double pos = static_cast<double>(target - (acc - buckets[i])) / buckets[i];
+			return lo + (hi - lo) * pos;
+		}
+	}
+	return getBucketLowerBound(BUCKET_COUNT - 1);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+enum class AudioStage : int
+{
+	STREAM_READ,	// AudioStreamMixier::readData
+	TICK,			// BambooTracker::streamCountUp
+	CHIP_MIX,		// chip::OPNA::mix
+	FM_UPDATE,
+	SSG_UPDATE,
+	FM_RESAMPLE,
+	SSG_RESAMPLE,
+	FINAL_MIX,
+	EXPORT_RECORD	// Export container hook in chip::OPNA::mix
+};
+
+/// Timing histograms of audio stages and underrun counters.
+/// Recording is lock-free and it is safe to read from other threads at any time
+class AudioProfiler
+{
+public:
+	static constexpr int STAGE_COUNT = 9;
+	/// Quarter-octave buckets of nanoseconds
+	static constexpr int BUCKET_COUNT = 256;
+
+	struct Snapshot
+	{
+		uint64_t buckets[STAGE_COUNT][BUCKET_COUNT];
+		uint64_t count[STAGE_COUNT], sumNs[STAGE_COUNT];
+		uint64_t minNs[STAGE_COUNT], maxNs[STAGE_COUNT];
+		uint64_t underrunCount, deadlineMissCount;
+	};
+
+	struct Statistics
+	{
+		uint64_t count;
+		double minUs, avgUs, p99Us, maxUs;
+	};
+
+	/// Measure a stage in the scope
+	class Scope
+	{
+	public:
+		explicit Scope(AudioStage stage);
+		~Scope();
+
+	private:
+		AudioStage stage_;
+		std::chrono::steady_clock::time_point begin_;
+	};
+
+	static void record(AudioStage stage, uint64_t ns);
+	/// Reported by the audio device
+	static void countUnderrun();
+	/// Rendering took longer than the duration of rendered samples
+	static void countDeadlineMiss();
+
+	static void getSnapshot(Snapshot& snap);
+	/// Statistics between 2 snapshots. Min and max are bounds of histogram buckets
+	static Statistics getStatistics(AudioStage stage, const Snapshot& cur, const Snapshot& prev);
+	/// Cumulative statistics with exact min and max
+	static Statistics getStatistics(AudioStage stage, const Snapshot& snap);
+	static std::string toJson(const Snapshot& snap);
+	static const char* getStageName(AudioStage stage);
+
+private:
+	AudioProfiler() {}
+
+	struct Stage
+	{
+		std::atomic<uint64_t> buckets[BUCKET_COUNT];
+		std::atomic<uint64_t> count, sumNs, minNs, maxNs;
+	};
+	static Stage stages_[STAGE_COUNT];
+	static std::atomic<uint64_t> underrunCnt_, deadlineMissCnt_;
+
+	static int getBucketIndex(uint64_t ns);
+	static uint64_t getBucketLowerBound(int idx);
+	static double getPercentile(const uint64_t* buckets, uint64_t count, double ratio);
+};
@@ -2,8 +2,10 @@
 #include <algorithm>
 #include <utility>
 #include <set>
+#include <chrono>
 #include "commands.hpp"
 #include "file_io.hpp"
+#include "audio_profiler.hpp"
 
 const uint32_t BambooTracker::CHIP_CLOCK = 3993600 * 2;
 
@@ -27,6 +29,11 @@ BambooTracker::BambooTracker(std::weak_ptr<Configuration> config)
 	songStyle_ = mod_->getSong(curSongNum_).getStyle();
 	jamMan_ = std::make_unique<JamManager>(songStyle_.type);
 
+	previewer_ = std::make_unique<InstrumentPreviewer>(
+					 CHIP_CLOCK, opnaCtrl_->getRate(), static_cast<int>(mod_->getTickFrequency()));
+
+	comMan_.setMemoryLimit(static_cast<size_t>(config.lock()->getUndoMemoryLimit()) * 1024 * 1024);
+
 	clearDelayCounts();
 }
 
@@ -35,6 +42,7 @@ void BambooTracker::changeConfiguration(std::weak_ptr<Configuration> config)
 {
 	setStreamRate(config.lock()->getSampleRate());
 	setStreamDuration(config.lock()->getBufferLength());
+	comMan_.setMemoryLimit(static_cast<size_t>(config.lock()->getUndoMemoryLimit()) * 1024 * 1024);
 }
 
 /********** Change octave **********/
@@ -586,31 +594,29 @@ void BambooTracker::setCurrentSongNumber(int num)
 	tickCounter_.setGroove(mod_->getGroove(song.getGroove()).getSequence());
 	tickCounter_.setGrooveEnebled(song.isUsedTempo());
 
-	switch (songStyle_.type) {
-	case SongType::STD:
-		ntDlyCntFM_ = std::vector<int>(6);
-		ntCutDlyCntFM_ = std::vector<int>(6);
-		volDlyCntFM_ = std::vector<int>(6);
-		volDlyValueFM_ = std::vector<int>(6, -1);
-		tposeDlyCntFM_ = std::vector<int>(6);
-		tposeDlyValueFM_ = std::vector<int>(6);
-		break;
-	case SongType::FMEX:
-		// UNDONE: extend ch4
-		break;
+	size_t trackCnt = songStyle_.trackAttribs.size();
+	ntDlyCnt_ = std::vector<int>(trackCnt);
+	ntCutDlyCnt_ = std::vector<int>(trackCnt);
+	volDlyCnt_ = std::vector<int>(trackCnt);
+	tposeDlyCnt_ = std::vector<int>(trackCnt);
+	volDlyValue_ = std::vector<int>(trackCnt);
+	tposeDlyValue_ = std::vector<int>(trackCnt);
+	trackNumFM_.clear();
+	trackNumSSG_.clear();
+	trackNumDrum_.clear();
+	for (auto& attrib : songStyle_.trackAttribs) {
+		std::vector<int>* nums = nullptr;
+		switch (attrib.source) {
+		case SoundSource::FM:	nums = &trackNumFM_;	break;
+		case SoundSource::SSG:	nums = &trackNumSSG_;	break;
+		case SoundSource::DRUM:	nums = &trackNumDrum_;	break;
+		default:	continue;
+		}
+		if (nums->size() <= static_cast<size_t>(attrib.channelInSource))
+			nums->resize(attrib.channelInSource + 1);
+		nums->at(attrib.channelInSource) = attrib.number;
 	}
-
-	ntDlyCntSSG_ = std::vector<int>(3);
-	ntCutDlyCntSSG_ = std::vector<int>(3);
-	volDlyCntSSG_ = std::vector<int>(3);
-	volDlyValueSSG_ = std::vector<int>(3, -1);
-	tposeDlyCntSSG_ = std::vector<int>(3);
-	tposeDlyValueSSG_ = std::vector<int>(3);
-
-	ntDlyCntDrum_ = std::vector<int>(6);
-	ntCutDlyCntDrum_ = std::vector<int>(6);
-	volDlyCntDrum_ = std::vector<int>(6);
-	volDlyValueDrum_ = std::vector<int>(6, -1);
+	clearDelayCounts();
 }
 
 /********** Order edit **********/
@@ -651,6 +657,16 @@ void BambooTracker::clearCommandHistory()
 	comMan_.clear();
 }
 
+bool BambooTracker::canUndo() const
+{
+	return comMan_.getUndoCount() > 0;
+}
+
+size_t BambooTracker::getCommandHistoryMemorySize() const
+{
+	return comMan_.getMemorySize();
+}
+
 /********** Jam mode **********/
 void BambooTracker::toggleJamMode()
 {
@@ -734,6 +750,28 @@ void BambooTracker::jamKeyOff(JamKey key)
 	}
 }
 
+/********** Instrument preview **********/
+void BambooTracker::previewInstrument(int instNum, JamKey key)
+{
+	previewer_->play(instMan_, instNum, JamManager::jamKeyToNote(key), JamManager::calcOctave(octave_, key));
+}
+
+void BambooTracker::stopInstrumentPreview()
+{
+	previewer_->stop();
+}
+
+std::shared_ptr<const PreviewClip> BambooTracker::getInstrumentPreviewClip(int instNum, JamKey key)
+{
+	return previewer_->request(instMan_, instNum, JamManager::jamKeyToNote(key),
+							   JamManager::calcOctave(octave_, key));
+}
+
+void BambooTracker::setInstrumentPreviewRenderedCallback(std::function<void(int)> f)
+{
+	previewer_->setRenderedCallback(f);
+}
+
 /********** Play song **********/
 void BambooTracker::startPlaySong()
 {
@@ -849,12 +887,14 @@ int BambooTracker::getPlayingStepNumber() const
 }
 
 /********** Export **********/
-bool BambooTracker::exportToWav(std::string file, int loopCnt, std::function<bool()> f)
+bool BambooTracker::exportToWav(std::string file, int loopCnt, WaveSampleFormat format, std::function<bool()> f)
 {
 	size_t sampCnt = opnaCtrl_->getRate() * opnaCtrl_->getDuration() / 1000;
-	size_t intrCnt = opnaCtrl_->getRate() / mod_->getTickFrequency();
+	uint32_t rate = static_cast<uint32_t>(opnaCtrl_->getRate());
+	uint32_t tickFreq = mod_->getTickFrequency();
+	uint64_t intrIdx = 0;
 	size_t intrCntRest = 0;
-	std::vector<int16_t> dumbuf(sampCnt << 1);
+	std::vector<float> dumbuf(sampCnt << 1);
 
 	bool endFlag = false;
 	bool tmpFollow = isFollowPlay_;
@@ -863,11 +903,20 @@ bool BambooTracker::exportToWav(std::string file, int loopCnt, std::function<boo
 	opnaCtrl_->setExportContainer(exCntr);
 	startPlayFromStart();
 
+	// Estimate the length by the initial tempo and speed. Effects in the song change it
+	size_t stepCnt = 0;
+	for (size_t o = 0, odrCnt = getOrderSize(curSongNum_); o < odrCnt; ++o)
+		stepCnt += getPatternSizeFromOrderNumber(curSongNum_, static_cast<int>(o));
+	exCntr->reserve(tickCounter_.getSampleIndexOfStep(stepCnt * static_cast<size_t>(loopCnt + 1), rate));
+
 	while (true) {
 		size_t sampCntRest = sampCnt;
 		while (sampCntRest) {
 			if (!intrCntRest) {	// Interruption
-				intrCntRest = intrCnt;    // Set counts to next interruption
+				// Set counts to next interruption
+				intrCntRest = TickCounter::getSampleIndexOfTick(intrIdx + 1, rate, tickFreq)
+							  - TickCounter::getSampleIndexOfTick(intrIdx, rate, tickFreq);
+				++intrIdx;
 
 				if (!streamCountUp()) {
 					if (f()) {	// Update lambda function
@@ -898,7 +947,7 @@ bool BambooTracker::exportToWav(std::string file, int loopCnt, std::function<boo
 	stopPlaySong();
 	isFollowPlay_ = tmpFollow;
 
-	bool ret = FileIO::writeWave(file, exCntr->getStream(), opnaCtrl_->getRate());
+	bool ret = FileIO::writeWave(file, exCntr->getStream(), opnaCtrl_->getRate(), format);
 	f();
 
 	return ret;
@@ -908,15 +957,16 @@ bool BambooTracker::exportToVgm(std::string file, bool gd3TagEnabled, GD3Tag tag
 {
 	int tmpRate = opnaCtrl_->getRate();
 	opnaCtrl_->setRate(44100);
-	size_t intrCnt = 44100 / mod_->getTickFrequency();
-	std::vector<int16_t> dumbuf(intrCnt << 1);
+	uint32_t tickFreq = mod_->getTickFrequency();
+	uint64_t intrIdx = 0;
+	std::vector<float> dumbuf((44100 / tickFreq + 1) << 1);
 
 	int lastOrder = getOrderSize(curSongNum_) - 1;
 	int lastStep = getPatternSizeFromOrderNumber(curSongNum_, lastOrder) - 1;
 	bool loopFlag = true;
 	int loopOrder = 0;
 	int loopStep = 0;
-	auto& song = mod_->getSong(curSongNum_);
+	const Song& song = mod_->getSong(curSongNum_);
 	for (auto attrib : songStyle_.trackAttribs) {
 		auto& step = song.getTrack(attrib.number).getPatternFromOrderNumber(lastOrder).getStep(lastStep);
 		for (int i = 0; i < 4; ++i) {
@@ -975,7 +1025,10 @@ bool BambooTracker::exportToVgm(std::string file, bool gd3TagEnabled, GD3Tag tag
 			}
 		}
 
-		opnaCtrl_->getStreamSamples(&dumbuf[0], intrCnt);
+		size_t count = TickCounter::getSampleIndexOfTick(intrIdx + 1, 44100, tickFreq)
+					   - TickCounter::getSampleIndexOfTick(intrIdx, 44100, tickFreq);
+		++intrIdx;
+		opnaCtrl_->getStreamSamples(&dumbuf[0], count);
 	}
 
 	opnaCtrl_->setExportContainer();
@@ -996,9 +1049,30 @@ bool BambooTracker::backupModule(std::string file)
 	return FileIO::backupModule(file);
 }
 
+bool BambooTracker::autosaveModule(std::string file)
+{
+	if (isAutosaving()) return false;
+	autosave_ = FileIO::saveModuleInBackground(file, mod_, instMan_);
+	return true;
+}
+
+bool BambooTracker::isAutosaving() const
+{
+	return (autosave_.valid()
+			&& autosave_.wait_for(std::chrono::seconds(0)) != std::future_status::ready);
+}
+
+bool BambooTracker::takeAutosaveResult(bool& isSucceeded, bool isWaited)
+{
+	if (!autosave_.valid() || (!isWaited && isAutosaving())) return false;
+	isSucceeded = autosave_.get();
+	return true;
+}
+
 /********** Stream events **********/
 int BambooTracker::streamCountUp()
 {
+	AudioProfiler::Scope prof(AudioStage::TICK);
 	int state = tickCounter_.countUp();
 
 	if (state > 0) {
@@ -1027,74 +1101,70 @@ void BambooTracker::readTick(int rest)
 	if (!(playState_ & 0x02)) return;	// When it has not read first step
 
 	// Delay
-	auto f = [](int x) { return (x == -1) ? x : --x; };
-	std::transform(ntDlyCntFM_.begin(), ntDlyCntFM_.end(), ntDlyCntFM_.begin(), f);
-	std::transform(ntDlyCntSSG_.begin(), ntDlyCntSSG_.end(), ntDlyCntSSG_.begin(), f);
-	std::transform(ntDlyCntDrum_.begin(), ntDlyCntDrum_.end(), ntDlyCntDrum_.begin(), f);
-	std::transform(ntCutDlyCntFM_.begin(), ntCutDlyCntFM_.end(), ntCutDlyCntFM_.begin(), f);
-	std::transform(ntCutDlyCntSSG_.begin(), ntCutDlyCntSSG_.end(), ntCutDlyCntSSG_.begin(), f);
-	std::transform(ntCutDlyCntDrum_.begin(), ntCutDlyCntDrum_.end(), ntCutDlyCntDrum_.begin(), f);
-	std::transform(volDlyCntFM_.begin(), volDlyCntFM_.end(), volDlyCntFM_.begin(), f);
-	std::transform(volDlyCntSSG_.begin(), volDlyCntSSG_.end(), volDlyCntSSG_.begin(), f);
-	std::transform(volDlyCntDrum_.begin(), volDlyCntDrum_.end(), volDlyCntDrum_.begin(), f);
-	std::transform(tposeDlyCntFM_.begin(), tposeDlyCntFM_.end(), tposeDlyCntFM_.begin(), f);
-	std::transform(tposeDlyCntSSG_.begin(), tposeDlyCntSSG_.end(), tposeDlyCntSSG_.begin(), f);
+	uint32_t dlyFlags = countDownDelays();
 
-	auto& song = mod_->getSong(curSongNum_);
+	const Song& song = mod_->getSong(curSongNum_);
 	for (auto& attrib : songStyle_.trackAttribs) {
-		auto& curStep = song.getTrack(attrib.number)
-						.getPatternFromOrderNumber(curOrderNum_).getStep(playStepNum_);
-		switch (attrib.source) {
-		case SoundSource::FM:
-		{
-			// Check volume delay
-			if (!volDlyCntFM_[attrib.channelInSource])
-				opnaCtrl_->setTemporaryVolumeFM(attrib.channelInSource, volDlyValueFM_[attrib.channelInSource]);
-			// Check note cut
-			if (!ntCutDlyCntFM_[attrib.channelInSource])
-				opnaCtrl_->keyOffFM(attrib.channelInSource);
-			// Check transpose delay
-			if (!tposeDlyCntFM_[attrib.channelInSource])
-				opnaCtrl_->setTransposeEffectFM(attrib.channelInSource, tposeDlyValueFM_[attrib.channelInSource]);
-			// Check note delay and envelope reset
-			readTickFMForNoteDelay(curStep, attrib.channelInSource);
-			break;
-		}
-		case SoundSource::SSG:
-		{
-			// Check volume delay
-			if (!volDlyCntSSG_[attrib.channelInSource])
-				opnaCtrl_->setTemporaryVolumeSSG(attrib.channelInSource, volDlyValueSSG_[attrib.channelInSource]);
-			// Check note cut
-			if (!ntCutDlyCntSSG_[attrib.channelInSource])
-				opnaCtrl_->keyOffSSG(attrib.channelInSource);
-			// Check transpose delay
-			if (!tposeDlyCntSSG_[attrib.channelInSource])
-				opnaCtrl_->setTransposeEffectSSG(attrib.channelInSource, tposeDlyValueSSG_[attrib.channelInSource]);
-			// Check note delay
-			if (!ntDlyCntSSG_[attrib.channelInSource])
-				readSSGStep(curStep, attrib.channelInSource, true);
-			break;
-		}
-		case SoundSource::DRUM:
-		{
-			// Check volume delay
-			if (!volDlyCntDrum_[attrib.channelInSource])
-				opnaCtrl_->setTemporaryVolumeDrum(attrib.channelInSource, volDlyValueDrum_[attrib.channelInSource]);
-			// Check note cut
-			if (!ntCutDlyCntDrum_[attrib.channelInSource])
-				opnaCtrl_->keyOnDrum(attrib.channelInSource);
-			// Check note delay
-			if (!ntDlyCntDrum_[attrib.channelInSource])
-				readDrumStep(curStep, attrib.channelInSource, true);
-			break;
-		}
+		int t = attrib.number;
+		if (dlyFlags & (1u << t)) {
+			switch (attrib.source) {
+			case SoundSource::FM:
+			{
+				// Check volume delay
+				if (!volDlyCnt_[t])
+					opnaCtrl_->setTemporaryVolumeFM(attrib.channelInSource, volDlyValue_[t]);
+				// Check note cut
+				if (!ntCutDlyCnt_[t])
+					opnaCtrl_->keyOffFM(attrib.channelInSource);
+				// Check transpose delay
+				if (!tposeDlyCnt_[t])
+					opnaCtrl_->setTransposeEffectFM(attrib.channelInSource, tposeDlyValue_[t]);
+				// Check note delay and envelope reset
+				if (ntDlyCnt_[t] == 0 || ntDlyCnt_[t] == 1) {
+					auto& curStep = song.getTrack(t).getPatternFromOrderNumber(curOrderNum_).getStep(playStepNum_);
+					readTickFMForNoteDelay(curStep, attrib.channelInSource);
+				}
+				break;
+			}
+			case SoundSource::SSG:
+			{
+				// Check volume delay
+				if (!volDlyCnt_[t])
+					opnaCtrl_->setTemporaryVolumeSSG(attrib.channelInSource, volDlyValue_[t]);
+				// Check note cut
+				if (!ntCutDlyCnt_[t])
+					opnaCtrl_->keyOffSSG(attrib.channelInSource);
+				// Check transpose delay
+				if (!tposeDlyCnt_[t])
+					opnaCtrl_->setTransposeEffectSSG(attrib.channelInSource, tposeDlyValue_[t]);
+				// Check note delay
+				if (!ntDlyCnt_[t]) {
+					auto& curStep = song.getTrack(t).getPatternFromOrderNumber(curOrderNum_).getStep(playStepNum_);
+					readSSGStep(curStep, attrib.channelInSource, true);
+				}
+				break;
+			}
+			case SoundSource::DRUM:
+			{
+				// Check volume delay
+				if (!volDlyCnt_[t])
+					opnaCtrl_->setTemporaryVolumeDrum(attrib.channelInSource, volDlyValue_[t]);
+				// Check note cut
+				if (!ntCutDlyCnt_[t])
+					opnaCtrl_->keyOnDrum(attrib.channelInSource);
+				// Check note delay
+				if (!ntDlyCnt_[t]) {
+					auto& curStep = song.getTrack(t).getPatternFromOrderNumber(curOrderNum_).getStep(playStepNum_);
+					readDrumStep(curStep, attrib.channelInSource, true);
+				}
+				break;
+			}
+			}
 		}
 
 		if (rest == 1 && nextReadOrder_ != -1 && attrib.source == SoundSource::FM) {
 			// Channel envelope reset before next key on
-			auto& step = song.getTrack(attrib.number)
-						 .getPatternFromOrderNumber(nextReadOrder_).getStep(nextReadStep_);
+			auto& step = song.getTrack(t).getPatternFromOrderNumber(nextReadOrder_).getStep(nextReadStep_);
 			int n = step.checkEffectID("0G");
 			if (n == -1 || !step.getEffectValue(n)) {
 				envelopeResetEffectFM(step, attrib.channelInSource);
@@ -1109,9 +1179,33 @@ void BambooTracker::readTick(int rest)
 	}
 }
 
-void BambooTracker::readTickFMForNoteDelay(Step& step, int ch)
+/// Count down counters of all tracks in one pass.
+/// Note delay counter 1 is also flagged for FM envelope reset.
+uint32_t BambooTracker::countDownDelays()
 {
-	int cnt = ntDlyCntFM_[ch];
+	uint32_t flags = 0;
+	for (size_t t = 0; t < ntDlyCnt_.size(); ++t) {
+		int nd = ntDlyCnt_[t];
+		int nc = ntCutDlyCnt_[t];
+		int vd = volDlyCnt_[t];
+		int td = tposeDlyCnt_[t];
+		nd -= (nd != -1);
+		nc -= (nc != -1);
+		vd -= (vd != -1);
+		td -= (td != -1);
+		ntDlyCnt_[t] = nd;
+		ntCutDlyCnt_[t] = nc;
+		volDlyCnt_[t] = vd;
+		tposeDlyCnt_[t] = td;
+		bool isEvent = (nd == 0 || nd == 1 || !nc || !vd || !td);
+		flags |= (static_cast<uint32_t>(isEvent) << t);
+	}
+	return flags;
+}
+
+void BambooTracker::readTickFMForNoteDelay(const Step& step, int ch)
+{
+	int cnt = ntDlyCnt_[trackNumFM_[ch]];
 	if (!cnt) {
 		readFMStep(step, ch, true);
 	}
@@ -1121,7 +1215,7 @@ void BambooTracker::readTickFMForNoteDelay(Step& step, int ch)
 	}
 }
 
-void BambooTracker::envelopeResetEffectFM(Step& step, int ch)
+void BambooTracker::envelopeResetEffectFM(const Step& step, int ch)
 {
 	if (step.getNoteNumber() >= 0) {
 		int idx = step.checkEffectID("03");
@@ -1145,22 +1239,12 @@ void BambooTracker::envelopeResetEffectFM(Step& step, int ch)
 
 void BambooTracker::clearDelayCounts()
 {
-	std::fill(ntDlyCntFM_.begin(), ntDlyCntFM_.end(), -1);
-	std::fill(ntCutDlyCntFM_.begin(), ntCutDlyCntFM_.end(), -1);
-	std::fill(volDlyCntFM_.begin(), volDlyCntFM_.end(), -1);
-	std::fill(volDlyValueFM_.begin(), volDlyValueFM_.end(), -1);
-	std::fill(tposeDlyCntFM_.begin(), tposeDlyCntFM_.end(), -1);
-	std::fill(tposeDlyValueFM_.begin(), tposeDlyValueFM_.end(), 0);
-	std::fill(ntDlyCntSSG_.begin(), ntDlyCntSSG_.end(), -1);
-	std::fill(ntCutDlyCntSSG_.begin(), ntCutDlyCntSSG_.end(), -1);
-	std::fill(volDlyCntSSG_.begin(), volDlyCntSSG_.end(), -1);
-	std::fill(volDlyValueSSG_.begin(), volDlyValueSSG_.end(), -1);
-	std::fill(tposeDlyCntSSG_.begin(), tposeDlyCntSSG_.end(), -1);
-	std::fill(tposeDlyValueSSG_.begin(), tposeDlyValueSSG_.end(), 0);
-	std::fill(ntDlyCntDrum_.begin(), ntDlyCntDrum_.end(), -1);
-	std::fill(ntCutDlyCntDrum_.begin(), ntCutDlyCntDrum_.end(), -1);
-	std::fill(volDlyCntDrum_.begin(), volDlyCntDrum_.end(), -1);
-	std::fill(volDlyValueDrum_.begin(), volDlyValueDrum_.end(), -1);
+	std::fill(ntDlyCnt_.begin(), ntDlyCnt_.end(), -1);
+	std::fill(ntCutDlyCnt_.begin(), ntCutDlyCnt_.end(), -1);
+	std::fill(volDlyCnt_.begin(), volDlyCnt_.end(), -1);
+	std::fill(volDlyValue_.begin(), volDlyValue_.end(), -1);
+	std::fill(tposeDlyCnt_.begin(), tposeDlyCnt_.end(), -1);
+	std::fill(tposeDlyValue_.begin(), tposeDlyValue_.end(), 0);
 }
 
 void BambooTracker::findNextStep()
@@ -1218,7 +1302,7 @@ void BambooTracker::readStep()
 
 	clearDelayCounts();
 
-	auto& song = mod_->getSong(curSongNum_);
+	const Song& song = mod_->getSong(curSongNum_);
 	for (auto& attrib : songStyle_.trackAttribs) {
 		auto& step = song.getTrack(attrib.number)
 					 .getPatternFromOrderNumber(playOrderNum_).getStep(playStepNum_);
@@ -1230,7 +1314,7 @@ void BambooTracker::readStep()
 				isNextSet |= readFMStep(step, attrib.channelInSource);
 			}
 			else {		// Note delay
-				ntDlyCntFM_[attrib.channelInSource] = step.getEffectValue(nd);
+				ntDlyCnt_[attrib.number] = step.getEffectValue(nd);
 				for (int i = 0; i < 4; ++i)
 					isNextSet |= readFMSpecialEffect(attrib.channelInSource, step.getEffectID(i), step.getEffectValue(i));
 				readTickFMForNoteDelay(step, attrib.channelInSource);
@@ -1245,7 +1329,7 @@ void BambooTracker::readStep()
 				isNextSet |= readSSGStep(step, attrib.channelInSource);
 			}
 			else {		// Note delay
-				ntDlyCntSSG_[attrib.channelInSource] = step.getEffectValue(nd);
+				ntDlyCnt_[attrib.number] = step.getEffectValue(nd);
 				for (int i = 0; i < 4; ++i)
 					isNextSet |= readSSGSpecialEffect(attrib.channelInSource, step.getEffectID(i), step.getEffectValue(i));
 			}
@@ -1258,7 +1342,7 @@ void BambooTracker::readStep()
 				isNextSet |= readDrumStep(step, attrib.channelInSource);
 			}
 			else {		// Note delay
-				ntDlyCntDrum_[attrib.channelInSource] = step.getEffectValue(nd);
+				ntDlyCnt_[attrib.number] = step.getEffectValue(nd);
 				for (int i = 0; i < 4; ++i)
 					isNextSet |= readDrumSpecialEffect(attrib.channelInSource, step.getEffectID(i), step.getEffectValue(i));
 			}
@@ -1270,7 +1354,7 @@ void BambooTracker::readStep()
 	isFindNextStep_ = isNextSet;
 }
 
-bool BambooTracker::readFMStep(Step& step, int ch, bool isSkippedSpecial)
+bool BambooTracker::readFMStep(const Step& step, int ch, bool isSkippedSpecial)
 {
 	bool isNextSet = false;
 
@@ -1322,7 +1406,7 @@ bool BambooTracker::readFMStep(Step& step, int ch, bool isSkippedSpecial)
 	return isNextSet;
 }
 
-bool BambooTracker::readSSGStep(Step& step, int ch, bool isSkippedSpecial)
+bool BambooTracker::readSSGStep(const Step& step, int ch, bool isSkippedSpecial)
 {
 	bool isNextSet = false;
 
@@ -1374,7 +1458,7 @@ bool BambooTracker::readSSGStep(Step& step, int ch, bool isSkippedSpecial)
 	return isNextSet;
 }
 
-bool BambooTracker::readDrumStep(Step& step, int ch, bool isSkippedSpecial)
+bool BambooTracker::readDrumStep(const Step& step, int ch, bool isSkippedSpecial)
 {
 	bool isNextSet = false;
 
@@ -1575,18 +1659,18 @@ bool BambooTracker::readFMSpecialEffect(int ch, std::string id, int value)
 		ret = effPatternBreak(value);
 	}
 	else if (id == "0S") {	// Note cut
-		ntCutDlyCntFM_[ch] = value;
+		ntCutDlyCnt_[trackNumFM_[ch]] = value;
 	}
 	else if (id == "0T") {	// Transpose delay
-		tposeDlyCntFM_[ch] = (value & 0x70) >> 4;
-		tposeDlyValueFM_[ch] = ((value & 0x80) ? -1 : 1) * (value & 0x0f);
+		tposeDlyCnt_[trackNumFM_[ch]] = (value & 0x70) >> 4;
+		tposeDlyValue_[trackNumFM_[ch]] = ((value & 0x80) ? -1 : 1) * (value & 0x0f);
 	}
 	else if (id.front() == 'M') {	// Volume delay
 		int count = ctohex(*(id.begin() + 1));
 		if (value != -1) {
 			if (count > 0) {
-				volDlyCntFM_[ch] = count;
-				volDlyValueFM_[ch] = value;
+				volDlyCnt_[trackNumFM_[ch]] = count;
+				volDlyValue_[trackNumFM_[ch]] = value;
 			}
 		}
 	}
@@ -1611,18 +1695,18 @@ bool BambooTracker::readSSGSpecialEffect(int ch, std::string id, int value)
 		ret = effPatternBreak(value);
 	}
 	else if (id == "0S") {	// Note cut
-		ntCutDlyCntSSG_[ch] = value;
+		ntCutDlyCnt_[trackNumSSG_[ch]] = value;
 	}
 	else if (id == "0T") {	// Transpose delay
-		tposeDlyCntSSG_[ch] = (value & 0x70) >> 4;
-		tposeDlyValueSSG_[ch] = ((value & 0x80) ? -1 : 1) * (value & 0x0f);
+		tposeDlyCnt_[trackNumSSG_[ch]] = (value & 0x70) >> 4;
+		tposeDlyValue_[trackNumSSG_[ch]] = ((value & 0x80) ? -1 : 1) * (value & 0x0f);
 	}
 	else if (id.front() == 'M') {	// Volume delay
 		int count = ctohex(*(id.begin() + 1));
 		if (0 <= value && value < 0x10) {
 			if (count > 0) {
-				volDlyCntSSG_[ch] = count;
-				volDlyValueSSG_[ch] = value;
+				volDlyCnt_[trackNumSSG_[ch]] = count;
+				volDlyValue_[trackNumSSG_[ch]] = value;
 			}
 		}
 	}
@@ -1647,14 +1731,14 @@ bool BambooTracker::readDrumSpecialEffect(int ch, std::string id, int value)
 		ret = effPatternBreak(value);
 	}
 	else if (id == "0S") {	// Note cut
-		ntCutDlyCntDrum_[ch] = value;
+		ntCutDlyCnt_[trackNumDrum_[ch]] = value;
 	}
 	else if (id.front() == 'M') {	// Volume delay
 		int count = ctohex(*(id.begin() + 1));
 		if (0 <= value && value < 0x20) {
 			if (count > 0) {
-				volDlyCntDrum_[ch] = count;
-				volDlyValueDrum_[ch] = value;
+				volDlyCnt_[trackNumDrum_[ch]] = count;
+				volDlyValue_[trackNumDrum_[ch]] = value;
 			}
 		}
 	}
@@ -1712,15 +1796,17 @@ void BambooTracker::effGrooveChange(int num)
 	tickCounter_.setGrooveEnebled(true);
 }
 
-void BambooTracker::getStreamSamples(int16_t *container, size_t nSamples)
+void BambooTracker::getStreamSamples(float *container, size_t nSamples)
 {
 	opnaCtrl_->getStreamSamples(container, nSamples);
+	previewer_->mix(container, nSamples);
 }
 
 void BambooTracker::killSound()
 {
 	jamMan_->clear(songStyle_.type);
 	opnaCtrl_->reset();
+	previewer_->stop();
 }
 
 /********** Stream details **********/
@@ -1732,6 +1818,7 @@ int BambooTracker::getStreamRate() const
 void BambooTracker::setStreamRate(int rate)
 {
 	opnaCtrl_->setRate(rate);
+	previewer_->setRate(rate);
 }
 
 int BambooTracker::getStreamDuration() const
@@ -1744,6 +1831,11 @@ void BambooTracker::setStreamDuration(int duration)
 	opnaCtrl_->setDuration(duration);
 }
 
+void BambooTracker::setOutputMonitor(std::shared_ptr<chip::OutputMonitor> monitor)
+{
+	opnaCtrl_->setOutputMonitor(monitor);
+}
+
 /********** Module details **********/
 /*----- Module -----*/
 void BambooTracker::makeNewModule()
@@ -1755,8 +1847,12 @@ void BambooTracker::makeNewModule()
 	opnaCtrl_->reset();
 
 	mod_ = std::make_shared<Module>();
+	saveCache_.clear();
 
 	tickCounter_.setInterruptRate(mod_->getTickFrequency());
+	previewer_->stop();
+	previewer_->clearCache();
+	previewer_->setTickFrequency(static_cast<int>(mod_->getTickFrequency()));
 
 	setCurrentSongNumber(0);
 	curInstNum_ = -1;
@@ -1769,14 +1865,20 @@ bool BambooTracker::loadModule(std::string path)
 	makeNewModule();
 	bool ret = FileIO::loadModuel(path, mod_, instMan_);
 	tickCounter_.setInterruptRate(mod_->getTickFrequency());
+	previewer_->setTickFrequency(static_cast<int>(mod_->getTickFrequency()));
 	setCurrentSongNumber(0);
 	clearCommandHistory();
 	return ret;
 }
 
-bool BambooTracker::saveModule(std::string path)
+bool BambooTracker::saveModule(std::string path, int compressionLevel)
+{
+	return FileIO::saveModule(path, mod_, instMan_, &saveCache_, compressionLevel);
+}
+
+void BambooTracker::clearModuleSaveCache()
 {
-	return FileIO::saveModule(path, mod_, instMan_);
+	saveCache_.clear();
 }
 
 void BambooTracker::setModulePath(std::string path)
@@ -1833,6 +1935,7 @@ void BambooTracker::setModuleTickFrequency(unsigned int freq)
 {
 	mod_->setTickFrequency(freq);
 	tickCounter_.setInterruptRate(freq);
+	previewer_->setTickFrequency(static_cast<int>(freq));
 }
 
 unsigned int BambooTracker::getModuleTickFrequency() const
@@ -2035,8 +2138,8 @@ bool BambooTracker::canAddNewOrder(int songNum) const
 /*----- Pattern -----*/
 int BambooTracker::getStepNoteNumber(int songNum, int trackNum, int orderNum, int stepNum) const
 {
-	return mod_->getSong(songNum).getTrack(trackNum).getPatternFromOrderNumber(orderNum)
-			.getStep(stepNum).getNoteNumber();
+	const Song& song = mod_->getSong(songNum);
+	return song.getTrack(trackNum).getPatternFromOrderNumber(orderNum).getStep(stepNum).getNoteNumber();
 }
 
 void BambooTracker::setStepNote(int songNum, int trackNum, int orderNum, int stepNum, int octave, Note note)
@@ -2071,8 +2174,8 @@ void BambooTracker::eraseStepNote(int songNum, int trackNum, int orderNum, int s
 
 int BambooTracker::getStepInstrument(int songNum, int trackNum, int orderNum, int stepNum) const
 {
-	return mod_->getSong(songNum).getTrack(trackNum).getPatternFromOrderNumber(orderNum)
-			.getStep(stepNum).getInstrumentNumber();
+	const Song& song = mod_->getSong(songNum);
+	return song.getTrack(trackNum).getPatternFromOrderNumber(orderNum).getStep(stepNum).getInstrumentNumber();
 }
 
 void BambooTracker::setStepInstrument(int songNum, int trackNum, int orderNum, int stepNum, int instNum)
@@ -2087,8 +2190,8 @@ void BambooTracker::eraseStepInstrument(int songNum, int trackNum, int orderNum,
 
 int BambooTracker::getStepVolume(int songNum, int trackNum, int orderNum, int stepNum) const
 {
-	return mod_->getSong(songNum).getTrack(trackNum).getPatternFromOrderNumber(orderNum)
-			.getStep(stepNum).getVolume();
+	const Song& song = mod_->getSong(songNum);
+	return song.getTrack(trackNum).getPatternFromOrderNumber(orderNum).getStep(stepNum).getVolume();
 }
 
 void BambooTracker::setStepVolume(int songNum, int trackNum, int orderNum, int stepNum, int volume)
@@ -2103,8 +2206,8 @@ void BambooTracker::eraseStepVolume(int songNum, int trackNum, int orderNum, int
 
 std::string BambooTracker::getStepEffectID(int songNum, int trackNum, int orderNum, int stepNum, int n) const
 {
-	return mod_->getSong(songNum).getTrack(trackNum).getPatternFromOrderNumber(orderNum)
-			.getStep(stepNum).getEffectID(n);
+	const Song& song = mod_->getSong(songNum);
+	return song.getTrack(trackNum).getPatternFromOrderNumber(orderNum).getStep(stepNum).getEffectID(n);
 }
 
 void BambooTracker::setStepEffectID(int songNum, int trackNum, int orderNum, int stepNum, int n, std::string id)
@@ -2114,8 +2217,8 @@ void BambooTracker::setStepEffectID(int songNum, int trackNum, int orderNum, int
 
 int BambooTracker::getStepEffectValue(int songNum, int trackNum, int orderNum, int stepNum, int n) const
 {
-	return mod_->getSong(songNum).getTrack(trackNum).getPatternFromOrderNumber(orderNum)
-			.getStep(stepNum).getEffectValue(n);
+	const Song& song = mod_->getSong(songNum);
+	return song.getTrack(trackNum).getPatternFromOrderNumber(orderNum).getStep(stepNum).getEffectValue(n);
 }
 
 void BambooTracker::setStepEffectValue(int songNum, int trackNum, int orderNum, int stepNum, int n, int value)
@@ -2265,12 +2368,13 @@ void BambooTracker::replaceInstrumentInPattern(int songNum, int beginTrack, int
 size_t BambooTracker::getPatternSizeFromOrderNumber(int songNum, int orderNum) const
 {
 	size_t size = 0;
+	const Song& song = mod_->getSong(songNum);
 	for (auto& t : songStyle_.trackAttribs) {
 		size = (!size)
-			   ? mod_->getSong(songNum).getTrack(t.number).getPatternFromOrderNumber(orderNum).getSize()
+			   ? song.getTrack(t.number).getPatternFromOrderNumber(orderNum).getSize()
 			   : std::min(
 					 size,
-					 mod_->getSong(songNum).getTrack(t.number).getPatternFromOrderNumber(orderNum).getSize()
+					 song.getTrack(t.number).getPatternFromOrderNumber(orderNum).getSize()
 					 );
 	}
 	return size;
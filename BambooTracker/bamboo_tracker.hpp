@@ -5,16 +5,20 @@
 #include <memory>
 #include <vector>
 #include <functional>
+#include <future>
 #include "configuration.hpp"
 #include "opna_controller.hpp"
+#include "instrument_previewer.hpp"
 #include "jam_manager.hpp"
 #include "command_manager.hpp"
 #include "instruments_manager.hpp"
 #include "instrument.hpp"
 #include "tick_counter.hpp"
 #include "module.hpp"
+#include "module_save_cache.hpp"
 #include "song.hpp"
 #include "gd3_tag.hpp"
+#include "wave_sample_format.hpp"
 #include "misc.hpp"
 
 class BambooTracker
@@ -158,6 +162,10 @@ public:
 	void undo();
 	void redo();
 	void clearCommandHistory();
+	/// False when old commands are removed by the memory limit even if the GUI history has them
+	bool canUndo() const;
+	/// Approximate bytes held by the undo and redo history
+	size_t getCommandHistoryMemorySize() const;
 
 	// Jam mode
 	void toggleJamMode();
@@ -165,6 +173,16 @@ public:
 	void jamKeyOn(JamKey key);
 	void jamKeyOff(JamKey key);
 
+	// Instrument preview
+	/// Play the audition clip of the instrument on the preview chip apart from jam mode.
+	/// The clip is rendered on a worker thread and played after that if it is not cached
+	void previewInstrument(int instNum, JamKey key);
+	void stopInstrumentPreview();
+	/// Return nullptr after queueing the rendering if the clip is not cached
+	std::shared_ptr<const PreviewClip> getInstrumentPreviewClip(int instNum, JamKey key);
+	/// Called on the worker thread with the instrument number when a clip is rendered
+	void setInstrumentPreviewRenderedCallback(std::function<void(int)> f);
+
 	// Play song
 	void startPlaySong();
 	void startPlayFromStart();
@@ -180,15 +198,22 @@ public:
 	int getPlayingStepNumber() const;
 
 	// Export
-	bool exportToWav(std::string file, int loopCnt, std::function<bool()> f);
+	bool exportToWav(std::string file, int loopCnt, WaveSampleFormat format, std::function<bool()> f);
 	bool exportToVgm(std::string file, bool gd3TagEnabled, GD3Tag tag, std::function<bool()> f);
 
 	// Backup
 	bool backupModule(std::string file);
+	/// Save the module on a worker thread without changing the module path.
+	/// Return false if the previous autosave is still running
+	bool autosaveModule(std::string file);
+	bool isAutosaving() const;
+	/// Return true once after an autosave finishes, and set whether it succeeded.
+	/// If isWaited is true, wait for the running autosave
+	bool takeAutosaveResult(bool& isSucceeded, bool isWaited = false);
 
 	// Stream events
 	int streamCountUp();
-	void getStreamSamples(int16_t *container, size_t nSamples);
+	void getStreamSamples(float *container, size_t nSamples);
 	void killSound();
 
 	// Stream details
@@ -196,12 +221,16 @@ public:
 	void setStreamRate(int rate);
 	int getStreamDuration() const;
 	void setStreamDuration(int duration);
+	void setOutputMonitor(std::shared_ptr<chip::OutputMonitor> monitor);
 
 	// Module details
 	/*----- Module -----*/
 	void makeNewModule();
 	bool loadModule(std::string path);
-	bool saveModule(std::string path);
+	/// compressionLevel: 0 (uncompressed), 1 (fastest) - 9 (smallest)
+	bool saveModule(std::string path, int compressionLevel = 0);
+	/// Encode all patterns again at the next save
+	void clearModuleSaveCache();
 	void setModulePath(std::string path);
 	std::string getModulePath() const;
 	void setModuleTitle(std::string title);
@@ -313,10 +342,13 @@ private:
 	std::shared_ptr<InstrumentsManager> instMan_;
 	std::unique_ptr<JamManager> jamMan_;
 	std::unique_ptr<OPNAController> opnaCtrl_;
+	std::unique_ptr<InstrumentPreviewer> previewer_;
 
     TickCounter tickCounter_;
 
 	std::shared_ptr<Module> mod_;
+	ModuleSaveCache saveCache_;
+	std::future<bool> autosave_;
 
 	// Current status
 	int octave_;	// 0-7
@@ -348,14 +380,14 @@ private:
 	void readStep();
 	void readTick(int rest);
 
-	void readTickFMForNoteDelay(Step& step, int ch);
-	void envelopeResetEffectFM(Step& step, int ch);
+	void readTickFMForNoteDelay(const Step& step, int ch);
+	void envelopeResetEffectFM(const Step& step, int ch);
 
 	void clearDelayCounts();
 
-	bool readFMStep(Step& step, int ch, bool isSkippedSpecial = false);
-	bool readSSGStep(Step& step, int ch, bool isSkippedSpecial = false);
-	bool readDrumStep(Step& step, int ch, bool isSkippedSpecial = false);
+	bool readFMStep(const Step& step, int ch, bool isSkippedSpecial = false);
+	bool readSSGStep(const Step& step, int ch, bool isSkippedSpecial = false);
+	bool readDrumStep(const Step& step, int ch, bool isSkippedSpecial = false);
 
 	bool readFMEffect(int ch, std::string id, int value, bool isSkippedSpecial = false);
 	bool readSSGEffect(int ch, std::string id, int value, bool isSkippedSpecial = false);
@@ -370,10 +402,15 @@ private:
 	void effSpeedChange(int speed);
 	void effTempoChange(int tempo);
 	void effGrooveChange(int num);
-	std::vector<int> ntDlyCntFM_, ntCutDlyCntFM_, volDlyCntFM_;
-	std::vector<int> ntDlyCntSSG_, ntCutDlyCntSSG_, volDlyCntSSG_;
-	std::vector<int> ntDlyCntDrum_, ntCutDlyCntDrum_, volDlyCntDrum_;
-	std::vector<int> volDlyValueFM_, volDlyValueSSG_, volDlyValueDrum_;
-	std::vector<int> tposeDlyCntFM_, tposeDlyCntSSG_;
-	std::vector<int> tposeDlyValueFM_, tposeDlyValueSSG_;
+
+	// Delay effects
+	/// Counters and values of all tracks in struct-of-arrays, indexed by track number
+	///		Counter -1: not set
+	std::vector<int> ntDlyCnt_, ntCutDlyCnt_, volDlyCnt_, tposeDlyCnt_;
+	std::vector<int> volDlyValue_, tposeDlyValue_;
+	/// Track number of each channel in sound source
+	std::vector<int> trackNumFM_, trackNumSSG_, trackNumDrum_;
+
+	/// Return bit flags of tracks which have delay events in this tick
+	uint32_t countDownDelays();
 };
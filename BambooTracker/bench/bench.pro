@@ -0,0 +1,10 @@
+TEMPLATE = subdirs
+
+SUBDIRS = \
+    bt-bench \
+    bt-render
+
+bt-bench.file = bt-bench.pro
+bt-render.file = bt-render.pro
+bt-bench.makefile = Makefile.bt-bench
+bt-render.makefile = Makefile.bt-render
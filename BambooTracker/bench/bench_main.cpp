@@ -0,0 +1,528 @@
+// Microbenchmarks of the core (chips, resamplers, sequencer, file I/O and offline rendering).
+// Results are written as JSON so that they can be compared between builds.
+//
+// Usage: bt-bench [--filter <substring>] [--repeat <count>] [--out <file>] [--tmp <directory>]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bamboo_tracker.hpp"
+#include "configuration.hpp"
+#include "version.hpp"
+#include "chips/chip_misc.h"
+#include "chips/resampler.hpp"
+#include "chips/output_monitor.hpp"
+#include "instrument_library.hpp"
+#include "synthetic_module.hpp"
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+extern "C"
+{
+#include "chips/mame/2608intf.h"
+}
+
+namespace
+{
+	const int CHIP_CLOCK_ = 3993600 * 2;
+	const int FM_RATE_ = CHIP_CLOCK_ / 72;		// 110933
+	const int SSG_RATE_ = CHIP_CLOCK_ / 4 / 8;	// 249600
+	const int STREAM_RATE_ = 44100;
+	const int STREAM_DURATION_ = 40;
+
+	struct Options
+	{
+		std::string filter;
+		int repeat = 10;
+		std::string out;
+		std::string tmp = ".";
+	};
+
+	struct Result
+	{
+		std::string name;
+		std::string unit;
+		uint64_t itemsPerRun;
+		std::vector<double> runNs;
+	};
+
+	/// A benchmark returns item count processed in one run.
+	/// Only the run is timed, setup is done before it is called
+	struct Benchmark
+	{
+		std::string name;
+		std::string unit;
+		std::function<std::function<uint64_t()>()> setup;
+	};
+
+	Result runBenchmark(const Benchmark& bm, int repeat)
+	{
+		std::function<uint64_t()> run = bm.setup();
+
+		Result res;
+		res.name = bm.name;
+		res.unit = bm.unit;
+		res.itemsPerRun = run();	// Warm up
+		for (int i = 0; i < repeat; ++i) {
+			auto begin = std::chrono::steady_clock::now();
+			run();
+			auto end = std::chrono::steady_clock::now();
+			res.runNs.push_back(std::chrono::duration<double, std::nano>(end - begin).count());
+		}
+		return res;
+	}
+
+	std::string toJson(const std::vector<Result>& results)
+	{
+		std::ostringstream ss;
+		ss.setf(std::ios::fixed);
+		ss.precision(1);
+		ss << "{\n\t\"version\": \"" << Version::ofApplicationInString() << "\",\n\t\"benchmarks\": [";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const Result& res = results[i];
+			std::vector<double> ns = res.runNs;
+			std::sort(ns.begin(), ns.end());
+			double sum = 0;
+			for (double v : ns) sum += v;
+			double mean = sum / ns.size();
+			double median = (ns.size() & 1) ? ns[ns.size() / 2]
+											 : (ns[ns.size() / 2 - 1] + ns[ns.size() / 2]) / 2;
+			double nsPerItem = res.itemsPerRun ? median / res.itemsPerRun : 0.;
+
+			ss << (i ? "," : "") << "\n\t\t{\"name\": \"" << res.name << "\""
+			   << ", \"unit\": \"" << res.unit << "\""
+			   << ", \"items_per_run\": " << res.itemsPerRun
+			   << ", \"runs\": " << ns.size()
+			   << ", \"min_ns\": " << ns.front()
+			   << ", \"median_ns\": " << median
+			   << ", \"mean_ns\": " << mean
+			   << ", \"max_ns\": " << ns.back();
+			ss.precision(3);
+			ss << ", \"ns_per_item\": " << nsPerItem;
+			// CPU usage of realtime playback
+			if (res.unit == "audio_second") ss << ", \"cpu_percent\": " << nsPerItem / 1e7;
+			ss << "}";
+			ss.precision(1);
+		}
+		ss << "\n\t]\n}\n";
+		return ss.str();
+	}
+
+	std::shared_ptr<Configuration> makeConfiguration()
+	{
+		auto config = std::make_shared<Configuration>();
+		config->setSampleRate(STREAM_RATE_);
+		config->setBufferLength(STREAM_DURATION_);
+		return config;
+	}
+
+	/********** Chips **********/
+	/// Set all FM channels to play sustained notes with different algorithms
+	void setFMNotes(UINT8 id)
+	{
+		auto write = [id](int port, UINT8 addr, UINT8 data) {
+			ym2608_w(id, static_cast<offs_t>(port << 1), addr);
+			ym2608_w(id, static_cast<offs_t>((port << 1) | 1), data);
+		};
+		write(0, 0x29, 0x80);	// Enable FM4-6
+		for (int ch = 0; ch < 6; ++ch) {
+			int port = ch / 3;
+			UINT8 c = static_cast<UINT8>(ch % 3);
+			for (UINT8 op = 0; op < 4; ++op) {
+				UINT8 ofs = static_cast<UINT8>(c + op * 4);
+				write(port, 0x30 + ofs, static_cast<UINT8>(0x01 + op));	// DT/ML
+				write(port, 0x40 + ofs, static_cast<UINT8>(op == 3 ? 0 : 20));	// TL
+				write(port, 0x50 + ofs, 0x1f);	// KS/AR
+				write(port, 0x60 + ofs, 0x05);	// AM/DR
+				write(port, 0x70 + ofs, 0x02);	// SR
+				write(port, 0x80 + ofs, 0x27);	// SL/RR
+			}
+			write(port, 0xb0 + c, static_cast<UINT8>((5 << 3) | ch));	// FB/AL: algorithm 0-5
+			write(port, 0xb4 + c, 0xc0);	// Pan
+			write(port, 0xa4 + c, static_cast<UINT8>(0x20 + ch));	// Block/F-num 2
+			write(port, 0xa0 + c, 0x6a);	// F-num 1
+			write(0, 0x28, static_cast<UINT8>(0xf0 | (port << 2) | c));	// Key on
+		}
+	}
+
+	std::function<uint64_t()> setupFMUpdate()
+	{
+		auto id = std::make_shared<UINT8>(0);
+		int ssgRate;
+		ym2608_set_ay_emu_core(0);
+		device_start_ym2608(*id, CHIP_CLOCK_, 0, 0, &ssgRate);
+		device_reset_ym2608(*id);
+		setFMNotes(*id);
+
+		auto bufs = std::make_shared<std::vector<stream_sample_t>>(chip::SMPL_CHUNK_SIZE_ * 2);
+		// Stop the chip when the run function is released
+		std::shared_ptr<void> guard(nullptr, [id](void*) { device_stop_ym2608(*id); });
+		return [id, bufs, guard]() -> uint64_t {
+			stream_sample_t* out[2] = { bufs->data(), bufs->data() + chip::SMPL_CHUNK_SIZE_ };
+			for (int rest = FM_RATE_; rest > 0; rest -= static_cast<int>(chip::SMPL_CHUNK_SIZE_)) {
+				ym2608_stream_update(*id, out, std::min(rest, static_cast<int>(chip::SMPL_CHUNK_SIZE_)));
+			}
+			return static_cast<uint64_t>(FM_RATE_);	// 1 second
+		};
+	}
+
+	std::function<uint64_t()> setupPSGCalc()
+	{
+		std::shared_ptr<PSG> psg(PSG_new(CHIP_CLOCK_ / 4, SSG_RATE_), PSG_delete);
+		PSG_setVolumeMode(psg.get(), 1);
+		PSG_reset(psg.get());
+		const e_uint32 regs[][2] = {
+			{ 0, 0xfe }, { 1, 0x00 }, { 2, 0x7f }, { 3, 0x01 }, { 4, 0x3c }, { 5, 0x02 },
+			{ 6, 0x0c }, { 7, 0x30 }, { 8, 0x0f }, { 9, 0x10 }, { 10, 0x0a },
+			{ 11, 0x40 }, { 12, 0x00 }, { 13, 0x0e }
+		};
+		for (auto& r : regs) PSG_writeReg(psg.get(), r[0], r[1]);
+
+		auto bufs = std::make_shared<std::vector<e_int32>>(chip::SMPL_CHUNK_SIZE_ * 2);
+		return [psg, bufs]() -> uint64_t {
+			e_int32* out[2] = { bufs->data(), bufs->data() + chip::SMPL_CHUNK_SIZE_ };
+			for (int rest = SSG_RATE_; rest > 0; rest -= static_cast<int>(chip::SMPL_CHUNK_SIZE_)) {
+				PSG_calc_stereo(psg.get(), out, std::min(rest, static_cast<int>(chip::SMPL_CHUNK_SIZE_)));
+			}
+			return static_cast<uint64_t>(SSG_RATE_);	// 1 second
+		};
+	}
+
+	/// Record a second of channel outputs picked by the chip at the default decimation
+	std::function<uint64_t()> setupOutputMonitor()
+	{
+		auto monitor = std::make_shared<chip::OutputMonitor>();
+		const size_t blockSize = STREAM_RATE_ * STREAM_DURATION_ / 1000;
+		const size_t count = blockSize / monitor->getDecimation();
+		auto src = std::make_shared<std::vector<float>>(count * chip::MonitorFrame::CHANNEL_COUNT);
+		for (size_t i = 0; i < src->size(); ++i)
+			(*src)[i] = static_cast<float>((i * 613) % 32768) / 65536.0f - 0.25f;
+		return [monitor, src, blockSize, count]() -> uint64_t {
+			const float* channels[chip::MonitorFrame::CHANNEL_COUNT];
+			for (int ch = 0; ch < chip::MonitorFrame::CHANNEL_COUNT; ++ch)
+				channels[ch] = src->data() + count * static_cast<size_t>(ch);
+			for (size_t rest = STREAM_RATE_; rest >= blockSize; rest -= blockSize)
+				monitor->recordDecimatedSamples(channels, count, blockSize);
+			return 1;	// 1 second
+		};
+	}
+
+	/********** Resamplers **********/
+	template <class T>
+	std::function<uint64_t()> setupResampler(int srcRate)
+	{
+		auto rsmp = std::make_shared<T>();
+		rsmp->init(srcRate, STREAM_RATE_, STREAM_DURATION_);
+		size_t intrSize = rsmp->calculateInternalSampleSize(chip::SMPL_CHUNK_SIZE_);
+
+		// Deterministic saw waves
+		auto src = std::make_shared<std::vector<sample>>((intrSize + 1) * 2);
+		for (size_t i = 0; i < src->size(); ++i)
+			(*src)[i] = static_cast<sample>((i * 613) % 32768) - 16384;
+
+		return [rsmp, src, intrSize]() -> uint64_t {
+			sample* in[2] = { src->data(), src->data() + intrSize + 1 };
+			volatile sample sink = 0;
+			for (int rest = STREAM_RATE_; rest > 0; rest -= static_cast<int>(chip::SMPL_CHUNK_SIZE_)) {
+				size_t n = std::min(static_cast<size_t>(rest), chip::SMPL_CHUNK_SIZE_);
+				sample** out = rsmp->interpolate(in, n, rsmp->calculateInternalSampleSize(n));
+				sink = out[0][0];
+			}
+			static_cast<void>(sink);
+			return static_cast<uint64_t>(STREAM_RATE_);	// 1 second
+		};
+	}
+
+	/********** Sequencer **********/
+	std::function<uint64_t()> setupStreamCountUp()
+	{
+		auto bt = std::make_shared<BambooTracker>(makeConfiguration());
+		makeSyntheticModule(*bt, 16);
+		const uint64_t tickCount = 10000;
+		return [bt, tickCount]() -> uint64_t {
+			bt->startPlayFromStart();
+			for (uint64_t i = 0; i < tickCount; ++i) bt->streamCountUp();
+			bt->stopPlaySong();
+			return tickCount;
+		};
+	}
+
+	/// Play seconds of audio at the tick rate in the same way as the stream mixer.
+	/// The chip is not rendered if isRendered is false, to measure the sequencer alone
+	std::function<uint64_t()> setupTickRate(unsigned int tickFreq, bool isRendered, bool isMonitored = false)
+	{
+		auto bt = std::make_shared<BambooTracker>(makeConfiguration());
+		makeSyntheticModule(*bt, 16);
+		bt->setModuleTickFrequency(tickFreq);
+		if (isMonitored) bt->setOutputMonitor(std::make_shared<chip::OutputMonitor>());
+		const size_t bufSize = STREAM_RATE_ * STREAM_DURATION_ / 1000;
+		auto buf = std::make_shared<std::vector<float>>(bufSize << 1);
+		return [bt, tickFreq, isRendered, buf, bufSize]() -> uint64_t {
+			const uint64_t seconds = 4;
+			size_t intrCnt = STREAM_RATE_ / tickFreq;
+			size_t intrCntFrac = STREAM_RATE_ % tickFreq;
+			size_t intrCntFracSum = 0;
+			size_t intrCntRest = 0;
+			bt->startPlayFromStart();
+			for (size_t rest = STREAM_RATE_ * seconds; rest; ) {
+				size_t required = std::min(bufSize, rest);
+				rest -= required;
+				float* dest = buf->data();
+				while (required) {
+					if (!intrCntRest) {	// Interruption
+						intrCntRest = intrCnt;
+						intrCntFracSum += intrCntFrac;
+						if (intrCntFracSum >= tickFreq) {
+							intrCntFracSum -= tickFreq;
+							++intrCntRest;
+						}
+						bt->streamCountUp();
+					}
+					size_t count = std::min(intrCntRest, required);
+					required -= count;
+					intrCntRest -= count;
+					if (isRendered) bt->getStreamSamples(dest, count);
+					dest += (count << 1);
+				}
+			}
+			bt->stopPlaySong();
+			return seconds;
+		};
+	}
+
+	/********** Module **********/
+	/// Query unused instruments after each step edit
+	std::function<uint64_t()> setupUnusedInstruments()
+	{
+		auto bt = std::make_shared<BambooTracker>(makeConfiguration());
+		makeSyntheticModule(*bt, 256);
+		auto order = std::make_shared<int>(0);
+		return [bt, order]() -> uint64_t {
+			const int queryCount = 100;
+			for (int i = 0; i < queryCount; ++i) {
+				bt->setStepInstrument(0, 0, *order, 0, i & 1);
+				*order = (*order + 1) % 256;
+				if (bt->getUnusedInstrumentIndices().size() > 3) std::cerr << "Invalid unused instruments" << std::endl;
+			}
+			return queryCount;
+		};
+	}
+
+	/********** File I/O **********/
+	/// If isCached is false, all patterns are encoded at each save as there is no last save
+	std::function<uint64_t()> setupSaveModule(const Options& opt, bool isCached)
+	{
+		auto bt = std::make_shared<BambooTracker>(makeConfiguration());
+		makeSyntheticModule(*bt, 256);
+		std::string path = opt.tmp + "/bt-bench-save.btm";
+		return [bt, path, isCached]() -> uint64_t {
+			if (!isCached) bt->clearModuleSaveCache();
+			if (!bt->saveModule(path)) std::cerr << "Failed to save " << path << std::endl;
+			return 1;
+		};
+	}
+
+	/// One note is edited before each save, so only its pattern is encoded again
+	std::function<uint64_t()> setupSaveEditedModule(const Options& opt)
+	{
+		auto bt = std::make_shared<BambooTracker>(makeConfiguration());
+		makeSyntheticModule(*bt, 256);
+		std::string path = opt.tmp + "/bt-bench-save.btm";
+		bt->saveModule(path);
+		auto cnt = std::make_shared<int>(0);
+		return [bt, path, cnt]() -> uint64_t {
+			int n = (*cnt)++;
+			bt->setStepNote(0, n % 15, (n / 15) % 256, n % 64, 4, Note::C);
+			if (!bt->saveModule(path)) std::cerr << "Failed to save " << path << std::endl;
+			return 1;
+		};
+	}
+
+	std::function<uint64_t()> setupLoadModule(const Options& opt, int compressionLevel)
+	{
+		std::string path = opt.tmp + "/bt-bench-load.btm";
+		{
+			BambooTracker src(makeConfiguration());
+			makeSyntheticModule(src, 256);
+			src.saveModule(path, compressionLevel);
+		}
+		auto bt = std::make_shared<BambooTracker>(makeConfiguration());
+		return [bt, path]() -> uint64_t {
+			if (!bt->loadModule(path)) std::cerr << "Failed to load " << path << std::endl;
+			return 1;
+		};
+	}
+
+	/// Open a module with many songs. Only the first song is shown
+	std::function<uint64_t()> setupOpenModule(const Options& opt, int compressionLevel)
+	{
+		std::string path = opt.tmp + "/bt-bench-open.btm";
+		{
+			BambooTracker src(makeConfiguration());
+			makeSyntheticModule(src, 16, 0, 16);
+			src.saveModule(path, compressionLevel);
+		}
+		auto bt = std::make_shared<BambooTracker>(makeConfiguration());
+		return [bt, path]() -> uint64_t {
+			if (!bt->loadModule(path)) std::cerr << "Failed to load " << path << std::endl;
+			bt->getOrderSize(0);
+			return 1;
+		};
+	}
+
+	/// Save instruments of the synthetic module to files in subdirectories of a new directory
+	std::string makeInstrumentFiles(const Options& opt, int count)
+	{
+		std::string dir = opt.tmp + "/bt-bench-instruments";
+		BambooTracker bt(makeConfiguration());
+		makeSyntheticModule(bt, 1);
+		const int dirCount = 8;
+		for (int d = -1; d < dirCount; ++d) {
+			std::string path = (d == -1) ? dir : dir + "/" + std::to_string(d);
+#ifdef _WIN32
+			_mkdir(path.c_str());
+#else
+			mkdir(path.c_str(), 0755);
+#endif
+		}
+		for (int i = 0; i < count; ++i) {
+			int inst = i % 3;	// FM, FM and SSG
+			bt.setInstrumentName(inst, "Instrument " + std::to_string(i));
+			std::string path = dir + "/" + std::to_string(i % dirCount) + "/" + std::to_string(i) + ".bti";
+			if (!bt.saveInstrument(path, inst)) std::cerr << "Failed to save " << path << std::endl;
+		}
+		return dir;
+	}
+
+	/// Scan files which are not indexed
+	std::function<uint64_t()> setupScanInstrumentLibrary(const Options& opt)
+	{
+		std::string dir = makeInstrumentFiles(opt, 512);
+		return [dir]() -> uint64_t {
+			InstrumentLibrary lib;
+			lib.scanInBackground({ dir });
+			if (lib.waitForScan() != 512) std::cerr << "Invalid instrument library scan" << std::endl;
+			return lib.getEntryCount();
+		};
+	}
+
+	/// Scan indexed files again, all files are only listed
+	std::function<uint64_t()> setupRescanInstrumentLibrary(const Options& opt)
+	{
+		std::string dir = makeInstrumentFiles(opt, 512);
+		auto lib = std::make_shared<InstrumentLibrary>();
+		lib->scanInBackground({ dir });
+		lib->waitForScan();
+		return [lib, dir]() -> uint64_t {
+			lib->scanInBackground({ dir });
+			if (lib->waitForScan()) std::cerr << "Invalid instrument library scan" << std::endl;
+			return lib->getEntryCount();
+		};
+	}
+
+	/********** Rendering **********/
+	std::function<uint64_t()> setupRender(const Options& opt)
+	{
+		auto bt = std::make_shared<BambooTracker>(makeConfiguration());
+		makeSyntheticModule(*bt, 8);
+		std::string path = opt.tmp + "/bt-bench-render.wav";
+		return [bt, path]() -> uint64_t {
+			bt->exportToWav(path, 1, WaveSampleFormat::INT16, [] { return false; });
+			std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+			auto size = static_cast<uint64_t>(ifs.tellg());
+			return (size > 44) ? (size - 44) / 4 : 0;	// Stereo 16-bit frames
+		};
+	}
+
+	bool parseOptions(int argc, char** argv, Options& opt)
+	{
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			bool hasValue = (i + 1 < argc);
+			if (arg == "--filter" && hasValue) opt.filter = argv[++i];
+			else if (arg == "--repeat" && hasValue) opt.repeat = std::max(1, std::atoi(argv[++i]));
+			else if (arg == "--out" && hasValue) opt.out = argv[++i];
+			else if (arg == "--tmp" && hasValue) opt.tmp = argv[++i];
+			else return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	if (!parseOptions(argc, argv, opt)) {
+		std::cerr << "Usage: bt-bench [--filter <substring>] [--repeat <count>]"
+					 " [--out <file>] [--tmp <directory>]" << std::endl;
+		return 2;
+	}
+
+	const std::vector<Benchmark> benchmarks = {
+		{ "chip/ym2608_update_one/110933", "sample", setupFMUpdate },
+		{ "chip/psg_calc_stereo/249600", "sample", setupPSGCalc },
+		{ "chip/output_monitor/record", "audio_second", setupOutputMonitor },
+		{ "resampler/linear/110933-44100", "sample", [] { return setupResampler<chip::LinearResampler>(FM_RATE_); } },
+		{ "resampler/sinc/110933-44100", "sample", [] { return setupResampler<chip::SincResampler>(FM_RATE_); } },
+		{ "resampler/linear/249600-44100", "sample", [] { return setupResampler<chip::LinearResampler>(SSG_RATE_); } },
+		{ "resampler/sinc/249600-44100", "sample", [] { return setupResampler<chip::SincResampler>(SSG_RATE_); } },
+		{ "sequencer/stream_count_up/heavy", "tick", setupStreamCountUp },
+		{ "sequencer/tick_rate/60hz", "audio_second", [] { return setupTickRate(60, false); } },
+		{ "sequencer/tick_rate/240hz", "audio_second", [] { return setupTickRate(240, false); } },
+		{ "sequencer/tick_rate/1000hz", "audio_second", [] { return setupTickRate(1000, false); } },
+		{ "stream/tick_rate/60hz", "audio_second", [] { return setupTickRate(60, true); } },
+		{ "stream/tick_rate/240hz", "audio_second", [] { return setupTickRate(240, true); } },
+		{ "stream/tick_rate/1000hz", "audio_second", [] { return setupTickRate(1000, true); } },
+		{ "stream/output_monitor/60hz", "audio_second", [] { return setupTickRate(60, true, true); } },
+		{ "module/unused_instruments/256_orders", "query", setupUnusedInstruments },
+		{ "io/save_module/256_orders", "file", [&opt] { return setupSaveModule(opt, true); } },
+		{ "io/save_module/256_orders_uncached", "file", [&opt] { return setupSaveModule(opt, false); } },
+		{ "io/save_module/256_orders_after_edit", "file", [&opt] { return setupSaveEditedModule(opt); } },
+		{ "io/load_module/256_orders", "file", [&opt] { return setupLoadModule(opt, 0); } },
+		{ "io/load_module/256_orders_compressed", "file", [&opt] { return setupLoadModule(opt, 9); } },
+		{ "io/open_module/16_songs", "file", [&opt] { return setupOpenModule(opt, 0); } },
+		{ "io/open_module/16_songs_compressed", "file", [&opt] { return setupOpenModule(opt, 9); } },
+		{ "io/instrument_library/scan", "file", [&opt] { return setupScanInstrumentLibrary(opt); } },
+		{ "io/instrument_library/rescan_unchanged", "file", [&opt] { return setupRescanInstrumentLibrary(opt); } },
+		{ "render/export_wav/8_orders", "frame", [&opt] { return setupRender(opt); } }
+	};
+
+	std::vector<Result> results;
+	for (auto& bm : benchmarks) {
+		if (!opt.filter.empty() && bm.name.find(opt.filter) == std::string::npos) continue;
+		std::cerr << bm.name << std::endl;
+		results.push_back(runBenchmark(bm, opt.repeat));
+	}
+
+	for (auto name : { "/bt-bench-save.btm", "/bt-bench-load.btm", "/bt-bench-open.btm", "/bt-bench-render.wav" })
+		std::remove((opt.tmp + name).c_str());
+
+	std::string json = toJson(results);
+	if (opt.out.empty()) {
+		std::cout << json;
+	}
+	else {
+		std::ofstream ofs(opt.out, std::ios::binary);
+		ofs << json;
+		if (!ofs) {
+			std::cerr << "Failed to write " << opt.out << std::endl;
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,14 @@
+#-------------------------------------------------
+#
+# Benchmarks of the core
+#
+#-------------------------------------------------
+
+TARGET = bt-bench
+TEMPLATE = app
+OBJECTS_DIR = obj/bt-bench
+
+include(core.pri)
+
+SOURCES += \
+    bench_main.cpp
@@ -0,0 +1,14 @@
+#-------------------------------------------------
+#
+# Golden render of modules to check output changes
+#
+#-------------------------------------------------
+
+TARGET = bt-render
+TEMPLATE = app
+OBJECTS_DIR = obj/bt-render
+
+include(core.pri)
+
+SOURCES += \
+    render_main.cpp
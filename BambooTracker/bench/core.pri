@@ -0,0 +1,32 @@
+# Core sources of BambooTracker without GUI and audio stream
+
+QT       -= core gui
+CONFIG += console c++14
+CONFIG -= app_bundle qt
+
+CORE_DIR = $$PWD/..
+
+INCLUDEPATH += \
+    $$CORE_DIR \
+    $$CORE_DIR/chips \
+    $$CORE_DIR/command \
+    $$CORE_DIR/instrument \
+    $$CORE_DIR/io \
+    $$CORE_DIR/module \
+    $$PWD
+
+SOURCES += \
+    $$files($$CORE_DIR/*.cpp) \
+    $$files($$CORE_DIR/chips/*.cpp) \
+    $$files($$CORE_DIR/chips/mame/*.c) \
+    $$files($$CORE_DIR/command/*.cpp, true) \
+    $$files($$CORE_DIR/instrument/*.cpp) \
+    $$files($$CORE_DIR/io/*.cpp) \
+    $$files($$CORE_DIR/module/*.cpp) \
+    $$PWD/synthetic_module.cpp
+SOURCES -= $$CORE_DIR/main.cpp
+
+HEADERS += \
+    $$PWD/synthetic_module.hpp
+
+unix: LIBS += -lpthread
@@ -0,0 +1,483 @@
+// Renders modules through the playback path used by WAV and VGM export,
+// and hashes the output to check that changes in the core keep the output identical.
+//
+// Usage: bt-render [options] [module.btm ...]
+//	--out <directory>		Directory to write rendered files (default: current directory)
+//	--reference <directory>	Compare with files rendered before in the directory
+//	--tolerance <lsb>		Allowed PCM deviation in 16-bit LSB (default: 0)
+//	--rate <rate>			Sample rate (default: 44100)
+//	--synthetic <count>		Add generated modules to the corpus
+//	--round-trip <level>	Save each module at the compression level (0-9), reload it
+//							and check that it renders the same output
+//	--clips					Also render preview clips of instruments at C in octave 4
+//	--json <file>			Write the report to the file instead of stdout
+//
+// Exit code is 1 if some output differs from the reference over the tolerance.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "bamboo_tracker.hpp"
+#include "configuration.hpp"
+#include "synthetic_module.hpp"
+
+namespace
+{
+	struct Options
+	{
+		std::string out = ".";
+		std::string reference;
+		double tolerance = 0.;
+		int rate = 44100;
+		int syntheticCount = 0;
+		int roundTripLevel = -1;	// -1: not checked
+		bool isClipRendered = false;
+		std::string json;
+		std::vector<std::string> modules;
+	};
+
+	struct Wave
+	{
+		bool isValid = false;
+		std::vector<char> data;		// Raw data chunk
+		std::vector<double> samples;	// Normalized to [-1, 1]
+	};
+
+	enum class Comparison
+	{
+		NEW, EXACT, DEVIATED, MISMATCH
+	};
+
+	struct Report
+	{
+		std::string name;
+		int song;
+		uint64_t frames;
+		double wavMs, vgmMs;
+		uint64_t pcmHash, vgmHash;
+		Comparison pcm, vgm;
+		double maxDeviation;	// In 16-bit LSB
+		Comparison roundTrip = Comparison::NEW;	// NEW: not checked
+	};
+
+	struct ClipReport
+	{
+		std::string name;
+		int inst;
+		uint64_t frames;
+		uint64_t pcmHash;
+		Comparison pcm;
+		double maxDeviation;	// In 16-bit LSB
+	};
+
+	/// FNV-1a 64
+	uint64_t hash(const std::vector<char>& data)
+	{
+		uint64_t h = 14695981039346656037ull;
+		for (char c : data) {
+			h ^= static_cast<unsigned char>(c);
+			h *= 1099511628211ull;
+		}
+		return h;
+	}
+
+	std::vector<char> readFile(const std::string& path)
+	{
+		std::ifstream ifs(path, std::ios::binary);
+		return std::vector<char>(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+	}
+
+	uint32_t readLE(const char* p, int size)
+	{
+		uint32_t v = 0;
+		for (int i = size - 1; i >= 0; --i) v = (v << 8) | static_cast<unsigned char>(p[i]);
+		return v;
+	}
+
+	Wave readWave(const std::string& path)
+	{
+		Wave wav;
+		std::vector<char> file = readFile(path);
+		if (file.size() < 12 || std::memcmp(file.data(), "RIFF", 4) || std::memcmp(file.data() + 8, "WAVE", 4))
+			return wav;
+
+		uint32_t fmtId = 0, bitSize = 0;
+		for (size_t pos = 12; pos + 8 <= file.size(); ) {
+			const char* chunk = file.data() + pos;
+			size_t size = std::min<size_t>(readLE(chunk + 4, 4), file.size() - pos - 8);
+			if (!std::memcmp(chunk, "fmt ", 4) && size >= 16) {
+				fmtId = readLE(chunk + 8, 2);
+				bitSize = readLE(chunk + 22, 2);
+			}
+			else if (!std::memcmp(chunk, "data", 4)) {
+				wav.data.assign(chunk + 8, chunk + 8 + size);
+			}
+			pos += 8 + size + (size & 1);
+		}
+
+		const char* p = wav.data.data();
+		size_t n = wav.data.size();
+		if (fmtId == 1 && bitSize == 16) {
+			for (size_t i = 0; i + 2 <= n; i += 2)
+				wav.samples.push_back(static_cast<int16_t>(readLE(p + i, 2)) / 32768.);
+		}
+		else if (fmtId == 1 && bitSize == 24) {
+			for (size_t i = 0; i + 3 <= n; i += 3) {
+				int32_t v = static_cast<int32_t>(readLE(p + i, 3) << 8) >> 8;
+				wav.samples.push_back(v / 8388608.);
+			}
+		}
+		else if (fmtId == 3 && bitSize == 32) {
+			for (size_t i = 0; i + 4 <= n; i += 4) {
+				float f;
+				std::memcpy(&f, p + i, 4);
+				wav.samples.push_back(f);
+			}
+		}
+		else {
+			return wav;
+		}
+		wav.isValid = true;
+		return wav;
+	}
+
+	void writeUint(std::ofstream& ofs, uint32_t v, int size)
+	{
+		for (int i = 0; i < size; ++i, v >>= 8) ofs.put(static_cast<char>(v & 0xff));
+	}
+
+	/// Write interleaved stereo samples as 32-bit float
+	void writeWave(const std::string& path, const std::vector<float>& samples, int rate)
+	{
+		std::ofstream ofs(path, std::ios::binary);
+		auto dataSize = static_cast<uint32_t>(samples.size() * 4);
+		ofs.write("RIFF", 4);
+		writeUint(ofs, 36 + dataSize, 4);
+		ofs.write("WAVEfmt ", 8);
+		writeUint(ofs, 16, 4);
+		writeUint(ofs, 3, 2);	// Float
+		writeUint(ofs, 2, 2);
+		writeUint(ofs, static_cast<uint32_t>(rate), 4);
+		writeUint(ofs, static_cast<uint32_t>(rate) * 8, 4);
+		writeUint(ofs, 8, 2);
+		writeUint(ofs, 32, 2);
+		ofs.write("data", 4);
+		writeUint(ofs, dataSize, 4);
+		for (float f : samples) {
+			uint32_t v;
+			std::memcpy(&v, &f, 4);
+			writeUint(ofs, v, 4);
+		}
+	}
+
+	Comparison compareWave(const Wave& cur, const std::string& refPath, double tolerance, double& maxDev)
+	{
+		maxDev = 0.;
+		Wave ref = readWave(refPath);
+		if (!ref.isValid) return Comparison::NEW;
+		if (ref.data == cur.data) return Comparison::EXACT;
+		if (ref.samples.size() != cur.samples.size()) return Comparison::MISMATCH;
+
+		for (size_t i = 0; i < cur.samples.size(); ++i)
+			maxDev = std::max(maxDev, std::abs(cur.samples[i] - ref.samples[i]) * 32768.);
+		return (maxDev <= tolerance) ? Comparison::DEVIATED : Comparison::MISMATCH;
+	}
+
+	Comparison compareFile(const std::vector<char>& cur, const std::string& refPath)
+	{
+		std::ifstream ifs(refPath, std::ios::binary);
+		if (!ifs) return Comparison::NEW;
+		return (readFile(refPath) == cur) ? Comparison::EXACT : Comparison::MISMATCH;
+	}
+
+	const char* toString(Comparison c)
+	{
+		switch (c) {
+		case Comparison::NEW:		return "new";
+		case Comparison::EXACT:		return "exact";
+		case Comparison::DEVIATED:	return "deviated";
+		case Comparison::MISMATCH:	return "mismatch";
+		default:					return "";
+		}
+	}
+
+	std::string getBaseName(const std::string& path)
+	{
+		size_t begin = path.find_last_of("/\\");
+		begin = (begin == std::string::npos) ? 0 : begin + 1;
+		size_t end = path.rfind('.');
+		if (end == std::string::npos || end < begin) end = path.size();
+		return path.substr(begin, end - begin);
+	}
+
+	double measureMs(std::function<void()> f)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		f();
+		auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(end - begin).count();
+	}
+
+	/// Render all songs in the loaded module
+	bool renderModule(BambooTracker& bt, const std::string& name, const Options& opt, std::vector<Report>& reports)
+	{
+		bool isPassed = true;
+		for (int s = 0; s < static_cast<int>(bt.getSongCount()); ++s) {
+			bt.setCurrentSongNumber(s);
+
+			Report rep;
+			rep.name = name;
+			rep.song = s;
+			std::string file = name + "_" + std::to_string(s);
+			std::string wavPath = opt.out + "/" + file + ".wav";
+			std::string vgmPath = opt.out + "/" + file + ".vgm";
+
+			// Float samples keep the mix before quantization
+			rep.wavMs = measureMs([&] {
+				bt.exportToWav(wavPath, 1, WaveSampleFormat::FLOAT32, [] { return false; });
+			});
+			rep.vgmMs = measureMs([&] {
+				bt.exportToVgm(vgmPath, false, GD3Tag(), [] { return false; });
+			});
+
+			Wave wav = readWave(wavPath);
+			std::vector<char> vgm = readFile(vgmPath);
+			rep.frames = wav.samples.size() / 2;
+			rep.pcmHash = hash(wav.data);
+			rep.vgmHash = hash(vgm);
+			rep.maxDeviation = 0.;
+			if (opt.reference.empty()) {
+				rep.pcm = rep.vgm = Comparison::NEW;
+			}
+			else {
+				rep.pcm = compareWave(wav, opt.reference + "/" + file + ".wav", opt.tolerance, rep.maxDeviation);
+				rep.vgm = compareFile(vgm, opt.reference + "/" + file + ".vgm");
+				if (rep.pcm == Comparison::MISMATCH || rep.vgm == Comparison::MISMATCH) isPassed = false;
+			}
+
+			std::cerr << file << ": pcm " << toString(rep.pcm) << ", vgm " << toString(rep.vgm) << std::endl;
+			reports.push_back(rep);
+		}
+		return isPassed;
+	}
+
+	/// Render the preview clip of each instrument on the preview chip
+	bool renderClips(BambooTracker& bt, const std::string& name, const Options& opt,
+					 std::vector<ClipReport>& reports)
+	{
+		std::mutex mutex;
+		std::condition_variable cond;
+		size_t renderedCnt = 0;
+		bt.setInstrumentPreviewRenderedCallback([&](int) {
+			std::lock_guard<std::mutex> lg(mutex);
+			++renderedCnt;
+			cond.notify_all();
+		});
+
+		bool isPassed = true;
+		for (int inst : bt.getInstrumentIndices()) {
+			ClipReport rep;
+			rep.name = name;
+			rep.inst = inst;
+			std::string file = name + "_inst" + std::to_string(inst);
+			std::string wavPath = opt.out + "/" + file + ".wav";
+
+			// The first request queues rendering, and the clip is cached when it is rendered
+			std::shared_ptr<const PreviewClip> clip;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				size_t cnt = renderedCnt;
+				lock.unlock();
+				clip = bt.getInstrumentPreviewClip(inst, JamKey::LOW_C);
+				lock.lock();
+				if (!clip && cond.wait_for(lock, std::chrono::seconds(10), [&] { return renderedCnt != cnt; })) {
+					lock.unlock();
+					clip = bt.getInstrumentPreviewClip(inst, JamKey::LOW_C);
+				}
+			}
+			if (!clip) {
+				std::cerr << file << ": failed to render" << std::endl;
+				isPassed = false;
+				continue;
+			}
+
+			writeWave(wavPath, clip->samples, clip->rate);
+			Wave wav = readWave(wavPath);
+			rep.frames = clip->getFrameCount();
+			rep.pcmHash = hash(wav.data);
+			rep.maxDeviation = 0.;
+			if (opt.reference.empty()) {
+				rep.pcm = Comparison::NEW;
+			}
+			else {
+				rep.pcm = compareWave(wav, opt.reference + "/" + file + ".wav", opt.tolerance, rep.maxDeviation);
+				if (rep.pcm == Comparison::MISMATCH) isPassed = false;
+			}
+
+			std::cerr << file << ": clip " << toString(rep.pcm) << std::endl;
+			reports.push_back(rep);
+		}
+
+		bt.setInstrumentPreviewRenderedCallback(nullptr);
+		return isPassed;
+	}
+
+	/// Save the module, reload and render it, and compare hashes with the reports of the module
+	bool checkRoundTrip(BambooTracker& bt, std::shared_ptr<Configuration> config, const std::string& name,
+						const Options& opt, std::vector<Report>& reports, size_t first)
+	{
+		std::string path = opt.out + "/" + name + "_rt.btm";
+		BambooTracker rt(config);
+		std::vector<Report> rtReports;
+		if (bt.saveModule(path, opt.roundTripLevel) && rt.loadModule(path)) {
+			Options rtOpt = opt;
+			rtOpt.reference.clear();
+			renderModule(rt, name + "_rt", rtOpt, rtReports);
+		}
+		else {
+			std::cerr << "Failed to save and reload " << path << std::endl;
+		}
+
+		bool isPassed = (rtReports.size() == reports.size() - first);
+		for (size_t i = first; i < reports.size(); ++i) {
+			Report& rep = reports[i];
+			bool isSame = isPassed && rtReports[i - first].pcmHash == rep.pcmHash
+						  && rtReports[i - first].vgmHash == rep.vgmHash;
+			rep.roundTrip = isSame ? Comparison::EXACT : Comparison::MISMATCH;
+			isPassed &= isSame;
+			std::cerr << name << "_" << rep.song << ": round trip " << toString(rep.roundTrip) << std::endl;
+		}
+		return isPassed;
+	}
+
+	std::string toJson(const std::vector<Report>& reports, const std::vector<ClipReport>& clipReports,
+					   bool isPassed)
+	{
+		std::ostringstream ss;
+		ss.setf(std::ios::fixed);
+		ss << "{\n\t\"passed\": " << (isPassed ? "true" : "false") << ",\n\t\"renders\": [";
+		for (size_t i = 0; i < reports.size(); ++i) {
+			const Report& rep = reports[i];
+			char pcmHash[17], vgmHash[17];
+			std::snprintf(pcmHash, sizeof(pcmHash), "%016llx", static_cast<unsigned long long>(rep.pcmHash));
+			std::snprintf(vgmHash, sizeof(vgmHash), "%016llx", static_cast<unsigned long long>(rep.vgmHash));
+			ss.precision(1);
+			ss << (i ? "," : "") << "\n\t\t{\"module\": \"" << rep.name << "\""
+			   << ", \"song\": " << rep.song
+			   << ", \"frames\": " << rep.frames
+			   << ", \"wav_ms\": " << rep.wavMs
+			   << ", \"vgm_ms\": " << rep.vgmMs
+			   << ", \"pcm_hash\": \"" << pcmHash << "\""
+			   << ", \"vgm_hash\": \"" << vgmHash << "\""
+			   << ", \"pcm\": \"" << toString(rep.pcm) << "\""
+			   << ", \"vgm\": \"" << toString(rep.vgm) << "\"";
+			ss.precision(3);
+			ss << ", \"max_deviation_lsb\": " << rep.maxDeviation;
+			if (rep.roundTrip != Comparison::NEW) ss << ", \"round_trip\": \"" << toString(rep.roundTrip) << "\"";
+			ss << "}";
+		}
+		ss << "\n\t]";
+		if (!clipReports.empty()) {
+			ss << ",\n\t\"clips\": [";
+			for (size_t i = 0; i < clipReports.size(); ++i) {
+				const ClipReport& rep = clipReports[i];
+				char pcmHash[17];
+				std::snprintf(pcmHash, sizeof(pcmHash), "%016llx", static_cast<unsigned long long>(rep.pcmHash));
+				ss.precision(3);
+				ss << (i ? "," : "") << "\n\t\t{\"module\": \"" << rep.name << "\""
+				   << ", \"instrument\": " << rep.inst
+				   << ", \"frames\": " << rep.frames
+				   << ", \"pcm_hash\": \"" << pcmHash << "\""
+				   << ", \"pcm\": \"" << toString(rep.pcm) << "\""
+				   << ", \"max_deviation_lsb\": " << rep.maxDeviation << "}";
+			}
+			ss << "\n\t]";
+		}
+		ss << "\n}\n";
+		return ss.str();
+	}
+
+	bool parseOptions(int argc, char** argv, Options& opt)
+	{
+		for (int i = 1; i < argc; ++i) {
+			std::string arg = argv[i];
+			bool hasValue = (i + 1 < argc);
+			if (arg == "--out" && hasValue) opt.out = argv[++i];
+			else if (arg == "--reference" && hasValue) opt.reference = argv[++i];
+			else if (arg == "--tolerance" && hasValue) opt.tolerance = std::atof(argv[++i]);
+			else if (arg == "--rate" && hasValue) opt.rate = std::atoi(argv[++i]);
+			else if (arg == "--synthetic" && hasValue) opt.syntheticCount = std::atoi(argv[++i]);
+			else if (arg == "--round-trip" && hasValue) opt.roundTripLevel = std::min(std::max(std::atoi(argv[++i]), 0), 9);
+			else if (arg == "--clips") opt.isClipRendered = true;
+			else if (arg == "--json" && hasValue) opt.json = argv[++i];
+			else if (arg.compare(0, 2, "--")) opt.modules.push_back(arg);
+			else return false;
+		}
+		return (!opt.modules.empty() || opt.syntheticCount > 0);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	if (!parseOptions(argc, argv, opt)) {
+		std::cerr << "Usage: bt-render [--out <directory>] [--reference <directory>] [--tolerance <lsb>]"
+					 " [--rate <rate>] [--synthetic <count>] [--round-trip <level>] [--clips] [--json <file>]"
+					 " [module.btm ...]" << std::endl;
+		return 2;
+	}
+
+	auto config = std::make_shared<Configuration>();
+	config->setSampleRate(opt.rate);
+	config->setBufferLength(40);
+
+	std::vector<Report> reports;
+	std::vector<ClipReport> clipReports;
+	bool isPassed = true;
+	for (auto& path : opt.modules) {
+		BambooTracker bt(config);
+		if (!bt.loadModule(path)) {
+			std::cerr << "Failed to load " << path << std::endl;
+			isPassed = false;
+			continue;
+		}
+		size_t first = reports.size();
+		isPassed &= renderModule(bt, getBaseName(path), opt, reports);
+		if (opt.roundTripLevel >= 0) isPassed &= checkRoundTrip(bt, config, getBaseName(path), opt, reports, first);
+		if (opt.isClipRendered) isPassed &= renderClips(bt, getBaseName(path), opt, clipReports);
+	}
+	for (int i = 0; i < opt.syntheticCount; ++i) {
+		BambooTracker bt(config);
+		makeSyntheticModule(bt, 4, i);
+		std::string name = "synthetic-" + std::to_string(i);
+		size_t first = reports.size();
+		isPassed &= renderModule(bt, name, opt, reports);
+		if (opt.roundTripLevel >= 0) isPassed &= checkRoundTrip(bt, config, name, opt, reports, first);
+		if (opt.isClipRendered) isPassed &= renderClips(bt, name, opt, clipReports);
+	}
+
+	std::string json = toJson(reports, clipReports, isPassed);
+	if (opt.json.empty()) {
+		std::cout << json;
+	}
+	else {
+		std::ofstream ofs(opt.json, std::ios::binary);
+		ofs << json;
+	}
+
+	return isPassed ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+#include "synthetic_module.hpp"
+#include <string>
+#include <vector>
+
+namespace
+{
+	/// xorshift32. It is used instead of <random> to keep modules identical among compilers
+	class Random
+	{
+	public:
+		explicit Random(uint32_t seed) : state_(seed ? seed : 0x9e3779b9) {}
+		uint32_t next(uint32_t range)
+		{
+			state_ ^= state_ << 13;
+			state_ ^= state_ >> 17;
+			state_ ^= state_ << 5;
+			return state_ % range;
+		}
+
+	private:
+		uint32_t state_;
+	};
+
+	const int TRACK_COUNT_ = 15;
+	const int COLUMN_COUNT_ = 11;	// Note, instrument, volume, 4 effects
+	const int STEP_COUNT_ = 64;
+
+	const char* FX_[][2] = {
+		{ "00", "71" }, { "01", "4" }, { "02", "3" }, { "03", "8" }, { "04", "70" },
+		{ "07", "56" }, { "08", "1" }, { "0A", "2" }, { "0P", "130" }, { "0Q", "35" },
+		{ "0R", "36" }, { "0S", "2" }, { "0T", "35" }, { "0G", "3" }
+	};
+}
+
+void makeSyntheticModule(BambooTracker& bt, int orderCount, int seed, int songCount)
+{
+	Random rnd(static_cast<uint32_t>(seed) * 2654435761u + 1);
+
+	bt.makeNewModule();
+	bt.setCurrentSongNumber(0);
+
+	// Instruments
+	bt.setCurrentTrack(0);
+	bt.addInstrument(0, "FM");
+	bt.setEnvelopeFMParameter(0, FMEnvelopeParameter::AL, 4);
+	bt.setEnvelopeFMParameter(0, FMEnvelopeParameter::FB, 5);
+	bt.addOperatorSequenceFMSequenceCommand(FMEnvelopeParameter::AR1, 0, 20, -1);
+	bt.addOperatorSequenceFMSequenceCommand(FMEnvelopeParameter::AR1, 0, 25, -1);
+	bt.setInstrumentFMOperatorSequenceEnabled(0, FMEnvelopeParameter::AR1, true);
+	bt.addInstrument(1, "FM");
+	bt.setEnvelopeFMParameter(1, FMEnvelopeParameter::AL, 7);
+	bt.setCurrentTrack(6);
+	bt.addInstrument(2, "SSG");
+
+	for (int song = 0; song < songCount; ++song) {
+		if (song) bt.addSong(SongType::STD, "");
+
+		// Orders
+		for (int o = 1; o < orderCount; ++o) bt.insertOrderBelow(song, o - 1);
+		std::vector<std::vector<std::string>> ord(
+					static_cast<size_t>(orderCount), std::vector<std::string>(TRACK_COUNT_));
+		for (int o = 0; o < orderCount; ++o)
+			for (int t = 0; t < TRACK_COUNT_; ++t) ord[o][t] = std::to_string(o);
+		bt.pasteOrderCells(song, 0, 0, ord);
+
+		// Patterns
+		for (int o = 0; o < orderCount; ++o) {
+			std::vector<std::vector<std::string>> cells(
+						STEP_COUNT_, std::vector<std::string>(TRACK_COUNT_ * COLUMN_COUNT_, "-1"));
+			for (int s = 0; s < STEP_COUNT_; ++s) {
+				for (int t = 0; t < TRACK_COUNT_; ++t) {
+					std::string* c = &cells[s][t * COLUMN_COUNT_];
+					for (int e = 3; e < COLUMN_COUNT_; e += 2) c[e] = "--";
+
+					uint32_t r = rnd.next(8);
+					if (r < 5) {
+						c[0] = std::to_string(24 + rnd.next(48));
+						if (t < 6) c[1] = std::to_string(rnd.next(2));
+						else if (t < 9) c[1] = "2";
+						c[2] = std::to_string(rnd.next(t < 6 ? 128 : 16));
+					}
+					else if (r == 5 && t < 9) {
+						c[0] = "-2";	// Key off
+					}
+
+					// Jump effects are left out to play all orders
+					if (t < 9 && rnd.next(3) == 0) {
+						const char** fx = FX_[rnd.next(13)];
+						c[3] = fx[0];
+						c[4] = fx[1];
+					}
+				}
+			}
+			bt.pastePatternCells(song, 0, 0, o, 0, cells);
+		}
+	}
+}
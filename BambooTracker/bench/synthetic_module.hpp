@@ -0,0 +1,10 @@
+#pragma once
+
+#include "bamboo_tracker.hpp"
+
+/// Fill songs with a dense module.
+/// Every track has notes, instruments, volumes and effects in most steps,
+/// and each order uses own patterns.
+///		orderCount: 1-256
+///		songCount: number of songs filled in the same way
+void makeSyntheticModule(BambooTracker& bt, int orderCount, int seed = 0, int songCount = 1);
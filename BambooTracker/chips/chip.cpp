@@ -35,7 +35,7 @@ namespace chip
 
 		for (int pan = LEFT; pan <= RIGHT; ++pan) {
 			for (auto& buf : buffer_) {
-				buf[pan] = new stream_sample_t[SMPL_BUF_SIZE_];
+				buf[pan] = nullptr;
 			}
 		}
 	}
@@ -54,6 +54,21 @@ namespace chip
 		for (int snd = 0; snd < 2; ++snd) {
 			resampler_[snd]->init(internalRate_[snd], rate_, maxDuration_);
 		}
+		allocateBuffers();
+	}
+
+	void Chip::allocateBuffers()
+	{
+		for (int snd = 0; snd < 2; ++snd) {
+			size_t size = (internalRate_[snd] == rate_)
+						  ? SMPL_CHUNK_SIZE_
+						  : resampler_[snd]->calculateInternalSampleSize(SMPL_CHUNK_SIZE_) + 1;
+			bufferSize_[snd] = size;
+			for (int pan = LEFT; pan <= RIGHT; ++pan) {
+				delete[] buffer_[snd][pan];
+				buffer_[snd][pan] = new stream_sample_t[size];
+			}
+		}
 	}
 
 	void Chip::setRate(int rate)
@@ -65,6 +80,8 @@ namespace chip
 		for (auto& rsmp : resampler_) {
 			rsmp->setDestributionRate(rate);
 		}
+
+		allocateBuffers();
 	}
 
 	void Chip::funcSetRate(int rate)
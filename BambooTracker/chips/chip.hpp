@@ -32,7 +32,8 @@ namespace chip
 		void setExportContainer(std::shared_ptr<ExportContainerInterface> cntr = nullptr);
 
 		/*virtual void setVolume(float db) = 0;*/
-		virtual void mix(int16_t* stream, size_t nSamples) = 0;
+		/// Output is interleaved stereo float normalized to [-1.0, 1.0], not clipped
+		virtual void mix(float* stream, size_t nSamples) = 0;
 
 	protected:
 		const int id_;
@@ -47,12 +48,15 @@ namespace chip
 		float volumeRatio_[2];
 		/*static const int MAX_AMP_;*/
 
+		/// Internal sample buffers sized for SMPL_CHUNK_SIZE_ output samples
 		sample* buffer_[2][2];
+		size_t bufferSize_[2];
 		std::unique_ptr<AbstractResampler> resampler_[2];
 
 		std::shared_ptr<ExportContainerInterface> exCntr_;
 
 		void initResampler();
+		void allocateBuffers();
 
 		void funcSetRate(int rate);
 	};
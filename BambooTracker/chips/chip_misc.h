@@ -4,7 +4,9 @@
 
 namespace chip
 {
-	const size_t SMPL_BUF_SIZE_ = 0x10000;
+	/// Maximum output sample count rendered at once.
+	/// Larger requests are split so that buffers stay small and cache-resident
+	const size_t SMPL_CHUNK_SIZE_ = 0x400;
 
 	enum Stereo : int
 	{
@@ -14,7 +14,7 @@ namespace chip
 	{
 	}
 
-	void WavExportContainer::recordStream(int16_t* stream, size_t nSamples)
+	void WavExportContainer::recordStream(float* stream, size_t nSamples)
 	{
 		std::copy(stream, stream + (nSamples << 1), std::back_inserter(samples_));
 	}
@@ -29,11 +29,16 @@ namespace chip
 		samples_.clear();
 	}
 
-	std::vector<int16_t> WavExportContainer::getStream() const
+	std::vector<float> WavExportContainer::getStream() const
 	{
 		return samples_;
 	}
 
+	void WavExportContainer::reserve(size_t nSamples)
+	{
+		samples_.reserve(nSamples << 1);
+	}
+
 	//******************************//
 	VgmExportContainer::VgmExportContainer(uint32_t intrRate)
 		: lastWait_(0),
@@ -56,7 +61,7 @@ namespace chip
 		buf_.push_back(value);
 	}
 
-	void VgmExportContainer::recordStream(int16_t* stream, size_t nSamples)
+	void VgmExportContainer::recordStream(float* stream, size_t nSamples)
 	{
 		lastWait_ += nSamples;
 		totalSampCnt_ += nSamples;
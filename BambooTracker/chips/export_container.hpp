@@ -11,7 +11,7 @@ namespace chip
 	public:
 		virtual ~ExportContainerInterface();
 		virtual void recordRegisterChange(uint32_t offset, uint8_t value) = 0;
-		virtual void recordStream(int16_t* stream, size_t nSamples) = 0;
+		virtual void recordStream(float* stream, size_t nSamples) = 0;
 		virtual bool empty() const = 0;
 		virtual void clear() = 0;
 	};
@@ -21,13 +21,14 @@ namespace chip
 	public:
 		WavExportContainer();
 		void recordRegisterChange(uint32_t offset, uint8_t value) override;
-		void recordStream(int16_t* stream, size_t nSamples) override;
+		void recordStream(float* stream, size_t nSamples) override;
 		bool empty() const override;
 		void clear() override;
-		std::vector<int16_t> getStream() const;
+		std::vector<float> getStream() const;
+		void reserve(size_t nSamples);
 
 	private:
-		std::vector<int16_t> samples_;
+		std::vector<float> samples_;
 	};
 
 	class VgmExportContainer : public ExportContainerInterface
@@ -35,7 +36,7 @@ namespace chip
 	public:
 		VgmExportContainer(uint32_t intrRate);
 		void recordRegisterChange(uint32_t offset, uint8_t value) override;
-		void recordStream(int16_t* stream, size_t nSamples) override;
+		void recordStream(float* stream, size_t nSamples) override;
 		void clear() override;
 		bool empty() const override;
 		std::vector<uint8_t> getData();
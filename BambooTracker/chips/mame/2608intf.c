@@ -47,7 +47,7 @@ extern INT32 CHIP_SAMPLE_RATE;
 static UINT8 AY_EMU_CORE = 0x00;
 //extern UINT32 SampleRate;
 
-#define MAX_CHIPS	0x02
+#define MAX_CHIPS	YM2608_MAX_CHIPS
 static ym2608_state YM2608Data[MAX_CHIPS];
 
 /*INLINE ym2608_state *get_safe_token(const device_config *device)
@@ -448,6 +448,22 @@ void ym2608_set_mute_mask(UINT8 ChipID, UINT32 MuteMaskFM, UINT32 MuteMaskAY)
 	}
 }
 
+// TapsFM: FM1-6 and rhythm, TapsAY: SSG1-3, NULL to disable
+void ym2608_set_output_taps(UINT8 ChipID, stream_sample_t **TapsFM, stream_sample_t **TapsAY)
+{
+	ym2608_state* info = &YM2608Data[ChipID];
+	ym2608_set_taps(info->chip, TapsFM);
+	if (info->psg != NULL)
+	{
+		switch(AY_EMU_CORE)
+		{
+		case EC_EMU2149:
+			PSG_setTaps((PSG*)info->psg, TapsAY);
+			break;
+		}
+	}
+}
+
 //void ym2608_set_srchg_cb(UINT8 ChipID, SRATE_CALLBACK CallbackFunc, void* DataPtr, void* AYDataPtr)
 //{
 //	ym2608_state* info = &YM2608Data[ChipID];
@@ -41,6 +41,9 @@ struct _ay8910_interface
 };
 #endif
 
+/* Chip ids must be less than it */
+#define YM2608_MAX_CHIPS	0x08
+
 void ym2608_update_request(void *param);
 
 typedef struct _ym2608_interface ym2608_interface;
@@ -89,4 +92,5 @@ void ym2608_set_ay_emu_core(UINT8 Emulator);
 //void ym2608_write_data_pcmrom(UINT8 ChipID, UINT8 rom_id, offs_t ROMSize, offs_t DataStart,
 //							  offs_t DataLength, const UINT8* ROMData);
 void ym2608_set_mute_mask(UINT8 ChipID, UINT32 MuteMaskFM, UINT32 MuteMaskAY);
+void ym2608_set_output_taps(UINT8 ChipID, stream_sample_t **TapsFM, stream_sample_t **TapsAY);
 //void ym2608_set_srchg_cb(UINT8 ChipID, SRATE_CALLBACK CallbackFunc, void* DataPtr, void* AYDataPtr);
@@ -467,9 +467,23 @@ PSG_calc_stereo (PSG * psg, e_int32 **out, e_int32 samples)
       bufRO[i] = (e_int32) (((double) psg->snext[1] * (psg->psgstep - psg->psgtime)
                            + (double) psg->sprev[1] * psg->psgtime) / psg->psgstep);
     }
+
+    if (psg->taps)
+    {
+      psg->taps[0][i] = psg->cout[0] << 5;
+      psg->taps[1][i] = psg->cout[1] << 5;
+      psg->taps[2][i] = psg->cout[2] << 5;
+    }
   }
 }
 
+EMU2149_API void
+PSG_setTaps (PSG *psg, e_int32 **taps)
+{
+  if(psg)
+    psg->taps = taps;
+}
+
 EMU2149_API void
 PSG_writeReg (PSG * psg, e_uint32 reg, e_uint32 val)
 {
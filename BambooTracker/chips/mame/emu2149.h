@@ -72,6 +72,9 @@ extern "C"
     e_int32 prev, next;
     e_int32 sprev[2], snext[2];
 
+    /* Per channel outputs (NULL: disabled) */
+    e_int32 **taps;
+
     /* I/O Ctrl */
     e_uint32 adr;
 
@@ -95,6 +98,7 @@ extern "C"
   EMU2149_API e_uint32 PSG_setMask (PSG *, e_uint32 mask);
   EMU2149_API e_uint32 PSG_toggleMask (PSG *, e_uint32 mask);
   EMU2149_API void PSG_setStereoMask (PSG *psg, e_uint32 mask);
+  EMU2149_API void PSG_setTaps (PSG *psg, e_int32 **taps);
     
 /*#ifdef __cplusplus
 }
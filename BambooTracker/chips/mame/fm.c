@@ -2469,6 +2469,8 @@ typedef struct
 
     UINT8		flagmask;			/* YM2608 only */
     UINT8		irqmask;			/* YM2608 only */
+
+	FMSAMPLE	**taps;				/* per channel outputs, FM1-6 and ADPCM-A (YM2608 only) */
 } YM2610;
 
 /* here is the virtual YM2608 */
@@ -3464,6 +3466,15 @@ void ym2608_update_one(void *chip, FMSAMPLE **buffer, int length)
 			bufL[i] = lt;
 			bufR[i] = rt;
 
+			/* per channel outputs (mono, before panning) */
+			if (F2608->taps)
+			{
+				for( j = 0; j < 6; j++ )
+					F2608->taps[j][i] = out_fm[j] >> FINAL_SH;
+				F2608->taps[6][i] = (OPN->out_adpcm[OUTD_LEFT] + OPN->out_adpcm[OUTD_RIGHT]
+									 + (OPN->out_adpcm[OUTD_CENTER] << 1)) >> FINAL_SH;
+			}
+
 			#ifdef SAVE_SAMPLE
 				SAVE_ALL_CHANNELS
 			#endif
@@ -3933,6 +3944,13 @@ void ym2608_set_mutemask(void *chip, UINT32 MuteMask)
 	
 	return;
 }
+
+/* taps: 7 buffers (FM1-6, ADPCM-A) at least as long as update length, or NULL to disable */
+void ym2608_set_taps(void *chip, FMSAMPLE **taps)
+{
+	YM2608 *F2608 = (YM2608 *)chip;
+	F2608->taps = taps;
+}
 #endif /* BUILD_YM2608 */
 
 
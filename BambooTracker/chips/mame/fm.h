@@ -191,6 +191,7 @@ void ym2608_write_pcmrom(void *chip, UINT8 rom_id, offs_t ROMSize, offs_t DataSt
 						 offs_t DataLength, const UINT8* ROMData);
 
 void ym2608_set_mutemask(void *chip, UINT32 MuteMask);
+void ym2608_set_taps(void *chip, FMSAMPLE **taps);
 #endif /* BUILD_YM2608 */
 
 #if (BUILD_YM2610||BUILD_YM2610B)
@@ -1,5 +1,7 @@
 #include "opna.hpp"
+#include <stdexcept>
 #include "chip_misc.h"
+#include "../audio_profiler.hpp"
 
 #ifdef  __cplusplus
 extern "C"
@@ -14,7 +16,9 @@ extern "C"
 
 namespace chip
 {
-	size_t OPNA::count_ = 0;
+	uint32_t OPNA::usedIds_ = 0;
+	std::mutex OPNA::idMutex_;
+	constexpr int OPNA::OUTPUT_TAP_COUNT;
 	
 	/*const int OPNA::DEF_AMP_FM_ = 11722;*/
 	/*const int OPNA::DEF_AMP_SSG_ = 7250;*/
@@ -22,9 +26,14 @@ namespace chip
 	OPNA::OPNA(int clock, int rate, size_t maxDuration,
 			   std::unique_ptr<AbstractResampler> fmResampler, std::unique_ptr<AbstractResampler> ssgResampler,
 			   std::shared_ptr<ExportContainerInterface> exportContainer)
-		: Chip(count_++, clock, rate, 110933, maxDuration,
+		: Chip(allocateId(), clock, rate, 110933, maxDuration,
 			   std::move(fmResampler), std::move(ssgResampler),	// autoRate = 110933: FM internal rate
-			   exportContainer)
+			   exportContainer),
+		  isTapsUsed_(false),
+		  isTapsEnabled_(false),
+		  isMonitorOnly_(false),
+		  monitorPhase_(0),
+		  monitorCount_(0)
 	{
 		funcSetRate(rate);
 
@@ -46,7 +55,19 @@ namespace chip
 	{
 		device_stop_ym2608(id_);
 
-		--count_;
+		std::lock_guard<std::mutex> lg(idMutex_);
+		usedIds_ &= ~(1u << id_);
+	}
+
+	int OPNA::allocateId()
+	{
+		std::lock_guard<std::mutex> lg(idMutex_);
+		int id = 0;
+		while (id < YM2608_MAX_CHIPS && (usedIds_ & (1u << id))) ++id;
+		// The emulator has static states for a fixed number of chips
+		if (id == YM2608_MAX_CHIPS) throw std::runtime_error("OPNA: no free chip id");
+		usedIds_ |= (1u << id);
+		return id;
 	}
 
 	void OPNA::reset()
@@ -95,44 +116,195 @@ namespace chip
 
 		/*VolumeRatio_[FM] = maxAmplitude_ / defaultFMAmplitude_ * std::pow(10, fmdB / 20);
 		VolumeRatio_[SSG] = maxAmplitude_ / defaultSSGAmplitude_ * std::pow(10, ssgdB / 20);*/
-		volumeRatio_[FM] = 0.25;
-		volumeRatio_[SSG] = 0.25;
+		// Include normalization from int16 range to float
+		volumeRatio_[FM] = 0.25f / 32768.0f;
+		volumeRatio_[SSG] = 0.25f / 32768.0f;
 	}
 
-	void OPNA::mix(int16_t* stream, size_t nSamples)
+	void OPNA::mix(float* stream, size_t nSamples)
 	{
 		std::lock_guard<std::mutex> lg(mutex_);
+		AudioProfiler::Scope prof(AudioStage::CHIP_MIX);
+
+		if (isTapsEnabled_) {
+			for (auto& out : tapOut_) {
+				if (out.size() < nSamples) out.resize(nSamples);
+			}
+		}
+		monitorCount_ = 0;
+
+		for (size_t offset = 0; offset < nSamples; ) {
+			size_t n = std::min(nSamples - offset, SMPL_CHUNK_SIZE_);
+			funcMix(stream, offset, n);
+			offset += n;
+		}
+
+		if (monitor_) {
+			const float* taps[OUTPUT_TAP_COUNT];
+			for (int i = 0; i < OUTPUT_TAP_COUNT; ++i) taps[i] = tapOut_[i].data();
+			if (isMonitorOnly_) monitor_->recordDecimatedSamples(taps, monitorCount_, nSamples);
+			else monitor_->recordSamples(taps, nSamples);
+		}
+
+		if (exCntr_) {
+			AudioProfiler::Scope profEx(AudioStage::EXPORT_RECORD);
+			exCntr_->recordStream(stream, nSamples);
+		}
+	}
+
+	void OPNA::funcMix(float* stream, size_t offset, size_t nSamples)
+	{
 		sample **bufFM, **bufSSG;
+		size_t intrSizeFM = nSamples, intrSizeSSG = nSamples;
+
+		if (isTapsEnabled_) prepareOutputTaps();
 
 		// Set FM buffer
 		if (internalRate_[FM] == rate_) {
+			AudioProfiler::Scope prof(AudioStage::FM_UPDATE);
 			ym2608_stream_update(id_, buffer_[FM], nSamples);
 			bufFM = buffer_[FM];
 		}
 		else {
-			size_t intrSize = resampler_[FM]->calculateInternalSampleSize(nSamples);
-			ym2608_stream_update(id_, buffer_[FM], intrSize);
-			bufFM = resampler_[FM]->interpolate(buffer_[FM], nSamples, intrSize);
+			intrSizeFM = resampler_[FM]->calculateInternalSampleSize(nSamples);
+			{
+				AudioProfiler::Scope prof(AudioStage::FM_UPDATE);
+				ym2608_stream_update(id_, buffer_[FM], intrSizeFM);
+			}
+			AudioProfiler::Scope prof(AudioStage::FM_RESAMPLE);
+			bufFM = resampler_[FM]->interpolate(buffer_[FM], nSamples, intrSizeFM);
 		}
 
 		// Set SSG buffer
 		if (internalRate_[SSG] == rate_) {
+			AudioProfiler::Scope prof(AudioStage::SSG_UPDATE);
 			ym2608_stream_update_ay(id_, buffer_[SSG], nSamples);
 			bufSSG = buffer_[SSG];
 		}
 		else {
-			size_t intrSize = resampler_[SSG]->calculateInternalSampleSize(nSamples);
-			ym2608_stream_update_ay(id_, buffer_[SSG], intrSize);
-			bufSSG = resampler_[SSG]->interpolate(buffer_[SSG], nSamples, intrSize);
-		}
-		int16_t* p = stream;
-		for (size_t i = 0; i < nSamples; ++i) {
-			for (int pan = LEFT; pan <= RIGHT; ++pan) {
-				float s = volumeRatio_[FM] * bufFM[pan][i] + volumeRatio_[SSG] * bufSSG[pan][i];
-				*p++ = static_cast<int16_t>(clamp(s, -32768.0f, 32767.0f));
+			intrSizeSSG = resampler_[SSG]->calculateInternalSampleSize(nSamples);
+			{
+				AudioProfiler::Scope prof(AudioStage::SSG_UPDATE);
+				ym2608_stream_update_ay(id_, buffer_[SSG], intrSizeSSG);
+			}
+			AudioProfiler::Scope prof(AudioStage::SSG_RESAMPLE);
+			bufSSG = resampler_[SSG]->interpolate(buffer_[SSG], nSamples, intrSizeSSG);
+		}
+
+		{
+			AudioProfiler::Scope prof(AudioStage::FINAL_MIX);
+			const float ratioFM = volumeRatio_[FM];
+			const float ratioSSG = volumeRatio_[SSG];
+			float* p = stream + (offset << 1);
+			for (size_t i = 0; i < nSamples; ++i) {
+				for (int pan = LEFT; pan <= RIGHT; ++pan) {
+					*p++ = ratioFM * bufFM[pan][i] + ratioSSG * bufSSG[pan][i];
+				}
+			}
+		}
+
+		// Resample taps after the mix because resamplers reuse their output buffers
+		if (isTapsEnabled_) {
+			static const int OUT_IDX_FM[7] = { 0, 1, 2, 3, 4, 5, 9 };
+			static const int OUT_IDX_SSG[3] = { 6, 7, 8 };
+			if (isMonitorOnly_) {
+				pickOutputTaps(FM, tapPtrFM_, OUT_IDX_FM, 7, nSamples, intrSizeFM);
+				size_t cnt = pickOutputTaps(SSG, tapPtrSSG_, OUT_IDX_SSG, 3, nSamples, intrSizeSSG);
+				size_t decimation = monitor_->getDecimation();
+				monitorPhase_ = monitorPhase_ + cnt * decimation - nSamples;
+				monitorCount_ += cnt;
+			}
+			else {
+				resampleOutputTaps(FM, tapPtrFM_, OUT_IDX_FM, 7, offset, nSamples, intrSizeFM);
+				resampleOutputTaps(SSG, tapPtrSSG_, OUT_IDX_SSG, 3, offset, nSamples, intrSizeSSG);
 			}
 		}
+	}
+
+	void OPNA::setOutputTapsEnabled(bool enabled)
+	{
+		std::lock_guard<std::mutex> lg(mutex_);
 
-		if (exCntr_) exCntr_->recordStream(stream, nSamples);
+		isTapsUsed_ = enabled;
+		updateOutputTapsState();
+	}
+
+	void OPNA::setOutputMonitor(std::shared_ptr<OutputMonitor> monitor)
+	{
+		std::lock_guard<std::mutex> lg(mutex_);
+
+		monitor_ = monitor;
+		updateOutputTapsState();
+	}
+
+	void OPNA::updateOutputTapsState()
+	{
+		isTapsEnabled_ = (isTapsUsed_ || monitor_);
+		isMonitorOnly_ = (!isTapsUsed_ && monitor_);
+		monitorPhase_ = 0;
+		if (!isTapsEnabled_) ym2608_set_output_taps(id_, nullptr, nullptr);
+	}
+
+	bool OPNA::isOutputTapsEnabled() const
+	{
+		return isTapsUsed_;
+	}
+
+	const float* OPNA::getOutputTap(int ch) const
+	{
+		return tapOut_[ch].data();
+	}
+
+	void OPNA::prepareOutputTaps()
+	{
+		// Buffer size changes only when rate is changed
+		for (int i = 0; i < 7; ++i) {
+			tapBufFM_[i].resize(bufferSize_[FM]);
+			tapPtrFM_[i] = tapBufFM_[i].data();
+		}
+		for (int i = 0; i < 3; ++i) {
+			tapBufSSG_[i].resize(bufferSize_[SSG]);
+			tapPtrSSG_[i] = tapBufSSG_[i].data();
+		}
+		ym2608_set_output_taps(id_, tapPtrFM_, tapPtrSSG_);
+	}
+
+	void OPNA::resampleOutputTaps(SoundSource src, sample** taps, const int* outIdx, int cnt,
+								  size_t offset, size_t nSamples, size_t intrSize)
+	{
+		const float ratio = volumeRatio_[src];
+		for (int i = 0; i < cnt; i += 2) {
+			// Resamplers process 2 buffers at once
+			int j = (i + 1 < cnt) ? (i + 1) : i;
+			sample* pair[2] = { taps[i], taps[j] };
+			sample** buf = (internalRate_[src] == rate_) ? pair
+														 : resampler_[src]->interpolate(pair, nSamples, intrSize);
+			float* outL = tapOut_[outIdx[i]].data() + offset;
+			float* outR = tapOut_[outIdx[j]].data() + offset;
+			for (size_t n = 0; n < nSamples; ++n) {
+				outL[n] = ratio * buf[LEFT][n];
+				outR[n] = ratio * buf[RIGHT][n];
+			}
+		}
+	}
+	size_t OPNA::pickOutputTaps(SoundSource src, sample** taps, const int* outIdx, int cnt,
+								size_t nSamples, size_t intrSize)
+	{
+		const float ratio = volumeRatio_[src];
+		const size_t decimation = monitor_->getDecimation();
+		if (monitorPhase_ >= nSamples) return 0;
+		const size_t picked = (nSamples - monitorPhase_ + decimation - 1) / decimation;
+		// Nearest preceding internal sample of each picked position, in 32.32 fixed point
+		const uint64_t begin = (static_cast<uint64_t>(monitorPhase_ * intrSize) << 32) / nSamples;
+		const uint64_t inc = (static_cast<uint64_t>(decimation * intrSize) << 32) / nSamples;
+		for (int i = 0; i < cnt; ++i) {
+			const sample* tap = taps[i];
+			float* out = tapOut_[outIdx[i]].data() + monitorCount_;
+			uint64_t pos = begin;
+			for (size_t n = 0; n < picked; ++n, pos += inc) {
+				out[n] = ratio * tap[pos >> 32];
+			}
+		}
+		return picked;
 	}
 }
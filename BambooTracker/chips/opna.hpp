@@ -1,6 +1,10 @@
 #pragma once
 
 #include "chip.hpp"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include "output_monitor.hpp"
 
 namespace chip
 {
@@ -19,10 +23,27 @@ namespace chip
 		void setRegister(uint32_t offset, uint8_t value) override;
 		uint8_t getRegister(uint32_t offset) const override;
 		void setVolume(float dBFM, float dBSSG);	// NOT work
-		void mix(int16_t* stream, size_t nSamples) override;
+		void mix(float* stream, size_t nSamples) override;
+
+		/// Per channel outputs are rendered alongside the mix only while enabled
+		void setOutputTapsEnabled(bool enabled);
+		bool isOutputTapsEnabled() const;
+		/// Mono output of the channel in the last mix, scaled as same as the mix.
+		/// It is valid until the next mix
+		///		ch: 0-5 = FM1-6, 6-8 = SSG1-3, 9 = Rhythm
+		const float* getOutputTap(int ch) const;
+		/// Feed output taps to the monitor while it is set
+		void setOutputMonitor(std::shared_ptr<OutputMonitor> monitor = nullptr);
+
+		static constexpr int OUTPUT_TAP_COUNT = 10;
 
 	private:
-		static size_t count_;
+		/// Bit flags of ids used by existing chips. Ids must be less than YM2608_MAX_CHIPS
+		static uint32_t usedIds_;
+		static std::mutex idMutex_;
+
+		/// Throw std::runtime_error if all ids are used
+		static int allocateId();
 
 		/*static const int DEF_AMP_FM_, DEF_AMP_SSG_;*/
 
@@ -31,5 +52,29 @@ namespace chip
 			FM  = 0,
 			SSG = 1
 		};
+
+		/// isTapsEnabled_ is true when taps are requested by setOutputTapsEnabled or monitor
+		bool isTapsUsed_, isTapsEnabled_;
+		std::shared_ptr<OutputMonitor> monitor_;
+		/// Internal rate buffers, FM1-6 and rhythm in FM, SSG1-3 in SSG
+		std::vector<sample> tapBufFM_[7], tapBufSSG_[3];
+		sample *tapPtrFM_[7], *tapPtrSSG_[3];
+		std::vector<float> tapOut_[OUTPUT_TAP_COUNT];
+		/// Only the monitor reads taps. Samples are picked at the decimation interval
+		/// of the monitor from internal rate buffers instead of resampling all samples
+		bool isMonitorOnly_;
+		/// Position of the next picked sample in the next chunk
+		size_t monitorPhase_;
+		/// Count of picked samples in the current mix
+		size_t monitorCount_;
+
+		void funcMix(float* stream, size_t offset, size_t nSamples);
+		void updateOutputTapsState();
+		void prepareOutputTaps();
+		void resampleOutputTaps(SoundSource src, sample** taps, const int* outIdx, int cnt,
+								size_t offset, size_t nSamples, size_t intrSize);
+		/// Return the count of picked samples
+		size_t pickOutputTaps(SoundSource src, sample** taps, const int* outIdx, int cnt,
+							  size_t nSamples, size_t intrSize);
 	};
 }
@@ -0,0 +1,139 @@
+#include "output_monitor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace chip
+{
+	constexpr int MonitorFrame::CHANNEL_COUNT;
+	constexpr size_t MonitorFrame::WAVE_SIZE;
+	constexpr int OutputMonitor::FRESH_FLAG_;
+
+	OutputMonitor::OutputMonitor(size_t decimation, size_t publishSize)
+		: middle_(1),
+		  writeIdx_(0),
+		  readIdx_(2),
+		  decimation_(decimation ? decimation : 1),
+		  decimationPhase_(0),
+		  historyPos_(0),
+		  levelCount_(0),
+		  publishSize_(publishSize),
+		  recordedCount_(0)
+	{
+		for (auto& frame : frames_) {
+			std::fill(&frame.wave[0][0], &frame.wave[0][0] + MonitorFrame::CHANNEL_COUNT * MonitorFrame::WAVE_SIZE, 0.0f);
+			std::fill(std::begin(frame.peak), std::end(frame.peak), 0.0f);
+			std::fill(std::begin(frame.rms), std::end(frame.rms), 0.0f);
+		}
+		std::fill(&history_[0][0], &history_[0][0] + MonitorFrame::CHANNEL_COUNT * MonitorFrame::WAVE_SIZE, 0.0f);
+		std::fill(std::begin(peakSum_), std::end(peakSum_), 0.0f);
+		std::fill(std::begin(squareSum_), std::end(squareSum_), 0.0f);
+	}
+
+	void OutputMonitor::recordSamples(const float* const* channels, size_t nSamples)
+	{
+		recordWaveAndLevels(channels, decimationPhase_, decimation_, nSamples);
+		decimationPhase_ = (decimationPhase_ + decimation_ - nSamples % decimation_) % decimation_;
+
+		recordedCount_ += nSamples;
+		if (recordedCount_ >= publishSize_) publish();
+	}
+
+	void OutputMonitor::recordDecimatedSamples(const float* const* channels, size_t count, size_t nSamples)
+	{
+		recordWaveAndLevels(channels, 0, 1, count);
+
+		recordedCount_ += nSamples;
+		if (recordedCount_ >= publishSize_) publish();
+	}
+
+	size_t OutputMonitor::getDecimation() const
+	{
+		return decimation_;
+	}
+
+	size_t OutputMonitor::recordWaveAndLevels(const float* const* channels, size_t first, size_t step, size_t end)
+	{
+		size_t cnt = (first < end) ? ((end - first + step - 1) / step) : 0;
+		// Levels are computed on the written history, so less than a round of it is written at once
+		for (size_t done = 0; done < cnt; ) {
+			size_t n = std::min(cnt - done, MonitorFrame::WAVE_SIZE);
+			size_t head = historyPos_;
+			size_t n1 = std::min(n, MonitorFrame::WAVE_SIZE - head);
+			for (int ch = 0; ch < MonitorFrame::CHANNEL_COUNT; ++ch) {
+				const float* src = channels[ch] + first + done * step;
+				float* hist = history_[ch];
+				if (step == 1) {
+					std::copy(src, src + n1, hist + head);
+					std::copy(src + n1, src + n, hist);
+				}
+				else {
+					for (size_t i = 0; i < n1; ++i) hist[head + i] = src[i * step];
+					src += n1 * step;
+					for (size_t i = 0; i < n - n1; ++i) hist[i] = src[i * step];
+				}
+
+				accumulateLevels(ch, hist + head, n1);
+				accumulateLevels(ch, hist, n - n1);
+			}
+			historyPos_ = (head + n) % MonitorFrame::WAVE_SIZE;
+			done += n;
+		}
+		levelCount_ += cnt;
+		return cnt;
+	}
+
+	void OutputMonitor::accumulateLevels(int ch, const float* src, size_t n)
+	{
+		// 4 independent lanes so that compilers vectorize the loop
+		float peak[4] = { peakSum_[ch], 0.0f, 0.0f, 0.0f };
+		float square[4] = { squareSum_[ch], 0.0f, 0.0f, 0.0f };
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4) {
+			for (int k = 0; k < 4; ++k) {
+				float v = src[i + k];
+				peak[k] = std::max(peak[k], std::fabs(v));
+				square[k] += v * v;
+			}
+		}
+		for (; i < n; ++i) {
+			peak[0] = std::max(peak[0], std::fabs(src[i]));
+			square[0] += src[i] * src[i];
+		}
+		peakSum_[ch] = std::max(std::max(peak[0], peak[1]), std::max(peak[2], peak[3]));
+		squareSum_[ch] = (square[0] + square[1]) + (square[2] + square[3]);
+	}
+
+	void OutputMonitor::publish()
+	{
+		MonitorFrame& frame = frames_[writeIdx_];
+		for (int ch = 0; ch < MonitorFrame::CHANNEL_COUNT; ++ch) {
+			const float* hist = history_[ch];
+			float* wave = frame.wave[ch];
+			std::copy(hist + historyPos_, hist + MonitorFrame::WAVE_SIZE, wave);
+			std::copy(hist, hist + historyPos_, wave + (MonitorFrame::WAVE_SIZE - historyPos_));
+
+			frame.peak[ch] = peakSum_[ch];
+			frame.rms[ch] = levelCount_ ? std::sqrt(squareSum_[ch] / levelCount_) : 0.0f;
+			peakSum_[ch] = 0.0f;
+			squareSum_[ch] = 0.0f;
+		}
+		levelCount_ = 0;
+		recordedCount_ = 0;
+
+		writeIdx_ = middle_.exchange(writeIdx_ | FRESH_FLAG_, std::memory_order_acq_rel) & ~FRESH_FLAG_;
+	}
+
+	bool OutputMonitor::hasNewFrame() const
+	{
+		return (middle_.load(std::memory_order_acquire) & FRESH_FLAG_);
+	}
+
+	const MonitorFrame& OutputMonitor::getLatestFrame()
+	{
+		if (hasNewFrame()) {
+			readIdx_ = middle_.exchange(readIdx_, std::memory_order_acq_rel) & ~FRESH_FLAG_;
+		}
+		return frames_[readIdx_];
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+
+namespace chip
+{
+	struct MonitorFrame
+	{
+		/// Same as OPNA output taps: 0-5 = FM1-6, 6-8 = SSG1-3, 9 = Rhythm
+		static constexpr int CHANNEL_COUNT = 10;
+		static constexpr size_t WAVE_SIZE = 256;
+
+		/// Decimated waveform, oldest first
+		float wave[CHANNEL_COUNT][WAVE_SIZE];
+		/// Levels of samples recorded since the previous frame
+		float peak[CHANNEL_COUNT];
+		float rms[CHANNEL_COUNT];
+	};
+
+	/// Feed of channel outputs from the audio thread to a display.
+	/// It has a single producer calling recordSamples and a single consumer reading frames,
+	/// and both sides are wait-free by triple buffering
+	class OutputMonitor
+	{
+	public:
+		// decimation: interval of waveform samples
+		// publishSize: sample count to publish a new frame
+		explicit OutputMonitor(size_t decimation = 4, size_t publishSize = 1024);
+
+		/// Producer
+		void recordSamples(const float* const* channels, size_t nSamples);
+		/// Record samples which the producer already picked at the decimation interval.
+		///		count: picked sample count
+		///		nSamples: sample count before decimation
+		void recordDecimatedSamples(const float* const* channels, size_t count, size_t nSamples);
+		size_t getDecimation() const;
+
+		/// Consumer
+		bool hasNewFrame() const;
+		/// Return the newest published frame which is valid until the next call
+		const MonitorFrame& getLatestFrame();
+
+	private:
+		MonitorFrame frames_[3];
+		/// Index of the frame shared between producer and consumer
+		std::atomic<int> middle_;
+		int writeIdx_, readIdx_;
+
+		static constexpr int FRESH_FLAG_ = 4;
+
+		// Producer state
+		size_t decimation_, decimationPhase_;
+		float history_[MonitorFrame::CHANNEL_COUNT][MonitorFrame::WAVE_SIZE];
+		size_t historyPos_;
+		/// Levels are taken from decimated samples, which is enough for meters
+		float peakSum_[MonitorFrame::CHANNEL_COUNT];
+		float squareSum_[MonitorFrame::CHANNEL_COUNT];
+		size_t levelCount_;
+		size_t publishSize_, recordedCount_;
+
+		/// Record src[first], src[first + step], ... before end, and return the count
+		size_t recordWaveAndLevels(const float* const* channels, size_t first, size_t step, size_t end);
+		void accumulateLevels(int ch, const float* src, size_t n);
+		void publish();
+	};
+}
@@ -6,7 +6,7 @@ namespace chip
 	AbstractResampler::AbstractResampler()
 	{
 		for (int pan = LEFT; pan <= RIGHT; ++pan) {
-			destBuf_[pan] = new sample[SMPL_BUF_SIZE_]();
+			destBuf_[pan] = new sample[SMPL_CHUNK_SIZE_]();
 		}
 	}
 
@@ -73,12 +73,6 @@ namespace chip
 		initSincTables();
 	}
 
-	void SincResampler::setMaxDuration(size_t maxDuration)
-	{
-		AbstractResampler::setMaxDuration(maxDuration);
-		initSincTables();
-	}
-
 	sample** SincResampler::interpolate(sample** src, size_t nSamples, size_t intrSize)
 	{
 		// Sinc interpolation
@@ -105,7 +99,7 @@ namespace chip
 
 	void SincResampler::initSincTables()
 	{
-		size_t maxSamples = destRate_ * maxDuration_ / 1000;
+		size_t maxSamples = SMPL_CHUNK_SIZE_;
 
 		if (srcRate_ != destRate_) {
 			size_t intrSize = calculateInternalSampleSize(maxSamples);
@@ -49,7 +49,6 @@ namespace chip
 	public:
 		void init(int srcRate, int destRate, size_t maxDuration) override;
 		void setDestributionRate(int destRate) override;
-		void setMaxDuration(size_t maxDuration) override;
 		sample** interpolate(sample** src, size_t nSamples, size_t intrSize) override;
 
 	private:
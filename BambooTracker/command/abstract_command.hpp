@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 struct AbstractCommand
 {
 	virtual ~AbstractCommand() {}
@@ -10,4 +12,15 @@ struct AbstractCommand
 	{
 		return false;
 	}
+	/// Approximate bytes held by the command.
+	/// The default is for commands which have only a few values
+	virtual size_t getMemorySize() const
+	{
+		return DEF_MEMORY_SIZE;
+	}
+	/// Shrink data kept for undo and redo. It is called on old commands in the history,
+	/// and the data may be restored in the next undo or redo
+	virtual void compact() {}
+
+	static constexpr size_t DEF_MEMORY_SIZE = 64;
 };
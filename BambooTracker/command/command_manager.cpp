@@ -1,38 +1,138 @@
 #include "command_manager.hpp"
 #include <utility>
 
-CommandManager::CommandManager() {}
+constexpr size_t CommandManager::DEF_MEMORY_LIMIT;
+constexpr size_t CommandManager::UNCOMPACTED_COUNT;
+
+CommandManager::CommandManager()
+	: memLimit_(DEF_MEMORY_LIMIT),
+	  memSize_(0),
+	  droppedCnt_(0)
+{
+}
 
 void CommandManager::invoke(CommandIPtr command)
 {
 	command->redo();
 
-	redoStack_ = std::stack<CommandIPtr>();
-	if (undoStack_.empty() || !undoStack_.top()->mergeWith(command.get())) {
-		undoStack_.push(std::move(command));
+	for (auto& entry : redoStack_) memSize_ -= entry.size;
+	redoStack_.clear();
+	if (undoStack_.empty() || !undoStack_.back().command->mergeWith(command.get())) {
+		pushUndo(std::move(command));
 	}
+	else {
+		resize(undoStack_.back());
+	}
+	shrink();
 }
 
 void CommandManager::undo()
 {
 	if (undoStack_.empty()) return;
-	CommandIPtr command = std::move(undoStack_.top());
-	command->undo();
-	undoStack_.pop();
-	redoStack_.push(std::move(command));
+	Entry entry = std::move(undoStack_.back());
+	undoStack_.pop_back();
+	entry.command->undo();
+	entry.isCompacted = false;
+	resize(entry);
+	redoStack_.push_back(std::move(entry));
+	shrink();
 }
 
 void CommandManager::redo()
 {
 	if (redoStack_.empty()) return;
-	CommandIPtr command = std::move(redoStack_.top());
-	command->redo();
-	redoStack_.pop();
-	undoStack_.push(std::move(command));
+	Entry entry = std::move(redoStack_.back());
+	redoStack_.pop_back();
+	memSize_ -= entry.size;
+	entry.command->redo();
+	pushUndo(std::move(entry.command));
+	shrink();
 }
 
 void CommandManager::clear()
 {
-	redoStack_ = std::stack<CommandIPtr>();
-	undoStack_ = std::stack<CommandIPtr>();
+	redoStack_.clear();
+	undoStack_.clear();
+	memSize_ = 0;
+	droppedCnt_ = 0;
+}
+
+void CommandManager::setMemoryLimit(size_t limit)
+{
+	memLimit_ = limit;
+	shrink();
+}
+
+size_t CommandManager::getMemoryLimit() const
+{
+	return memLimit_;
+}
+
+size_t CommandManager::getMemorySize() const
+{
+	return memSize_;
+}
+
+size_t CommandManager::getUndoCount() const
+{
+	return undoStack_.size();
+}
+
+size_t CommandManager::getRedoCount() const
+{
+	return redoStack_.size();
+}
+
+size_t CommandManager::getDroppedCount() const
+{
+	return droppedCnt_;
+}
+
+void CommandManager::pushUndo(CommandIPtr command)
+{
+	size_t size = command->getMemorySize();
+	memSize_ += size;
+	undoStack_.push_back({ std::move(command), size, false });
+
+	// Each push makes one command cross the boundary
+	if (undoStack_.size() > UNCOMPACTED_COUNT) {
+		compact(undoStack_[undoStack_.size() - UNCOMPACTED_COUNT - 1]);
+	}
+}
+
+void CommandManager::resize(Entry& entry)
+{
+	size_t size = entry.command->getMemorySize();
+	memSize_ = memSize_ - entry.size + size;
+	entry.size = size;
+}
+
+void CommandManager::compact(Entry& entry)
+{
+	if (entry.isCompacted) return;
+	entry.command->compact();
+	entry.isCompacted = true;
+	resize(entry);
+}
+
+void CommandManager::shrink()
+{
+	if (!memLimit_ || memSize_ <= memLimit_) return;
+
+	// Compaction keeps the history, so try it first on commands to redo
+	// and latest commands except the top. Older commands are compacted already
+	for (size_t i = 0; i < redoStack_.size() && memSize_ > memLimit_; ++i) {
+		compact(redoStack_[i]);
+	}
+	size_t i = (undoStack_.size() > UNCOMPACTED_COUNT + 1) ? undoStack_.size() - UNCOMPACTED_COUNT - 1 : 0;
+	for (; i + 1 < undoStack_.size() && memSize_ > memLimit_; ++i) {
+		compact(undoStack_[i]);
+	}
+
+	// The latest command is kept even if it is over the limit
+	while (memSize_ > memLimit_ && undoStack_.size() > 1) {
+		memSize_ -= undoStack_.front().size;
+		undoStack_.pop_front();
+		++droppedCnt_;
+	}
 }
@@ -1,9 +1,15 @@
 #pragma once
 
-#include <stack>
+#include <cstddef>
+#include <deque>
+#include <vector>
 #include <memory>
 #include "abstract_command.hpp"
 
+/// Undo history bounded by the approximate memory of commands.
+/// Commands older than UNCOMPACTED_COUNT are compacted. While the history is over the limit,
+/// commands to redo and newer commands except the latest are also compacted,
+/// and then the oldest commands are removed
 class CommandManager
 {
 public:
@@ -15,7 +21,35 @@ public:
 	void redo();
 	void clear();
 
+	/// limit: bytes, 0 (unlimited)
+	void setMemoryLimit(size_t limit);
+	size_t getMemoryLimit() const;
+	/// Approximate bytes held by commands in the history
+	size_t getMemorySize() const;
+	size_t getUndoCount() const;
+	size_t getRedoCount() const;
+	/// Number of commands removed by the limit since the last clear
+	size_t getDroppedCount() const;
+
+	static constexpr size_t DEF_MEMORY_LIMIT = 64 * 1024 * 1024;
+	/// Latest commands are kept as they are so that undo is fast
+	static constexpr size_t UNCOMPACTED_COUNT = 16;
+
 private:
-	std::stack<CommandIPtr> undoStack_;
-	std::stack<CommandIPtr> redoStack_;
+	struct Entry
+	{
+		CommandIPtr command;
+		size_t size;
+		bool isCompacted;
+	};
+	/// The back is the latest
+	std::deque<Entry> undoStack_;
+	std::vector<Entry> redoStack_;
+	size_t memLimit_, memSize_;
+	size_t droppedCnt_;
+
+	void pushUndo(CommandIPtr command);
+	void resize(Entry& entry);
+	void compact(Entry& entry);
+	void shrink();
 };
@@ -21,11 +21,15 @@ PasteCopiedDataToOrderCommand::PasteCopiedDataToOrderCommand(std::weak_ptr<Modul
 
 void PasteCopiedDataToOrderCommand::redo()
 {
+	packedCells_.unpack(cells_);
+	packedPrevCells_.unpack(prevCells_);
 	setCells(cells_);
 }
 
 void PasteCopiedDataToOrderCommand::undo()
 {
+	packedCells_.unpack(cells_);
+	packedPrevCells_.unpack(prevCells_);
 	setCells(prevCells_);
 }
 
@@ -34,6 +38,18 @@ int PasteCopiedDataToOrderCommand::getID() const
 	return 0x43;
 }
 
+size_t PasteCopiedDataToOrderCommand::getMemorySize() const
+{
+	return sizeof(*this) + PackedCells::getMemorySize(cells_) + PackedCells::getMemorySize(prevCells_)
+			+ packedCells_.getMemorySize() + packedPrevCells_.getMemorySize();
+}
+
+void PasteCopiedDataToOrderCommand::compact()
+{
+	packedCells_.pack(cells_);
+	packedPrevCells_.pack(prevCells_);
+}
+
 void PasteCopiedDataToOrderCommand::setCells(std::vector<std::vector<std::string>>& cells)
 {
 	auto& sng = mod_.lock()->getSong(song_);
@@ -0,0 +1,122 @@
+#include "packed_cells.hpp"
+
+namespace
+{
+	/// Strings up to this length are stored in the string object
+	constexpr size_t SHORT_STRING_CAPACITY = 15;
+}
+
+PackedCells::PackedCells() : isPacked_(false) {}
+
+void PackedCells::pack(std::vector<std::vector<std::string>>& cells)
+{
+	if (isPacked_) return;
+
+	data_.clear();
+	appendVarint(cells.size());
+	for (auto& row : cells) {
+		appendVarint(row.size());
+		for (auto& cell : row) {
+			int32_t n;
+			if (toNumber(cell, n)) {
+				// Zigzag encoding so that -1 (blank) is 1 byte
+				uint32_t zz = (static_cast<uint32_t>(n) << 1) ^ static_cast<uint32_t>(n >> 31);
+				appendVarint(static_cast<uint64_t>(zz) << 1);
+			}
+			else {
+				appendVarint((static_cast<uint64_t>(cell.size()) << 1) | 1);
+				data_.insert(data_.end(), cell.begin(), cell.end());
+			}
+		}
+	}
+	data_.shrink_to_fit();
+
+	std::vector<std::vector<std::string>>().swap(cells);
+	isPacked_ = true;
+}
+
+void PackedCells::unpack(std::vector<std::vector<std::string>>& cells)
+{
+	if (!isPacked_) return;
+
+	size_t csr = 0;
+	cells.resize(readVarint(csr));
+	for (auto& row : cells) {
+		row.resize(readVarint(csr));
+		for (auto& cell : row) {
+			uint64_t v = readVarint(csr);
+			if (v & 1) {
+				size_t len = v >> 1;
+				cell.assign(reinterpret_cast<const char*>(&data_[csr]), len);
+				csr += len;
+			}
+			else {
+				uint32_t zz = static_cast<uint32_t>(v >> 1);
+				cell = std::to_string(static_cast<int32_t>((zz >> 1) ^ (~(zz & 1) + 1)));
+			}
+		}
+	}
+
+	std::vector<uint8_t>().swap(data_);
+	isPacked_ = false;
+}
+
+bool PackedCells::isPacked() const
+{
+	return isPacked_;
+}
+
+size_t PackedCells::getMemorySize() const
+{
+	return data_.capacity();
+}
+
+size_t PackedCells::getMemorySize(const std::vector<std::vector<std::string>>& cells)
+{
+	size_t size = cells.capacity() * sizeof(std::vector<std::string>);
+	for (auto& row : cells) {
+		size += row.capacity() * sizeof(std::string);
+		for (auto& cell : row) {
+			if (cell.capacity() > SHORT_STRING_CAPACITY) size += cell.capacity() + 1;
+		}
+	}
+	return size;
+}
+
+void PackedCells::appendVarint(uint64_t v)
+{
+	while (v >= 0x80) {
+		data_.push_back(static_cast<uint8_t>(v) | 0x80);
+		v >>= 7;
+	}
+	data_.push_back(static_cast<uint8_t>(v));
+}
+
+uint64_t PackedCells::readVarint(size_t& csr) const
+{
+	uint64_t v = 0;
+	for (int shift = 0; ; shift += 7) {
+		uint8_t b = data_[csr++];
+		v |= static_cast<uint64_t>(b & 0x7f) << shift;
+		if (!(b & 0x80)) return v;
+	}
+}
+
+bool PackedCells::toNumber(const std::string& str, int32_t& n)
+{
+	size_t i = (!str.empty() && str.front() == '-') ? 1 : 0;
+	size_t digits = str.size() - i;
+	// Reject leading zeros and "-0", which are not restored
+	if (!digits || digits > 10 || (str[i] == '0' && (digits > 1 || i))) return false;
+
+	int64_t v = 0;
+	for (; i < str.size(); ++i) {
+		if (str[i] < '0' || str[i] > '9') return false;
+		v = v * 10 + (str[i] - '0');
+	}
+	if (str.front() == '-') v = -v;
+	if (v < INT32_MIN || v > INT32_MAX) return false;
+
+	n = static_cast<int32_t>(v);
+	return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string>
+
+/// Cells of a command packed into bytes to keep old commands in the undo history small.
+/// Cells are mostly stringified numbers and effect IDs, and numbers are packed as varints
+class PackedCells
+{
+public:
+	PackedCells();
+
+	/// Move the cells into the pack. The cells are cleared
+	void pack(std::vector<std::vector<std::string>>& cells);
+	/// Restore the cells if they are packed
+	void unpack(std::vector<std::vector<std::string>>& cells);
+	bool isPacked() const;
+	size_t getMemorySize() const;
+
+	/// Approximate bytes held by unpacked cells
+	static size_t getMemorySize(const std::vector<std::vector<std::string>>& cells);
+
+private:
+	bool isPacked_;
+	std::vector<uint8_t> data_;
+
+	void appendVarint(uint64_t v);
+	uint64_t readVarint(size_t& csr) const;
+	/// Return false if the string is not a number which is restored by std::to_string
+	static bool toNumber(const std::string& str, int32_t& n);
+};
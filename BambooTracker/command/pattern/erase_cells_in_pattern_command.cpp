@@ -95,6 +95,8 @@ EraseCellsInPatternCommand::EraseCellsInPatternCommand(std::weak_ptr<Module> mod
 
 void EraseCellsInPatternCommand::redo()
 {
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = bStep_;
@@ -149,6 +151,8 @@ void EraseCellsInPatternCommand::redo()
 
 void EraseCellsInPatternCommand::undo()
 {
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = bStep_;
@@ -216,3 +220,13 @@ int EraseCellsInPatternCommand::getID() const
 {
 	return 0x2e;
 }
+
+size_t EraseCellsInPatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + PackedCells::getMemorySize(prevCells_) + packedPrevCells_.getMemorySize();
+}
+
+void EraseCellsInPatternCommand::compact()
+{
+	packedPrevCells_.pack(prevCells_);
+}
@@ -95,6 +95,8 @@ ExpandPatternCommand::ExpandPatternCommand(std::weak_ptr<Module> mod,
 
 void ExpandPatternCommand::redo()
 {
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = bStep_;
@@ -182,6 +184,8 @@ void ExpandPatternCommand::redo()
 
 void ExpandPatternCommand::undo()
 {
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = bStep_;
@@ -249,3 +253,13 @@ int ExpandPatternCommand::getID() const
 {
 	return 0x34;
 }
+
+size_t ExpandPatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + PackedCells::getMemorySize(prevCells_) + packedPrevCells_.getMemorySize();
+}
+
+void ExpandPatternCommand::compact()
+{
+	packedPrevCells_.pack(prevCells_);
+}
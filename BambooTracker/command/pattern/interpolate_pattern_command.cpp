@@ -95,6 +95,8 @@ InterpolatePatternCommand::InterpolatePatternCommand(std::weak_ptr<Module> mod,
 
 void InterpolatePatternCommand::redo()
 {
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 	int div = prevCells_.size() - 1;
 	if (!div) div = 1;
@@ -220,6 +222,8 @@ void InterpolatePatternCommand::redo()
 
 void InterpolatePatternCommand::undo()
 {
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = bStep_;
@@ -287,3 +291,13 @@ int InterpolatePatternCommand::getID() const
 {
 	return 0x37;
 }
+
+size_t InterpolatePatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + PackedCells::getMemorySize(prevCells_) + packedPrevCells_.getMemorySize();
+}
+
+void InterpolatePatternCommand::compact()
+{
+	packedPrevCells_.pack(prevCells_);
+}
@@ -75,11 +75,15 @@ PasteCopiedDataToPatternCommand::PasteCopiedDataToPatternCommand(std::weak_ptr<M
 
 void PasteCopiedDataToPatternCommand::redo()
 {
+	packedCells_.unpack(cells_);
+	packedPrevCells_.unpack(prevCells_);
 	setCells(cells_);
 }
 
 void PasteCopiedDataToPatternCommand::undo()
 {
+	packedCells_.unpack(cells_);
+	packedPrevCells_.unpack(prevCells_);
 	setCells(prevCells_);
 }
 
@@ -88,6 +92,18 @@ int PasteCopiedDataToPatternCommand::getID() const
 	return 0x2d;
 }
 
+size_t PasteCopiedDataToPatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + PackedCells::getMemorySize(cells_) + PackedCells::getMemorySize(prevCells_)
+			+ packedCells_.getMemorySize() + packedPrevCells_.getMemorySize();
+}
+
+void PasteCopiedDataToPatternCommand::compact()
+{
+	packedCells_.pack(cells_);
+	packedPrevCells_.pack(prevCells_);
+}
+
 void PasteCopiedDataToPatternCommand::setCells(std::vector<std::vector<std::string>>& cells)
 {
 	auto& sng = mod_.lock()->getSong(song_);
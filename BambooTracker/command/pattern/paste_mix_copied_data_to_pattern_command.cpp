@@ -75,6 +75,9 @@ PasteMixCopiedDataToPatternCommand::PasteMixCopiedDataToPatternCommand(std::weak
 
 void PasteMixCopiedDataToPatternCommand::redo()
 {
+	packedCells_.unpack(cells_);
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = step_;
@@ -163,6 +166,9 @@ void PasteMixCopiedDataToPatternCommand::redo()
 
 void PasteMixCopiedDataToPatternCommand::undo()
 {
+	packedCells_.unpack(cells_);
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = step_;
@@ -230,3 +236,15 @@ int PasteMixCopiedDataToPatternCommand::getID() const
 {
 	return 0x2f;
 }
+
+size_t PasteMixCopiedDataToPatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + PackedCells::getMemorySize(cells_) + PackedCells::getMemorySize(prevCells_)
+			+ packedCells_.getMemorySize() + packedPrevCells_.getMemorySize();
+}
+
+void PasteMixCopiedDataToPatternCommand::compact()
+{
+	packedCells_.pack(cells_);
+	packedPrevCells_.pack(prevCells_);
+}
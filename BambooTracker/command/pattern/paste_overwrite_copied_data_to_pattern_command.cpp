@@ -75,6 +75,9 @@ PasteOverwriteCopiedDataToPatternCommand::PasteOverwriteCopiedDataToPatternComma
 
 void PasteOverwriteCopiedDataToPatternCommand::redo()
 {
+	packedCells_.unpack(cells_);
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = step_;
@@ -173,6 +176,9 @@ void PasteOverwriteCopiedDataToPatternCommand::redo()
 
 void PasteOverwriteCopiedDataToPatternCommand::undo()
 {
+	packedCells_.unpack(cells_);
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = step_;
@@ -240,3 +246,15 @@ int PasteOverwriteCopiedDataToPatternCommand::getID() const
 {
 	return 0x3a;
 }
+
+size_t PasteOverwriteCopiedDataToPatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + PackedCells::getMemorySize(cells_) + PackedCells::getMemorySize(prevCells_)
+			+ packedCells_.getMemorySize() + packedPrevCells_.getMemorySize();
+}
+
+void PasteOverwriteCopiedDataToPatternCommand::compact()
+{
+	packedCells_.pack(cells_);
+	packedPrevCells_.pack(prevCells_);
+}
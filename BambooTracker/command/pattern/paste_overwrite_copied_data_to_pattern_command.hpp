@@ -5,6 +5,7 @@
 #include <vector>
 #include <string>
 #include "module.hpp"
+#include "packed_cells.hpp"
 
 class PasteOverwriteCopiedDataToPatternCommand : public AbstractCommand
 {
@@ -14,9 +15,12 @@ public:
 	void redo() override;
 	void undo() override;
 	int getID() const override;
+	size_t getMemorySize() const override;
+	void compact() override;
 
 private:
 	std::weak_ptr<Module> mod_;
 	int song_, track_, col_, order_, step_;
 	std::vector<std::vector<std::string>> cells_, prevCells_;
+	PackedCells packedCells_, packedPrevCells_;
 };
@@ -95,6 +95,8 @@ ReversePatternCommand::ReversePatternCommand(std::weak_ptr<Module> mod,
 
 void ReversePatternCommand::redo()
 {
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	size_t l = prevCells_.size() - 1;
@@ -161,6 +163,8 @@ void ReversePatternCommand::redo()
 
 void ReversePatternCommand::undo()
 {
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = bStep_;
@@ -228,3 +232,13 @@ int ReversePatternCommand::getID() const
 {
 	return 0x38;
 }
+
+size_t ReversePatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + PackedCells::getMemorySize(prevCells_) + packedPrevCells_.getMemorySize();
+}
+
+void ReversePatternCommand::compact()
+{
+	packedPrevCells_.pack(prevCells_);
+}
@@ -95,6 +95,8 @@ ShrinkPatternCommand::ShrinkPatternCommand(std::weak_ptr<Module> mod,
 
 void ShrinkPatternCommand::redo()
 {
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = bStep_;
@@ -206,6 +208,8 @@ void ShrinkPatternCommand::redo()
 
 void ShrinkPatternCommand::undo()
 {
+	packedPrevCells_.unpack(prevCells_);
+
 	auto& sng = mod_.lock()->getSong(song_);
 
 	int s = bStep_;
@@ -273,3 +277,13 @@ int ShrinkPatternCommand::getID() const
 {
 	return 0x35;
 }
+
+size_t ShrinkPatternCommand::getMemorySize() const
+{
+	return sizeof(*this) + PackedCells::getMemorySize(prevCells_) + packedPrevCells_.getMemorySize();
+}
+
+void ShrinkPatternCommand::compact()
+{
+	packedPrevCells_.pack(prevCells_);
+}
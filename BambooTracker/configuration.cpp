@@ -1,4 +1,5 @@
 #include "configuration.hpp"
+#include <algorithm>
 
 Configuration::Configuration()
 {
@@ -23,9 +24,13 @@ Configuration::Configuration()
 	showPrevNextOrders_ = true;
 	backupModules_ = true;
 	dontSelectOnDoubleClick_ = false;
+	autosaveModules_ = true;
+	autosaveInterval_ = 300;
 
 	// Edit settings
 	pageJumpLength_ = 4;
+	modCompLevel_ = 0;
+	undoMemLimit_ = 64;
 
 	// Sonud //
 	sndDevice_ = u8"";
@@ -206,6 +211,27 @@ bool Configuration::getDontSelectOnDoubleClick() const
 	return dontSelectOnDoubleClick_;
 }
 
+void Configuration::setAutosaveModules(bool enabled)
+{
+	autosaveModules_ = enabled;
+}
+
+bool Configuration::getAutosaveModules() const
+{
+	return autosaveModules_;
+}
+
+void Configuration::setAutosaveInterval(int interval)
+{
+	// Keep the interval in milliseconds within int for QTimer
+	autosaveInterval_ = std::min(std::max(interval, 0), 86400);
+}
+
+int Configuration::getAutosaveInterval() const
+{
+	return autosaveInterval_;
+}
+
 // Edit settings
 void Configuration::setPageJumpLength(size_t length)
 {
@@ -217,6 +243,26 @@ size_t Configuration::getPageJumpLength() const
 	return pageJumpLength_;
 }
 
+void Configuration::setModuleCompressionLevel(int level)
+{
+	modCompLevel_ = level;
+}
+
+int Configuration::getModuleCompressionLevel() const
+{
+	return modCompLevel_;
+}
+
+void Configuration::setUndoMemoryLimit(int limit)
+{
+	undoMemLimit_ = limit;
+}
+
+int Configuration::getUndoMemoryLimit() const
+{
+	return undoMemLimit_;
+}
+
 // Sound //
 void Configuration::setSoundDevice(std::string device)
 {
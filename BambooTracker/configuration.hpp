@@ -57,17 +57,33 @@ public:
 	bool getBackupModules() const;
 	void setDontSelectOnDoubleClick(bool enabled);
 	bool getDontSelectOnDoubleClick() const;
+	void setAutosaveModules(bool enabled);
+	bool getAutosaveModules() const;
+	/// In seconds, 0: disabled. It is clamped to 0-86400
+	void setAutosaveInterval(int interval);
+	int getAutosaveInterval() const;
 private:
 	bool warpCursor_, warpAcrossOrders_;
 	bool showRowNumHex_, showPrevNextOrders_;
 	bool backupModules_, dontSelectOnDoubleClick_;
+	bool autosaveModules_;
+	int autosaveInterval_;
 
 	// Edit settings
 public:
 	void setPageJumpLength(size_t length);
 	size_t getPageJumpLength() const;
+	/// 0: uncompressed, 1-9: compressed.
+	/// Compressed modules are about 70% of the size. Tracks are decompressed when each song is opened
+	void setModuleCompressionLevel(int level);
+	int getModuleCompressionLevel() const;
+	/// Memory limit of the undo history in MiB, 0: unlimited
+	void setUndoMemoryLimit(int limit);
+	int getUndoMemoryLimit() const;
 private:
 	size_t pageJumpLength_;
+	int modCompLevel_;
+	int undoMemLimit_;
 
 	// Sound //
 public:
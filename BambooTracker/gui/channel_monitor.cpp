@@ -0,0 +1,99 @@
+#include "channel_monitor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <QPainter>
+#include <QPointF>
+#include <QVector>
+
+ChannelMonitor::ChannelMonitor(QWidget *parent)
+	: QWidget(parent),
+	  frame_(nullptr)
+{
+	std::fill(std::begin(peakHold_), std::end(peakHold_), 0.0f);
+
+	QObject::connect(&timer_, &QTimer::timeout, this, &ChannelMonitor::onTimeout);
+	timer_.start(REFRESH_MS_);
+}
+
+void ChannelMonitor::setMonitor(std::shared_ptr<chip::OutputMonitor> monitor)
+{
+	monitor_ = monitor;
+	frame_ = nullptr;
+}
+
+void ChannelMonitor::setColorPallete(std::weak_ptr<ColorPalette> palette)
+{
+	palette_ = palette;
+}
+
+void ChannelMonitor::onTimeout()
+{
+	if (!monitor_ || !monitor_->hasNewFrame()) return;
+
+	frame_ = &monitor_->getLatestFrame();
+	for (int ch = 0; ch < chip::MonitorFrame::CHANNEL_COUNT; ++ch) {
+		peakHold_[ch] = std::max(peakHold_[ch] * 0.9f, frame_->peak[ch]);
+	}
+	update();
+}
+
+void ChannelMonitor::paintEvent(QPaintEvent* event)
+{
+	Q_UNUSED(event)
+
+	auto palette = palette_.lock();
+	if (!palette) return;
+
+	static const char* NAMES[chip::MonitorFrame::CHANNEL_COUNT] = {
+		"FM1", "FM2", "FM3", "FM4", "FM5", "FM6", "SSG1", "SSG2", "SSG3", "RHY"
+	};
+
+	QPainter painter(this);
+	painter.fillRect(rect(), palette->monBackColor);
+
+	const int cnt = chip::MonitorFrame::CHANNEL_COUNT;
+	const int colWidth = width() / cnt;
+	const int h = height();
+	for (int ch = 0; ch < cnt; ++ch) {
+		int x = ch * colWidth;
+		int scopeWidth = colWidth - METER_WIDTH_ - 2;
+
+		// Level meter
+		if (frame_) {
+			int rmsH = static_cast<int>(h * levelToRatio(frame_->rms[ch]));
+			painter.fillRect(x + scopeWidth, h - rmsH, METER_WIDTH_, rmsH, palette->monMeterColor);
+			int peakY = h - static_cast<int>(h * levelToRatio(peakHold_[ch]));
+			painter.setPen(palette->monPeakColor);
+			painter.drawLine(x + scopeWidth, peakY, x + scopeWidth + METER_WIDTH_ - 1, peakY);
+		}
+
+		// Oscilloscope
+		if (frame_) {
+			const float* wave = frame_->wave[ch];
+			QVector<QPointF> points(chip::MonitorFrame::WAVE_SIZE);
+			float xStep = static_cast<float>(scopeWidth) / chip::MonitorFrame::WAVE_SIZE;
+			float center = h / 2.0f;
+			for (size_t i = 0; i < chip::MonitorFrame::WAVE_SIZE; ++i) {
+				// Taps are quiet beside full scale mix, so amplify them 4 times
+				float y = center - std::max(-1.0f, std::min(1.0f, wave[i] * 4.0f)) * center;
+				points[static_cast<int>(i)] = QPointF(x + i * xStep, y);
+			}
+			painter.setPen(palette->monWaveColor);
+			painter.drawPolyline(points.data(), points.size());
+		}
+
+		painter.setPen(palette->monTextColor);
+		painter.drawText(x + 2, painter.fontMetrics().ascent(), NAMES[ch]);
+		painter.setPen(palette->monBorderColor);
+		painter.drawLine(x + colWidth - 1, 0, x + colWidth - 1, h);
+	}
+}
+
+/// Map -48dB to 0dB into 0.0 to 1.0
+float ChannelMonitor::levelToRatio(float level)
+{
+	if (level <= 0.0f) return 0.0f;
+	float db = 20.0f * std::log10(level);
+	return std::max(0.0f, std::min(1.0f, (db + 48.0f) / 48.0f));
+}
@@ -0,0 +1,41 @@
+#ifndef CHANNEL_MONITOR_HPP
+#define CHANNEL_MONITOR_HPP
+
+#include <QWidget>
+#include <QTimer>
+#include <QPaintEvent>
+#include <memory>
+#include "output_monitor.hpp"
+#include "gui/color_palette.hpp"
+
+/// Oscilloscopes and level meters of chip channels.
+/// It polls the output monitor on a display timer and never touches the audio thread
+class ChannelMonitor : public QWidget
+{
+	Q_OBJECT
+
+public:
+	explicit ChannelMonitor(QWidget *parent = nullptr);
+
+	void setMonitor(std::shared_ptr<chip::OutputMonitor> monitor);
+	void setColorPallete(std::weak_ptr<ColorPalette> palette);
+
+protected:
+	void paintEvent(QPaintEvent* event) override;
+
+private:
+	std::shared_ptr<chip::OutputMonitor> monitor_;
+	std::weak_ptr<ColorPalette> palette_;
+	QTimer timer_;
+	const chip::MonitorFrame* frame_;
+	/// Displayed peak levels falling slowly
+	float peakHold_[chip::MonitorFrame::CHANNEL_COUNT];
+
+	static constexpr int REFRESH_MS_ = 33;
+	static constexpr int METER_WIDTH_ = 6;
+
+	void onTimeout();
+	static float levelToRatio(float level);
+};
+
+#endif // CHANNEL_MONITOR_HPP
@@ -78,4 +78,12 @@ ColorPalette::ColorPalette()
 	ptnBorderColor = QColor::fromRgb(120, 120, 120, 255);
 	ptnMuteColor = QColor::fromRgb(255, 0, 0, 255);
 	ptnUnmuteColor = QColor::fromRgb(0, 255, 0, 255);
+
+	// Channel monitor
+	monBackColor = QColor::fromRgb(0, 0, 40, 255);
+	monWaveColor = QColor::fromRgb(210, 230, 64, 255);
+	monMeterColor = QColor::fromRgb(42, 187, 155, 255);
+	monPeakColor = QColor::fromRgb(226, 156, 80, 255);
+	monTextColor = QColor::fromRgb(240, 240, 200, 255);
+	monBorderColor = QColor::fromRgb(120, 120, 120, 255);
 }
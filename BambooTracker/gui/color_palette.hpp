@@ -53,6 +53,11 @@ public:
 	QColor ptnMaskColor;
 	QColor ptnBorderColor;
 	QColor ptnMuteColor, ptnUnmuteColor;
+
+	// Channel monitor
+	QColor monBackColor, monWaveColor;
+	QColor monMeterColor, monPeakColor;
+	QColor monTextColor, monBorderColor;
 };
 
 #endif // COLOR_PALETTE_HPP
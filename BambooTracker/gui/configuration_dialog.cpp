@@ -27,9 +27,12 @@ ConfigurationDialog::ConfigurationDialog(std::weak_ptr<Configuration> config, QW
 	ui->generalSettingsListWidget->item(3)->setCheckState(toCheckState(config.lock()->getShowPreviousNextOrders()));
 	ui->generalSettingsListWidget->item(4)->setCheckState(toCheckState(config.lock()->getBackupModules()));
 	ui->generalSettingsListWidget->item(5)->setCheckState(toCheckState(config.lock()->getDontSelectOnDoubleClick()));
+	ui->generalSettingsListWidget->item(6)->setCheckState(toCheckState(config.lock()->getAutosaveModules()));
 
 	// Edit settings
 	ui->pageJumpLengthSpinBox->setValue(config.lock()->getPageJumpLength());
+	ui->moduleCompressionSpinBox->setValue(config.lock()->getModuleCompressionLevel());
+	ui->undoMemoryLimitSpinBox->setValue(config.lock()->getUndoMemoryLimit());
 
 	// Sound //
 	int devRow = -1;
@@ -76,9 +79,12 @@ void ConfigurationDialog::on_ConfigurationDialog_accepted()
 	config_.lock()->setShowPreviousNextOrders(fromCheckState(ui->generalSettingsListWidget->item(3)->checkState()));
 	config_.lock()->setBackupModules(fromCheckState(ui->generalSettingsListWidget->item(4)->checkState()));
 	config_.lock()->setDontSelectOnDoubleClick(fromCheckState(ui->generalSettingsListWidget->item(5)->checkState()));
+	config_.lock()->setAutosaveModules(fromCheckState(ui->generalSettingsListWidget->item(6)->checkState()));
 
 	// Edit settings
 	config_.lock()->setPageJumpLength(ui->pageJumpLengthSpinBox->value());
+	config_.lock()->setModuleCompressionLevel(ui->moduleCompressionSpinBox->value());
+	config_.lock()->setUndoMemoryLimit(ui->undoMemoryLimitSpinBox->value());
 
 	// Sound //
 	config_.lock()->setSoundDevice(ui->soundDeviceComboBox->currentText().toUtf8().toStdString());
@@ -558,7 +558,7 @@ void InstrumentEditorFMForm::updateInstrumentParameters()
 // MUST DIRECT CONNECTION
 void InstrumentEditorFMForm::keyPressEvent(QKeyEvent *event)
 {
-	// For jam key on
+	// For instrument preview
 	// General keys
 	switch (event->key()) {
 	case Qt::Key_Asterisk:	emit octaveChanged(true);	break;
@@ -572,38 +572,36 @@ void InstrumentEditorFMForm::keyPressEvent(QKeyEvent *event)
 		if (!event->isAutoRepeat()) {
 			// Musical keyboard
 			switch (event->key()) {
-			case Qt::Key_Z:
-			case Qt::Key_S:
-			case Qt::Key_X:
-			case Qt::Key_D:
-			case Qt::Key_C:
-			case Qt::Key_V:
-			case Qt::Key_G:
-			case Qt::Key_B:
-			case Qt::Key_H:
-			case Qt::Key_N:
-			case Qt::Key_J:
-			case Qt::Key_M:
-			case Qt::Key_Comma:
-			case Qt::Key_L:
-			case Qt::Key_Period:
-			case Qt::Key_Q:
-			case Qt::Key_2:
-			case Qt::Key_W:
-			case Qt::Key_3:
-			case Qt::Key_E:
-			case Qt::Key_R:
-			case Qt::Key_5:
-			case Qt::Key_T:
-			case Qt::Key_6:
-			case Qt::Key_Y:
-			case Qt::Key_7:
-			case Qt::Key_U:
-			case Qt::Key_I:
-			case Qt::Key_9:
-			case Qt::Key_O:
-				emit jamKeyOnEvent(event);
-				break;
+			case Qt::Key_Z:			previewInstrument(JamKey::LOW_C);		break;
+			case Qt::Key_S:			previewInstrument(JamKey::LOW_CS);		break;
+			case Qt::Key_X:			previewInstrument(JamKey::LOW_D);		break;
+			case Qt::Key_D:			previewInstrument(JamKey::LOW_DS);		break;
+			case Qt::Key_C:			previewInstrument(JamKey::LOW_E);		break;
+			case Qt::Key_V:			previewInstrument(JamKey::LOW_F);		break;
+			case Qt::Key_G:			previewInstrument(JamKey::LOW_FS);		break;
+			case Qt::Key_B:			previewInstrument(JamKey::LOW_G);		break;
+			case Qt::Key_H:			previewInstrument(JamKey::LOW_GS);		break;
+			case Qt::Key_N:			previewInstrument(JamKey::LOW_A);		break;
+			case Qt::Key_J:			previewInstrument(JamKey::LOW_AS);		break;
+			case Qt::Key_M:			previewInstrument(JamKey::LOW_B);		break;
+			case Qt::Key_Comma:		previewInstrument(JamKey::LOW_C_H);		break;
+			case Qt::Key_L:			previewInstrument(JamKey::LOW_CS_H);	break;
+			case Qt::Key_Period:	previewInstrument(JamKey::LOW_D_H);		break;
+			case Qt::Key_Q:			previewInstrument(JamKey::HIGH_C);		break;
+			case Qt::Key_2:			previewInstrument(JamKey::HIGH_CS);		break;
+			case Qt::Key_W:			previewInstrument(JamKey::HIGH_D);		break;
+			case Qt::Key_3:			previewInstrument(JamKey::HIGH_DS);		break;
+			case Qt::Key_E:			previewInstrument(JamKey::HIGH_E);		break;
+			case Qt::Key_R:			previewInstrument(JamKey::HIGH_F);		break;
+			case Qt::Key_5:			previewInstrument(JamKey::HIGH_FS);		break;
+			case Qt::Key_T:			previewInstrument(JamKey::HIGH_G);		break;
+			case Qt::Key_6:			previewInstrument(JamKey::HIGH_GS);		break;
+			case Qt::Key_Y:			previewInstrument(JamKey::HIGH_A);		break;
+			case Qt::Key_7:			previewInstrument(JamKey::HIGH_AS);		break;
+			case Qt::Key_U:			previewInstrument(JamKey::HIGH_B);		break;
+			case Qt::Key_I:			previewInstrument(JamKey::HIGH_C_H);	break;
+			case Qt::Key_9:			previewInstrument(JamKey::HIGH_CS_H);	break;
+			case Qt::Key_O:			previewInstrument(JamKey::HIGH_D_H);	break;
 			default: break;
 			}
 		}
@@ -611,47 +609,10 @@ void InstrumentEditorFMForm::keyPressEvent(QKeyEvent *event)
 	}
 }
 
-// MUST DIRECT CONNECTION
-void InstrumentEditorFMForm::keyReleaseEvent(QKeyEvent *event)
+void InstrumentEditorFMForm::previewInstrument(JamKey key)
 {
-	// For jam key off
-	if (!event->isAutoRepeat()) {
-		switch (event->key()) {
-		case Qt::Key_Z:
-		case Qt::Key_S:
-		case Qt::Key_X:
-		case Qt::Key_D:
-		case Qt::Key_C:
-		case Qt::Key_V:
-		case Qt::Key_G:
-		case Qt::Key_B:
-		case Qt::Key_H:
-		case Qt::Key_N:
-		case Qt::Key_J:
-		case Qt::Key_M:
-		case Qt::Key_Comma:
-		case Qt::Key_L:
-		case Qt::Key_Period:
-		case Qt::Key_Q:
-		case Qt::Key_2:
-		case Qt::Key_W:
-		case Qt::Key_3:
-		case Qt::Key_E:
-		case Qt::Key_R:
-		case Qt::Key_5:
-		case Qt::Key_T:
-		case Qt::Key_6:
-		case Qt::Key_Y:
-		case Qt::Key_7:
-		case Qt::Key_U:
-		case Qt::Key_I:
-		case Qt::Key_9:
-		case Qt::Key_O:
-			emit jamKeyOffEvent(event);
-			break;
-		default: break;
-		}
-	}
+	// Rendered on the preview chip apart from the playback chip and jam mode
+	bt_.lock()->previewInstrument(instNum_, key);
 }
 
 void InstrumentEditorFMForm::showEvent(QShowEvent* event)
@@ -27,8 +27,6 @@ public:
 	void setColorPalette(std::shared_ptr<ColorPalette> palette);
 
 signals:
-	void jamKeyOnEvent(QKeyEvent* event);
-	void jamKeyOffEvent(QKeyEvent* event);
 	void octaveChanged(bool upFlag);
 	void modified();
 	/// 0: play song
@@ -40,7 +38,6 @@ signals:
 
 protected:
 	void keyPressEvent(QKeyEvent* event) override;
-	void keyReleaseEvent(QKeyEvent* event) override;
 	void showEvent(QShowEvent* event) override;
 	void resizeEvent(QResizeEvent* event) override;
 
@@ -52,6 +49,8 @@ private:
 	std::weak_ptr<BambooTracker> bt_;
 	std::shared_ptr<ColorPalette> palette_;
 
+	void previewInstrument(JamKey key);
+
 	ReleaseType convertReleaseTypeForData(VisualizedInstrumentMacroEditor::ReleaseType type);
 	VisualizedInstrumentMacroEditor::ReleaseType convertReleaseTypeForUI(ReleaseType type);
 
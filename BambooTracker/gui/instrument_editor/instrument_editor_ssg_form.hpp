@@ -25,8 +25,6 @@ public:
 	void setColorPalette(std::shared_ptr<ColorPalette> palette);
 
 signals:
-	void jamKeyOnEvent(QKeyEvent* event);
-	void jamKeyOffEvent(QKeyEvent* event);
 	void octaveChanged(bool upFlag);
 	void modified();
 	/// 0: play song
@@ -38,7 +36,6 @@ signals:
 
 protected:
 	void keyPressEvent(QKeyEvent* event) override;
-	void keyReleaseEvent(QKeyEvent* event) override;
 
 private:
 	Ui::InstrumentEditorSSGForm *ui;
@@ -47,6 +44,8 @@ private:
 
 	std::weak_ptr<BambooTracker> bt_;
 
+	void previewInstrument(JamKey key);
+
 	ReleaseType convertReleaseTypeForData(VisualizedInstrumentMacroEditor::ReleaseType type);
 	VisualizedInstrumentMacroEditor::ReleaseType convertReleaseTypeForUI(ReleaseType type);
 
@@ -33,9 +33,13 @@ bool Json::saveConfiguration(std::weak_ptr<Configuration> config)
 		obj["showPreviousNextOrders"] = config.lock()->getShowPreviousNextOrders();
 		obj["backupModule"] = config.lock()->getBackupModules();
 		obj["dontSelectOnDoubleClick"] = config.lock()->getDontSelectOnDoubleClick();
+		obj["autosaveModule"] = config.lock()->getAutosaveModules();
+		obj["autosaveInterval"] = config.lock()->getAutosaveInterval();
 
 		// Edit settings
 		obj["pageJumpLength"] = static_cast<int>(config.lock()->getPageJumpLength());
+		obj["moduleCompressionLevel"] = config.lock()->getModuleCompressionLevel();
+		obj["undoMemoryLimit"] = config.lock()->getUndoMemoryLimit();
 
 		// Sound //
 		obj["soundDevice"] = QString::fromUtf8(config.lock()->getSoundDevice().c_str(),
@@ -83,9 +87,13 @@ bool Json::loadConfiguration(std::weak_ptr<Configuration> config)
 		config.lock()->setShowPreviousNextOrders(obj["showPreviousNextOrders"].toBool());
 		config.lock()->setBackupModules(obj["backupModule"].toBool());
 		config.lock()->setDontSelectOnDoubleClick(obj["dontSelectOnDoubleClick"].toBool());
+		config.lock()->setAutosaveModules(obj["autosaveModule"].toBool(true));
+		config.lock()->setAutosaveInterval(obj["autosaveInterval"].toInt(300));
 
 		// Edit settings
 		config.lock()->setPageJumpLength(static_cast<size_t>(obj["pageJumpLength"].toInt()));
+		config.lock()->setModuleCompressionLevel(obj["moduleCompressionLevel"].toInt());
+		config.lock()->setUndoMemoryLimit(obj["undoMemoryLimit"].toInt(64));
 
 		// Sound //
 		config.lock()->setSoundDevice(obj["soundDevice"].toString().toUtf8().toStdString());
@@ -8,12 +8,18 @@
 #include <QDialog>
 #include <QRegularExpression>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QFile>
 #include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QStandardPaths>
 #include <QMimeData>
 #include <QProgressDialog>
 #include <QRect>
 #include <QDesktopWidget>
 #include <QAudioDeviceInfo>
+#include <algorithm>
 #include "ui_mainwindow.h"
 #include "jam_manager.hpp"
 #include "song.hpp"
@@ -66,8 +72,10 @@ MainWindow::MainWindow(QWidget *parent) :
 	QObject::connect(comStack_.get(), &QUndoStack::indexChanged,
 					 this, [&](int idx) {
 		setWindowModified(idx || isModifiedForNotCommand_);
-		ui->actionUndo->setEnabled(comStack_->canUndo());
+		// Old commands in the core may be removed by the memory limit
+		ui->actionUndo->setEnabled(comStack_->canUndo() && bt_->canUndo());
 		ui->actionRedo->setEnabled(comStack_->canRedo());
+		statusUndo_->setText(QString("Undo: %1KiB").arg(bt_->getCommandHistoryMemorySize() / 1024));
 	});
 
 	/* Audio stream */
@@ -98,7 +106,7 @@ MainWindow::MainWindow(QWidget *parent) :
 		}
 	}, Qt::DirectConnection);
 	QObject::connect(stream_.get(), &AudioStream::bufferPrepared,
-					 this, [&](int16_t *container, size_t nSamples) {
+					 this, [&](float *container, size_t nSamples) {
 		bt_->getStreamSamples(container, nSamples);
 	}, Qt::DirectConnection);
 
@@ -267,6 +275,12 @@ MainWindow::MainWindow(QWidget *parent) :
 	QObject::connect(ui->orderList, &OrderListEditor::returnPressed,
 					 this, &MainWindow::startPlaySong);
 
+	/* Channel monitor */
+	auto monitor = std::make_shared<chip::OutputMonitor>();
+	bt_->setOutputMonitor(monitor);
+	ui->channelMonitor->setMonitor(monitor);
+	ui->channelMonitor->setColorPallete(palette_);
+
 	/* Status bar */
 	statusDetail_ = new QLabel();
 	statusStyle_ = new QLabel();
@@ -274,14 +288,43 @@ MainWindow::MainWindow(QWidget *parent) :
 	statusOctave_ = new QLabel();
 	statusIntr_ = new QLabel();
 	statusPlayPos_ = new QLabel();
+	statusAudio_ = new QLabel();
+	statusUndo_ = new QLabel();
 	ui->statusBar->addWidget(statusDetail_, 5);
 	ui->statusBar->addPermanentWidget(statusStyle_, 1);
 	ui->statusBar->addPermanentWidget(statusInst_, 1);
 	ui->statusBar->addPermanentWidget(statusOctave_, 1);
 	ui->statusBar->addPermanentWidget(statusIntr_, 1);
 	ui->statusBar->addPermanentWidget(statusPlayPos_, 1);
+	ui->statusBar->addPermanentWidget(statusAudio_, 2);
+	ui->statusBar->addPermanentWidget(statusUndo_, 1);
 	statusOctave_->setText(QString("Octave: ") + QString::number(bt_->getCurrentOctave()));
 	statusIntr_->setText(QString::number(bt_->getModuleTickFrequency()) + QString("Hz"));
+	statusUndo_->setText(QString("Undo: 0KiB"));
+
+	/* Audio statistics */
+	audioStat_ = std::make_unique<AudioProfiler::Snapshot>();
+	AudioProfiler::getSnapshot(*audioStat_);
+	audioStatTimer_ = new QTimer(this);
+	QObject::connect(audioStatTimer_, &QTimer::timeout, this, &MainWindow::updateAudioStatistics);
+	audioStatTimer_->start(1000);
+
+	/* Autosave */
+	autosaveTimer_ = new QTimer(this);
+	QObject::connect(autosaveTimer_, &QTimer::timeout, this, &MainWindow::autosaveModule);
+	if (int interval = config_->getAutosaveInterval()) autosaveTimer_->start(interval * 1000);
+	autosavePollTimer_ = new QTimer(this);
+	QObject::connect(autosavePollTimer_, &QTimer::timeout, this, &MainWindow::checkAutosaveResult);
+
+	/* Instrument library */
+	instLib_ = std::make_unique<InstrumentLibrary>();
+	QString libIndex = getInstrumentLibraryIndexPath();
+	if (!libIndex.isEmpty() && instLib_->loadIndex(libIndex.toStdString())) {
+		// Directories of the last session are restored from the indexed files
+		for (auto& entry : instLib_->search(""))
+			addInstrumentLibraryDirectory(QFileInfo(QString::fromStdString(entry.path)).absolutePath());
+		instLib_->scanInBackground(instLibDirs_);
+	}
 
 	/* Clipboard */
 	QObject::connect(QApplication::clipboard(), &QClipboard::dataChanged,
@@ -291,10 +334,16 @@ MainWindow::MainWindow(QWidget *parent) :
 	});
 
 	loadModule();
+	// Ask after the window is shown
+	QTimer::singleShot(0, this, &MainWindow::recoverAutosaveFile);
 }
 
 MainWindow::~MainWindow()
 {
+	instLib_->cancelScan();
+	QString libIndex = getInstrumentLibraryIndexPath();
+	if (!libIndex.isEmpty() && QDir().mkpath(QFileInfo(libIndex).path()))
+		instLib_->saveIndex(libIndex.toStdString());
 	delete ui;
 }
 
@@ -471,6 +520,8 @@ void MainWindow::dropEvent(QDropEvent* event)
 		loadModule();
 		isModifiedForNotCommand_ = false;
 		setWindowModified(false);
+		removeAutosaveFile();
+		recoverAutosaveFile();
 	}
 	else {
 		QMessageBox::critical(this, "Error", "Failed to load module.");
@@ -520,6 +571,7 @@ void MainWindow::closeEvent(QCloseEvent *event)
 			break;
 		}
 	}
+	removeAutosaveFile();
 
 	if (isMaximized()) {
 		config_->setMainWindowMaximized(true);
@@ -642,7 +694,35 @@ void MainWindow::loadInstrument()
 	QString file = QFileDialog::getOpenFileName(this, "Open instrument", "./",
 												"BambooTracker instrument file (*.bti)");
 	if (file.isNull()) return;
+	loadInstrumentFile(file);
+}
+
+void MainWindow::loadInstrumentFromLibrary()
+{
+	// Only files edited after the last scan are read again
+	instLib_->waitForScan();
+	instLib_->scanInBackground(instLibDirs_);
+	instLib_->waitForScan();
 
+	auto entries = instLib_->search("", bt_->getCurrentTrackAttribute().source);
+	if (entries.empty()) {
+		QMessageBox::information(this, "Instrument library",
+								 "No instrument is found in the directories of loaded or saved instruments.");
+		return;
+	}
+	QStringList items;
+	for (auto& entry : entries) {
+		items << QString::fromUtf8(entry.name.c_str(), entry.name.length())
+				 + " (" + QString::fromStdString(entry.path) + ")";
+	}
+	bool isSelected;
+	QString item = QInputDialog::getItem(this, "Load from library", "Instrument:", items, 0, false, &isSelected);
+	if (!isSelected) return;
+	loadInstrumentFile(QString::fromStdString(entries.at(items.indexOf(item)).path));
+}
+
+void MainWindow::loadInstrumentFile(QString file)
+{
 	int n = bt_->findFirstFreeInstrumentNumber();
 	if (n != -1 && bt_->loadInstrument(file.toStdString(), n)) {
 		auto inst = bt_->getInstrument(n);
@@ -650,6 +730,8 @@ void MainWindow::loadInstrument()
 		comStack_->push(new AddInstrumentQtCommand(ui->instrumentListWidget, n,
 												   QString::fromUtf8(name.c_str(), name.length()),
 												   inst->getSoundSource(), instForms_));
+		if (addInstrumentLibraryDirectory(QFileInfo(file).absolutePath()))
+			instLib_->scanInBackground(instLibDirs_);
 	}
 	else {
 		QMessageBox::critical(this, "Error", "Failed to load instrument.");
@@ -666,11 +748,42 @@ void MainWindow::saveInstrument()
 	if (!bt_->saveInstrument(file.toStdString(),
 							 ui->instrumentListWidget->currentItem()->data(Qt::UserRole).toInt()))
 		QMessageBox::critical(this, "Error", "Failed to save instrument.");
+	else if (addInstrumentLibraryDirectory(QFileInfo(file).absolutePath()))
+		instLib_->scanInBackground(instLibDirs_);
+}
+
+/********** Instrument library **********/
+QString MainWindow::getInstrumentLibraryIndexPath() const
+{
+	QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+	return (dir.isEmpty() ? QString() : QDir(dir).filePath("instrument_library.idx"));
+}
+
+bool MainWindow::addInstrumentLibraryDirectory(QString dir)
+{
+	std::string path = QDir::toNativeSeparators(QDir::cleanPath(dir)).toStdString();
+	std::string sep = QString(QDir::separator()).toStdString();
+	auto isInside = [&sep](const std::string& child, const std::string& parent) {
+		std::string prefix = (parent.size() >= sep.size() && parent.compare(parent.size() - sep.size(), sep.size(), sep) == 0)
+							 ? parent : parent + sep;	// Root directory has the separator
+		return (child == parent || child.compare(0, prefix.size(), prefix) == 0);
+	};
+
+	// Subdirectories are scanned with their parent
+	for (auto& d : instLibDirs_) {
+		if (isInside(path, d)) return false;
+	}
+	instLibDirs_.erase(std::remove_if(instLibDirs_.begin(), instLibDirs_.end(),
+									  [&](const std::string& d) { return isInside(d, path); }),
+					   instLibDirs_.end());
+	instLibDirs_.push_back(path);
+	return true;
 }
 
 /********** Undo-Redo **********/
 void MainWindow::undo()
 {
+	if (!bt_->canUndo()) return;
 	bt_->undo();
 	comStack_->undo();
 }
@@ -719,8 +832,8 @@ void MainWindow::loadModule()
 
 	// Clear records
 	QApplication::clipboard()->clear();
-	comStack_->clear();
 	bt_->clearCommandHistory();
+	comStack_->clear();
 }
 
 void MainWindow::loadSong()
@@ -829,6 +942,8 @@ void MainWindow::changeConfiguration()
 	stream_->setDevice(
 				QString::fromUtf8(config_->getSoundDevice().c_str(), config_->getSoundDevice().length()));
 	bt_->changeConfiguration(config_);
+	if (int interval = config_->getAutosaveInterval()) autosaveTimer_->start(interval * 1000);
+	else autosaveTimer_->stop();
 
 	update();
 }
@@ -872,6 +987,7 @@ void MainWindow::on_instrumentListWidget_customContextMenuRequested(const QPoint
 	QAction* dClone = menu.addAction("Deep clone", this, &MainWindow::deepCloneInstrument);
     menu.addSeparator();
 	QAction* ldFile = menu.addAction("Load from file...", this, &MainWindow::loadInstrument);
+	QAction* ldLib = menu.addAction("Load from library...", this, &MainWindow::loadInstrumentFromLibrary);
 	QAction* svFile = menu.addAction("Save to file...", this, &MainWindow::saveInstrument);
     menu.addSeparator();
 	QAction* edit = menu.addAction("Edit...", this, &MainWindow::editInstrument);
@@ -879,10 +995,14 @@ void MainWindow::on_instrumentListWidget_customContextMenuRequested(const QPoint
 	if (bt_->findFirstFreeInstrumentNumber() == -1) {    // Max size
 		add->setEnabled(false);
 		ldFile->setEnabled(false);
+		ldLib->setEnabled(false);
 	}
 	else {
 		switch (bt_->getCurrentTrackAttribute().source) {
-		case SoundSource::DRUM:	add->setEnabled(false);	break;
+		case SoundSource::DRUM:
+			add->setEnabled(false);
+			ldLib->setEnabled(false);	// Library is searched for the sound source of the track
+			break;
 		default:	break;
 		}
 	}
@@ -953,10 +1073,6 @@ void MainWindow::onInstrumentListWidgetItemAdded(const QModelIndex &parent, int
 						 instForms_.get(), &InstrumentFormManager::onInstrumentFMPitchNumberChanged);
 		QObject::connect(fmForm, &InstrumentEditorFMForm::pitchParameterChanged,
 						 instForms_.get(), &InstrumentFormManager::onInstrumentFMPitchParameterChanged);
-		QObject::connect(fmForm, &InstrumentEditorFMForm::jamKeyOnEvent,
-						 this, &MainWindow::keyPressEvent, Qt::DirectConnection);
-		QObject::connect(fmForm, &InstrumentEditorFMForm::jamKeyOffEvent,
-						 this, &MainWindow::keyReleaseEvent, Qt::DirectConnection);
 		QObject::connect(fmForm, &InstrumentEditorFMForm::octaveChanged,
 						 this, &MainWindow::changeOctave, Qt::DirectConnection);
 		QObject::connect(fmForm, &InstrumentEditorFMForm::modified,
@@ -999,10 +1115,6 @@ void MainWindow::onInstrumentListWidgetItemAdded(const QModelIndex &parent, int
 						 instForms_.get(), &InstrumentFormManager::onInstrumentSSGPitchNumberChanged);
 		QObject::connect(ssgForm, &InstrumentEditorSSGForm::pitchParameterChanged,
 						 instForms_.get(), &InstrumentFormManager::onInstrumentSSGPitchParameterChanged);
-		QObject::connect(ssgForm, &InstrumentEditorSSGForm::jamKeyOnEvent,
-						 this, &MainWindow::keyPressEvent, Qt::DirectConnection);
-		QObject::connect(ssgForm, &InstrumentEditorSSGForm::jamKeyOffEvent,
-						 this, &MainWindow::keyReleaseEvent, Qt::DirectConnection);
 		QObject::connect(ssgForm, &InstrumentEditorSSGForm::octaveChanged,
 						 this, &MainWindow::changeOctave, Qt::DirectConnection);
 		QObject::connect(ssgForm, &InstrumentEditorSSGForm::modified,
@@ -1491,6 +1603,7 @@ void MainWindow::on_actionNew_triggered()
 	loadModule();
 	isModifiedForNotCommand_ = false;
 	setWindowModified(false);
+	removeAutosaveFile();
 }
 
 void MainWindow::on_actionComments_triggered()
@@ -1514,11 +1627,12 @@ bool MainWindow::on_actionSave_triggered()
 			}
 		}
 
-		if (bt_->saveModule(bt_->getModulePath())) {
+		if (bt_->saveModule(bt_->getModulePath(), config_->getModuleCompressionLevel())) {
 			isModifiedForNotCommand_ = false;
 			isSavedModBefore_ = true;
 			setWindowModified(false);
 			setWindowTitle();
+			removeAutosaveFile();
 			return true;
 		}
 		else {
@@ -1549,12 +1663,13 @@ bool MainWindow::on_actionSave_As_triggered()
 	}
 
 	bt_->setModulePath(file.toStdString());
-	if (bt_->saveModule(bt_->getModulePath())) {
+	if (bt_->saveModule(bt_->getModulePath(), config_->getModuleCompressionLevel())) {
 		isModifiedForNotCommand_ = false;
 		isSavedModBefore_ = true;
 		setWindowModified(false);
 		setWindowTitle();
 		config_->setWorkingDirectory(QFileInfo(file).dir().path().toStdString());
+		removeAutosaveFile();
 		return true;
 	}
 	else {
@@ -1599,6 +1714,8 @@ void MainWindow::on_actionOpen_triggered()
 		config_->setWorkingDirectory(QFileInfo(file).dir().path().toStdString());
 		isModifiedForNotCommand_ = false;
 		setWindowModified(false);
+		removeAutosaveFile();
+		recoverAutosaveFile();
 	}
 	else {
 		QMessageBox::critical(this, "Error", "Failed to load module.");
@@ -1715,7 +1832,7 @@ void MainWindow::on_actionWAV_triggered()
 	lockControls(false);
 	stream_->stop();
 
-	bool res = bt_->exportToWav(file.toStdString(), diag.getLoopCount(),
+	bool res = bt_->exportToWav(file.toStdString(), diag.getLoopCount(), diag.getSampleFormat(),
 								[&progress]() -> bool {
 									QApplication::processEvents();
 									progress.setValue(progress.value() + 1);
@@ -1726,6 +1843,96 @@ void MainWindow::on_actionWAV_triggered()
 	stream_->start();
 }
 
+void MainWindow::updateAudioStatistics()
+{
+	auto cur = std::make_unique<AudioProfiler::Snapshot>();
+	AudioProfiler::getSnapshot(*cur);
+	// Statistics of the last second
+	AudioProfiler::Statistics mix = AudioProfiler::getStatistics(AudioStage::STREAM_READ, *cur, *audioStat_);
+	uint64_t xrun = cur->underrunCount + cur->deadlineMissCount;
+	if (mix.count) {
+		statusAudio_->setText(QString("Audio: avg %1us, p99 %2us, xrun %3")
+							  .arg(mix.avgUs, 0, 'f', 0).arg(mix.p99Us, 0, 'f', 0).arg(xrun));
+	}
+	else {
+		statusAudio_->setText(QString("Audio: idle, xrun %1").arg(xrun));
+	}
+	audioStat_ = std::move(cur);
+}
+
+void MainWindow::autosaveModule()
+{
+	// Autosave runs on a worker thread, so the timer does not stall editing and playback
+	if (!config_->getAutosaveModules() || !isWindowModified()) return;
+	QString file = getAutosaveFilePath();
+	if (file.isEmpty() || !QDir().mkpath(QFileInfo(file).path())) return;
+	if (bt_->autosaveModule(file.toStdString())) {
+		autosaveFile_ = file;
+		autosavePollTimer_->start(500);
+	}
+}
+
+void MainWindow::checkAutosaveResult()
+{
+	bool isSucceeded;
+	if (!bt_->takeAutosaveResult(isSucceeded)) return;
+	autosavePollTimer_->stop();
+	if (!isSucceeded) ui->statusBar->showMessage("Failed to autosave module to " + autosaveFile_, 10000);
+}
+
+QString MainWindow::getAutosaveFilePath() const
+{
+	std::string path = bt_->getModulePath();
+	if (path.empty()) {
+		// Unsaved module is kept in the application data directory instead of the current directory
+		QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+		return (dir.isEmpty() ? QString() : QDir(dir).filePath("autosave.btm"));
+	}
+	else {
+		return QString::fromStdString(path + ".autosave");
+	}
+}
+
+void MainWindow::removeAutosaveFile()
+{
+	// Wait for the running autosave so that it does not write the file again
+	autosavePollTimer_->stop();
+	bool isSucceeded;
+	bt_->takeAutosaveResult(isSucceeded, true);
+	if (!autosaveFile_.isEmpty()) QFile::remove(autosaveFile_);
+	autosaveFile_.clear();
+}
+
+void MainWindow::recoverAutosaveFile()
+{
+	QString file = getAutosaveFilePath();
+	if (file.isEmpty() || !QFileInfo::exists(file)) return;
+	autosaveFile_ = file;	// Also removed if it is not recovered
+
+	std::string path = bt_->getModulePath();
+	if (!path.empty()
+			&& QFileInfo(file).lastModified() <= QFileInfo(QString::fromStdString(path)).lastModified())
+		return;
+	if (QMessageBox::question(this, "BambooTracker",
+							  "Recover the autosaved changes in " + file + "?\n"
+							  "Otherwise the file is deleted when the module is saved or closed.")
+			!= QMessageBox::Yes)
+		return;
+
+	bt_->stopPlaySong();
+	lockControls(false);
+	bool isRecovered = bt_->loadModule(file.toStdString());
+	if (!isRecovered) {
+		QMessageBox::critical(this, "Error", "Failed to load the autosaved file.");
+		if (path.empty()) bt_->makeNewModule();
+		else bt_->loadModule(path);
+	}
+	bt_->setModulePath(path);
+	loadModule();
+	if (isRecovered) setModifiedTrue();
+	setWindowTitle();
+}
+
 void MainWindow::on_actionVGM_triggered()
 {
 	VgmExportSettingsDialog diag;
@@ -1774,3 +1981,17 @@ void MainWindow::on_actionOverwrite_triggered()
 {
 	if (isEditedPattern_) ui->patternEditor->onPasteOverwritePressed();
 }
+
+void MainWindow::on_actionAudio_Statistics_triggered()
+{
+	QString file = QFileDialog::getSaveFileName(this, "Export audio statistics", "./",
+												"JSON file (*.json)");
+	if (file.isNull()) return;
+	if (!file.endsWith(".json")) file += ".json";	// For linux
+
+	auto snap = std::make_unique<AudioProfiler::Snapshot>();
+	AudioProfiler::getSnapshot(*snap);
+	std::ofstream ofs(file.toStdString(), std::ios::binary);
+	ofs << AudioProfiler::toJson(*snap);
+	if (!ofs) QMessageBox::critical(this, "Error", "Failed to export audio statistics.");
+}
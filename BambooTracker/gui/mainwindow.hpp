@@ -3,6 +3,8 @@
 
 #include <memory>
 #include <cstdint>
+#include <string>
+#include <vector>
 #include <QMainWindow>
 #include <QKeyEvent>
 #include <QListWidgetItem>
@@ -15,9 +17,12 @@
 #include <QResizeEvent>
 #include <QMoveEvent>
 #include <QLabel>
+#include <QTimer>
 #include "configuration.hpp"
 #include "bamboo_tracker.hpp"
 #include "audio_stream.hpp"
+#include "audio_profiler.hpp"
+#include "instrument_library.hpp"
 #include "gui/instrument_editor/instrument_form_manager.hpp"
 #include "gui/color_palette.hpp"
 
@@ -62,8 +67,18 @@ private:
 	void cloneInstrument();
     void deepCloneInstrument();
 	void loadInstrument();
+	void loadInstrumentFromLibrary();
+	void loadInstrumentFile(QString file);
 	void saveInstrument();
 
+	// Instrument library
+	std::unique_ptr<InstrumentLibrary> instLib_;
+	/// Directories of instrument files loaded or saved, they are scanned recursively
+	std::vector<std::string> instLibDirs_;
+	QString getInstrumentLibraryIndexPath() const;
+	/// Return false if the directory is already scanned
+	bool addInstrumentLibraryDirectory(QString dir);
+
 	// Undo-Redo
 	void undo();
 	void redo();
@@ -102,6 +117,25 @@ private:
 	QLabel* statusOctave_;
 	QLabel* statusIntr_;
 	QLabel* statusPlayPos_;
+	QLabel* statusAudio_;
+	QLabel* statusUndo_;
+
+	// Audio statistics
+	QTimer* audioStatTimer_;
+	std::unique_ptr<AudioProfiler::Snapshot> audioStat_;
+	void updateAudioStatistics();
+
+	// Autosave
+	QTimer* autosaveTimer_;
+	QTimer* autosavePollTimer_;
+	/// Removed after the module is saved or closed
+	QString autosaveFile_;
+	void autosaveModule();
+	void checkAutosaveResult();
+	QString getAutosaveFilePath() const;
+	void removeAutosaveFile();
+	/// Offer to load the autosaved file if it is newer than the module file
+	void recoverAutosaveFile();
 
 private slots:
 	void on_instrumentListWidget_customContextMenuRequested(const QPoint &pos);
@@ -174,6 +208,7 @@ private slots:
 	void on_actionVGM_triggered();
 	void on_actionMix_triggered();
 	void on_actionOverwrite_triggered();
+	void on_actionAudio_Statistics_triggered();
 
 	inline bool showUndoResetWarningDialog(QString text)
 	{
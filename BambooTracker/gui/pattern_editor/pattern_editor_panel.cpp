@@ -1910,7 +1910,7 @@ void PatternEditorPanel::mouseReleaseEvent(QMouseEvent* event)
 				inOct->setEnabled(false);
 			}
 		}
-		if (!comStack_.lock()->canUndo()) {
+		if (!comStack_.lock()->canUndo() || !bt_->canUndo()) {
 			undo->setEnabled(false);
 		}
 		if (!comStack_.lock()->canRedo()) {
@@ -19,3 +19,12 @@ int WaveExportSettingsDialog::getLoopCount() const
 {
 	return ui->loopSpinBox->value();
 }
+
+WaveSampleFormat WaveExportSettingsDialog::getSampleFormat() const
+{
+	switch (ui->formatComboBox->currentIndex()) {
+	case 1:		return WaveSampleFormat::INT24;
+	case 2:		return WaveSampleFormat::FLOAT32;
+	default:	return WaveSampleFormat::INT16;
+	}
+}
@@ -2,6 +2,7 @@
 #define WAVE_EXPORT_SETTINGS_DIALOG_HPP
 
 #include <QDialog>
+#include "wave_sample_format.hpp"
 
 namespace Ui {
 	class WaveExportSettingsDialog;
@@ -16,6 +17,7 @@ public:
 	~WaveExportSettingsDialog();
 
 	int getLoopCount() const;
+	WaveSampleFormat getSampleFormat() const;
 
 private:
 	Ui::WaveExportSettingsDialog *ui;
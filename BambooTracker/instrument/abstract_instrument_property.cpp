@@ -2,7 +2,8 @@
 #include <algorithm>
 
 AbstractInstrumentProperty::AbstractInstrumentProperty(int num)
-	: num_(num)
+	: num_(num),
+	  userFlags_(nullptr)
 {
 }
 
@@ -10,11 +11,13 @@ AbstractInstrumentProperty::AbstractInstrumentProperty(const AbstractInstrumentP
 {
 	num_ = other.num_;
 	users_ = other.users_;
+	userFlags_ = other.userFlags_;
 }
 
 void AbstractInstrumentProperty::setNumber(int num)
 {
 	num_ = num;
+	updateUserFlag();
 }
 
 int AbstractInstrumentProperty::getNumber() const
@@ -26,11 +29,13 @@ void AbstractInstrumentProperty::registerUserInstrument(int instNum)
 {
 	users_.push_back(instNum);
 	std::sort(users_.begin(), users_.end());
+	updateUserFlag();
 }
 
 void AbstractInstrumentProperty::deregisterUserInstrument(int instNum)
 {
 	users_.erase(std::find(users_.begin(), users_.end(), instNum));
+	updateUserFlag();
 }
 
 bool AbstractInstrumentProperty::isUserInstrument() const
@@ -42,3 +47,15 @@ std::vector<int> AbstractInstrumentProperty::getUserInstruments() const
 {
 	return users_;
 }
+
+void AbstractInstrumentProperty::setUserFlags(PropertyUserFlags* flags)
+{
+	userFlags_ = flags;
+	updateUserFlag();
+}
+
+void AbstractInstrumentProperty::updateUserFlag()
+{
+	if (userFlags_ && 0 <= num_ && num_ < static_cast<int>(userFlags_->size()))
+		userFlags_->set(num_, !users_.empty());
+}
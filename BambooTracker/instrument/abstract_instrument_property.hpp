@@ -2,6 +2,11 @@
 
 #include <memory>
 #include <vector>
+#include <bitset>
+
+/// Flags of property numbers which have user instruments.
+/// It is shared among properties of the same kind
+using PropertyUserFlags = std::bitset<128>;
 
 class AbstractInstrumentProperty
 {
@@ -16,6 +21,9 @@ public:
 	bool isUserInstrument() const;
 	std::vector<int> getUserInstruments() const;
 
+	/// Keep the flag of this number in sync with users
+	void setUserFlags(PropertyUserFlags* flags);
+
 protected:
 	explicit AbstractInstrumentProperty(int num);
 	AbstractInstrumentProperty(const AbstractInstrumentProperty& other);
@@ -23,4 +31,7 @@ protected:
 private:
 	int num_;
 	std::vector<int> users_;
+	PropertyUserFlags* userFlags_;
+
+	void updateUserFlag();
 };
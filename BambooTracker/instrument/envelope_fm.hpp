@@ -1,16 +1,28 @@
 #pragma once
 
-#include <map>
 #include <memory>
 #include "abstract_instrument_property.hpp"
 
-enum class FMEnvelopeParameter;
+enum class FMEnvelopeParameter
+{
+	AL, FB,
+	AR1, DR1, SR1, RR1, SL1, TL1, KS1, ML1, DT1,
+	AR2, DR2, SR2, RR2, SL2, TL2, KS2, ML2, DT2,
+	AR3, DR3, SR3, RR3, SL3, TL3, KS3, ML3, DT3,
+	AR4, DR4, SR4, RR4, SL4, TL4, KS4, ML4, DT4,
+	SSGEG1, SSGEG2, SSGEG3, SSGEG4
+};
+
+/// Number of all envelope parameters
+constexpr int FM_ENVELOPE_PARAMETER_COUNT = 42;
+/// Number of parameters which have operator sequences (AL to DT4)
+constexpr int FM_OPERATOR_SEQUENCE_PARAMETER_COUNT = 38;
 
 class EnvelopeFM : public AbstractInstrumentProperty
 {
 public:
 	explicit EnvelopeFM(int num);
-	EnvelopeFM(const EnvelopeFM& other);
+	EnvelopeFM(const EnvelopeFM& other) = default;
 
 	std::unique_ptr<EnvelopeFM> clone();
 
@@ -23,44 +35,18 @@ public:
 	bool isEdited() const;
 
 private:
-	int al_;
-	int fb_;
-	struct FMOperator
-	{
-		bool enabled_;
-		int ar_;
-		int dr_;
-		int sr_;
-		int rr_;
-		int sl_;
-		int tl_;
-		int ks_;
-		int ml_;
-		int dt_;
-		int ssgeg_;	// -1: No use
-	};
-	FMOperator op_[4];
-
-	static constexpr int DEF_AL = 4;
-	static constexpr int DEF_FB = 0;
-	static constexpr FMOperator DEF_OP[4] = {
-		{ true, 31, 0, 0, 7, 0, 32, 0, 0, 0, -1 },
-		{ true, 31, 0, 0, 7, 0,  0, 0, 0, 0, -1 },
-		{ true, 31, 0, 0, 7, 0, 32, 0, 0, 0, -1 },
-		{ true, 31, 0, 0, 7, 0,  0, 0, 0, 0, -1 }
+	bool opEnabled_[4];
+	/// Indexed by FMEnvelopeParameter
+	///		SSGEG: -1 is no use
+	int params_[FM_ENVELOPE_PARAMETER_COUNT];
+
+	static constexpr bool DEF_OP_ENABLED[4] = { true, true, true, true };
+	static constexpr int DEF_PARAMS[FM_ENVELOPE_PARAMETER_COUNT] = {
+		4, 0,							// AL, FB
+		31, 0, 0, 7, 0, 32, 0, 0, 0,	// AR1, DR1, SR1, RR1, SL1, TL1, KS1, ML1, DT1
+		31, 0, 0, 7, 0,  0, 0, 0, 0,	// AR2, DR2, SR2, RR2, SL2, TL2, KS2, ML2, DT2
+		31, 0, 0, 7, 0, 32, 0, 0, 0,	// AR3, DR3, SR3, RR3, SL3, TL3, KS3, ML3, DT3
+		31, 0, 0, 7, 0,  0, 0, 0, 0,	// AR4, DR4, SR4, RR4, SL4, TL4, KS4, ML4, DT4
+		-1, -1, -1, -1					// SSGEG1, SSGEG2, SSGEG3, SSGEG4
 	};
-
-	std::map<FMEnvelopeParameter, int&> paramMap_;
-
-	void initParamMap();
-};
-
-enum class FMEnvelopeParameter
-{
-	AL, FB,
-	AR1, DR1, SR1, RR1, SL1, TL1, KS1, ML1, DT1,
-	AR2, DR2, SR2, RR2, SL2, TL2, KS2, ML2, DT2,
-	AR3, DR3, SR3, RR3, SL3, TL3, KS3, ML3, DT3,
-	AR4, DR4, SR4, RR4, SL4, TL4, KS4, ML4, DT4,
-	SSGEG1, SSGEG2, SSGEG3, SSGEG4
 };
@@ -1,4 +1,6 @@
 #include "instrument.hpp"
+#include <algorithm>
+#include <iterator>
 
 AbstractInstrument::AbstractInstrument(int number, SoundSource source, std::string name, InstrumentsManager* owner)
 	: owner_(owner),
@@ -45,86 +47,8 @@ InstrumentFM::InstrumentFM(int number, std::string name, InstrumentsManager* own
 	ptNum_(0),
 	envResetEnabled_(true)
 {
-	opSeqEnabled_ = {
-		{ FMEnvelopeParameter::AL,	false },
-		{ FMEnvelopeParameter::FB,	false },
-		{ FMEnvelopeParameter::AR1,	false },
-		{ FMEnvelopeParameter::DR1,	false },
-		{ FMEnvelopeParameter::SR1,	false },
-		{ FMEnvelopeParameter::RR1,	false },
-		{ FMEnvelopeParameter::SL1,	false },
-		{ FMEnvelopeParameter::TL1,	false },
-		{ FMEnvelopeParameter::KS1,	false },
-		{ FMEnvelopeParameter::ML1,	false },
-		{ FMEnvelopeParameter::DT1,	false },
-		{ FMEnvelopeParameter::AR2,	false },
-		{ FMEnvelopeParameter::DR2,	false },
-		{ FMEnvelopeParameter::SR2,	false },
-		{ FMEnvelopeParameter::RR2,	false },
-		{ FMEnvelopeParameter::SL2,	false },
-		{ FMEnvelopeParameter::TL2,	false },
-		{ FMEnvelopeParameter::KS2,	false },
-		{ FMEnvelopeParameter::ML2,	false },
-		{ FMEnvelopeParameter::DT2,	false },
-		{ FMEnvelopeParameter::AR3,	false },
-		{ FMEnvelopeParameter::DR3,	false },
-		{ FMEnvelopeParameter::SR3,	false },
-		{ FMEnvelopeParameter::RR3,	false },
-		{ FMEnvelopeParameter::SL3,	false },
-		{ FMEnvelopeParameter::TL3,	false },
-		{ FMEnvelopeParameter::KS3,	false },
-		{ FMEnvelopeParameter::ML3,	false },
-		{ FMEnvelopeParameter::DT3,	false },
-		{ FMEnvelopeParameter::AR4,	false },
-		{ FMEnvelopeParameter::DR4,	false },
-		{ FMEnvelopeParameter::SR4,	false },
-		{ FMEnvelopeParameter::RR4,	false },
-		{ FMEnvelopeParameter::SL4,	false },
-		{ FMEnvelopeParameter::TL4,	false },
-		{ FMEnvelopeParameter::KS4,	false },
-		{ FMEnvelopeParameter::ML4,	false },
-		{ FMEnvelopeParameter::DT4,	false }
-	};
-	opSeqNum_ = {
-		{ FMEnvelopeParameter::AL,	0 },
-		{ FMEnvelopeParameter::FB,	0 },
-		{ FMEnvelopeParameter::AR1,	0 },
-		{ FMEnvelopeParameter::DR1,	0 },
-		{ FMEnvelopeParameter::SR1,	0 },
-		{ FMEnvelopeParameter::RR1,	0 },
-		{ FMEnvelopeParameter::SL1,	0 },
-		{ FMEnvelopeParameter::TL1,	0 },
-		{ FMEnvelopeParameter::KS1,	0 },
-		{ FMEnvelopeParameter::ML1,	0 },
-		{ FMEnvelopeParameter::DT1,	0 },
-		{ FMEnvelopeParameter::AR2,	0 },
-		{ FMEnvelopeParameter::DR2,	0 },
-		{ FMEnvelopeParameter::SR2,	0 },
-		{ FMEnvelopeParameter::RR2,	0 },
-		{ FMEnvelopeParameter::SL2,	0 },
-		{ FMEnvelopeParameter::TL2,	0 },
-		{ FMEnvelopeParameter::KS2,	0 },
-		{ FMEnvelopeParameter::ML2,	0 },
-		{ FMEnvelopeParameter::DT2,	0 },
-		{ FMEnvelopeParameter::AR3,	0 },
-		{ FMEnvelopeParameter::DR3,	0 },
-		{ FMEnvelopeParameter::SR3,	0 },
-		{ FMEnvelopeParameter::RR3,	0 },
-		{ FMEnvelopeParameter::SL3,	0 },
-		{ FMEnvelopeParameter::TL3,	0 },
-		{ FMEnvelopeParameter::KS3,	0 },
-		{ FMEnvelopeParameter::ML3,	0 },
-		{ FMEnvelopeParameter::DT3,	0 },
-		{ FMEnvelopeParameter::AR4,	0 },
-		{ FMEnvelopeParameter::DR4,	0 },
-		{ FMEnvelopeParameter::SR4,	0 },
-		{ FMEnvelopeParameter::RR4,	0 },
-		{ FMEnvelopeParameter::SL4,	0 },
-		{ FMEnvelopeParameter::TL4,	0 },
-		{ FMEnvelopeParameter::KS4,	0 },
-		{ FMEnvelopeParameter::ML4,	0 },
-		{ FMEnvelopeParameter::DT4,	0 }
-	};
+	std::fill(std::begin(opSeqEnabled_), std::end(opSeqEnabled_), false);
+	std::fill(std::begin(opSeqNum_), std::end(opSeqNum_), 0);
 }
 
 std::unique_ptr<AbstractInstrument> InstrumentFM::clone()
@@ -189,42 +113,42 @@ bool InstrumentFM::getEnvelopeResetEnabled() const
 
 void InstrumentFM::setOperatorSequenceEnabled(FMEnvelopeParameter param, bool enabled)
 {
-	opSeqEnabled_.at(param) = enabled;
+	opSeqEnabled_[static_cast<int>(param)] = enabled;
 }
 
 bool InstrumentFM::getOperatorSequenceEnabled(FMEnvelopeParameter param) const
 {
-	return opSeqEnabled_.at(param);
+	return opSeqEnabled_[static_cast<int>(param)];
 }
 
 void InstrumentFM::setOperatorSequenceNumber(FMEnvelopeParameter param, int n)
 {
-	opSeqNum_.at(param) = n;
+	opSeqNum_[static_cast<int>(param)] = n;
 }
 
 int InstrumentFM::getOperatorSequenceNumber(FMEnvelopeParameter param) const
 {
-	return opSeqNum_.at(param);
+	return opSeqNum_[static_cast<int>(param)];
 }
 
 std::vector<CommandInSequence> InstrumentFM::getOperatorSequenceSequence(FMEnvelopeParameter param) const
 {
-	return owner_->getOperatorSequenceFMSequence(param, opSeqNum_.at(param));
+	return owner_->getOperatorSequenceFMSequence(param, opSeqNum_[static_cast<int>(param)]);
 }
 
 std::vector<Loop> InstrumentFM::getOperatorSequenceLoops(FMEnvelopeParameter param) const
 {
-	return owner_->getOperatorSequenceFMLoops(param, opSeqNum_.at(param));
+	return owner_->getOperatorSequenceFMLoops(param, opSeqNum_[static_cast<int>(param)]);
 }
 
 Release InstrumentFM::getOperatorSequenceRelease(FMEnvelopeParameter param) const
 {
-	return owner_->getOperatorSequenceFMRelease(param, opSeqNum_.at(param));
+	return owner_->getOperatorSequenceFMRelease(param, opSeqNum_[static_cast<int>(param)]);
 }
 
 std::unique_ptr<CommandSequence::Iterator> InstrumentFM::getOperatorSequenceSequenceIterator(FMEnvelopeParameter param) const
 {
-	return owner_->getOperatorSequenceFMIterator(param, opSeqNum_.at(param));
+	return owner_->getOperatorSequenceFMIterator(param, opSeqNum_[static_cast<int>(param)]);
 }
 
 void InstrumentFM::setArpeggioEnabled(bool enabled)
@@ -2,7 +2,6 @@
 
 #include <string>
 #include <memory>
-#include <map>
 #include <vector>
 #include "instruments_manager.hpp"
 #include "envelope_fm.hpp"
@@ -88,8 +87,9 @@ private:
 	int envNum_;
 	bool lfoEnabled_;
 	int lfoNum_;
-	std::map<FMEnvelopeParameter, bool> opSeqEnabled_;
-	std::map<FMEnvelopeParameter, int> opSeqNum_;
+	/// Indexed by FMEnvelopeParameter
+	bool opSeqEnabled_[FM_OPERATOR_SEQUENCE_PARAMETER_COUNT];
+	int opSeqNum_[FM_OPERATOR_SEQUENCE_PARAMETER_COUNT];
 	bool arpEnabled_;
 	int arpNum_;
 	bool ptEnabled_;
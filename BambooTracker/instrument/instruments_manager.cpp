@@ -213,140 +213,101 @@ void InstrumentsManager::deepCloneInstrument(int cloneInstNum, int refInstNum)
 
 int InstrumentsManager::cloneFMEnvelope(int srcNum)
 {
-	int cloneNum = 0;
-	for (auto& env : envFM_) {
-		if (!env->isUserInstrument()) {
-			env = envFM_.at(srcNum)->clone();
-			env->setNumber(cloneNum);
-			break;
-		}
-		++cloneNum;
+	int cloneNum = findFirstFreeEnvelopeFM();
+	if (cloneNum != -1) {
+		envFM_[cloneNum] = envFM_.at(srcNum)->clone();
+		envFM_[cloneNum]->setNumber(cloneNum);
 	}
 	return cloneNum;
 }
 
 int InstrumentsManager::cloneFMLFO(int srcNum)
 {
-	int cloneNum = 0;
-	for (auto& lfo : lfoFM_) {
-		if (!lfo->isUserInstrument()) {
-			lfo = lfoFM_.at(srcNum)->clone();
-			lfo->setNumber(cloneNum);
-			break;
-		}
-		++cloneNum;
+	int cloneNum = findFirstFreeLFOFM();
+	if (cloneNum != -1) {
+		lfoFM_[cloneNum] = lfoFM_.at(srcNum)->clone();
+		lfoFM_[cloneNum]->setNumber(cloneNum);
 	}
 	return cloneNum;
 }
 
 int InstrumentsManager::cloneFMOperatorSequence(FMEnvelopeParameter param, int srcNum)
 {
-	int cloneNum = 0;
-	for (auto& opSeq : opSeqFM_.at(param)) {
-		if (!opSeq->isUserInstrument()) {
-			opSeq = opSeqFM_.at(param).at(srcNum)->clone();
-			opSeq->setNumber(cloneNum);
-			break;
-		}
-		++cloneNum;
+	int cloneNum = findFirstFreeOperatorSequenceFM(param);
+	if (cloneNum != -1) {
+		auto& seqs = opSeqFM_.at(param);
+		seqs[cloneNum] = seqs.at(srcNum)->clone();
+		seqs[cloneNum]->setNumber(cloneNum);
 	}
 	return cloneNum;
 }
 
 int InstrumentsManager::cloneFMArpeggio(int srcNum)
 {
-	int cloneNum = 0;
-	for (auto& arp : arpFM_) {
-		if (!arp->isUserInstrument()) {
-			arp = arpFM_.at(srcNum)->clone();
-			arp->setNumber(cloneNum);
-			break;
-		}
-		++cloneNum;
+	int cloneNum = findFirstFreeArpeggioFM();
+	if (cloneNum != -1) {
+		arpFM_[cloneNum] = arpFM_.at(srcNum)->clone();
+		arpFM_[cloneNum]->setNumber(cloneNum);
 	}
 	return cloneNum;
 }
 
 int InstrumentsManager::cloneFMPitch(int srcNum)
 {
-	int cloneNum = 0;
-	for (auto& pt : ptFM_) {
-		if (!pt->isUserInstrument()) {
-			pt = ptFM_.at(srcNum)->clone();
-			pt->setNumber(cloneNum);
-			break;
-		}
-		++cloneNum;
+	int cloneNum = findFirstFreePitchFM();
+	if (cloneNum != -1) {
+		ptFM_[cloneNum] = ptFM_.at(srcNum)->clone();
+		ptFM_[cloneNum]->setNumber(cloneNum);
 	}
 	return cloneNum;
 }
 
 int InstrumentsManager::cloneSSGWaveForm(int srcNum)
 {
-	int cloneNum = 0;
-	for (auto& wf : wfSSG_) {
-		if (!wf->isUserInstrument()) {
-			wf = wfSSG_.at(srcNum)->clone();
-			wf->setNumber(cloneNum);
-			break;
-		}
-		++cloneNum;
+	int cloneNum = findFirstFreeWaveFormSSG();
+	if (cloneNum != -1) {
+		wfSSG_[cloneNum] = wfSSG_.at(srcNum)->clone();
+		wfSSG_[cloneNum]->setNumber(cloneNum);
 	}
 	return cloneNum;
 }
 
 int InstrumentsManager::cloneSSGToneNoise(int srcNum)
 {
-	int cloneNum = 0;
-	for (auto& tn : tnSSG_) {
-		if (!tn->isUserInstrument()) {
-			tn = tnSSG_.at(srcNum)->clone();
-			tn->setNumber(cloneNum);
-			break;
-		}
-		++cloneNum;
+	int cloneNum = findFirstFreeToneNoiseSSG();
+	if (cloneNum != -1) {
+		tnSSG_[cloneNum] = tnSSG_.at(srcNum)->clone();
+		tnSSG_[cloneNum]->setNumber(cloneNum);
 	}
 	return cloneNum;
 }
 
 int InstrumentsManager::cloneSSGEnvelope(int srcNum)
 {
-	int cloneNum = 0;
-	for (auto& env : envSSG_) {
-		if (!env->isUserInstrument()) {
-			env = envSSG_.at(srcNum)->clone();
-			env->setNumber(cloneNum);
-			break;
-		}
-		++cloneNum;
+	int cloneNum = findFirstFreeEnvelopeSSG();
+	if (cloneNum != -1) {
+		envSSG_[cloneNum] = envSSG_.at(srcNum)->clone();
+		envSSG_[cloneNum]->setNumber(cloneNum);
 	}
 	return cloneNum;
 }
 
 int InstrumentsManager::cloneSSGArpeggio(int srcNum)
 {
-	int cloneNum = 0;
-	for (auto& arp : arpSSG_) {
-		if (!arp->isUserInstrument()) {
-			arp = arpSSG_.at(srcNum)->clone();
-			arp->setNumber(cloneNum);
-			break;
-		}
-		++cloneNum;
+	int cloneNum = findFirstFreeArpeggioSSG();
+	if (cloneNum != -1) {
+		arpSSG_[cloneNum] = arpSSG_.at(srcNum)->clone();
+		arpSSG_[cloneNum]->setNumber(cloneNum);
 	}
 	return cloneNum;
 }
 
 int InstrumentsManager::cloneSSGPitch(int srcNum)
 {
-	int cloneNum = 0;
-	for (auto& pt : ptSSG_) {
-		if (!pt->isUserInstrument()) {
-			pt = ptSSG_.at(srcNum)->clone();
-			pt->setNumber(cloneNum);
-			break;
-		}
-		++cloneNum;
+	int cloneNum = findFirstFreePitchSSG();
+	if (cloneNum != -1) {
+		ptSSG_[cloneNum] = ptSSG_.at(srcNum)->clone();
+		ptSSG_[cloneNum]->setNumber(cloneNum);
 	}
 	return cloneNum;
 }
@@ -401,24 +362,35 @@ void InstrumentsManager::clearAll()
 {
 	for (auto p : envFMParams_) {
 		opSeqFM_.emplace(p, std::array<std::shared_ptr<CommandSequence>, 128>());
+		opSeqFMUsers_[static_cast<int>(p)] = PropertyUserFlags();
 	}
 
 	for (size_t i = 0; i < 128; ++i) {
 		insts_[i].reset();
 
 		envFM_[i] = std::make_shared<EnvelopeFM>(i);
+		envFM_[i]->setUserFlags(&envFMUsers_);
 		lfoFM_[i] = std::make_shared<LFOFM>(i);
+		lfoFM_[i]->setUserFlags(&lfoFMUsers_);
 		for (auto& p : opSeqFM_) {
 			p.second[i] = std::make_shared<CommandSequence>(i, 0);
+			p.second[i]->setUserFlags(&opSeqFMUsers_[static_cast<int>(p.first)]);
 		}
 		arpFM_[i] = std::make_shared<CommandSequence>(i, 0, 48);
+		arpFM_[i]->setUserFlags(&arpFMUsers_);
 		ptFM_[i] = std::make_shared<CommandSequence>(i, 0, 127);
+		ptFM_[i]->setUserFlags(&ptFMUsers_);
 
 		wfSSG_[i] = std::make_shared<CommandSequence>(i, 0);
+		wfSSG_[i]->setUserFlags(&wfSSGUsers_);
 		tnSSG_[i] = std::make_shared<CommandSequence>(i, 0);
+		tnSSG_[i]->setUserFlags(&tnSSGUsers_);
 		envSSG_[i] = std::make_shared<CommandSequence>(i, 0, 15);
+		envSSG_[i]->setUserFlags(&envSSGUsers_);
 		arpSSG_[i] = std::make_shared<CommandSequence>(i, 0, 48);
+		arpSSG_[i]->setUserFlags(&arpSSGUsers_);
 		ptSSG_[i] = std::make_shared<CommandSequence>(i, 0, 127);
+		ptSSG_[i]->setUserFlags(&ptSSGUsers_);
 	}
 }
 
@@ -455,29 +427,50 @@ std::vector<int> InstrumentsManager::getEntriedInstrumentIndices() const
 void InstrumentsManager::clearUnusedInstrumentProperties()
 {
 	for (size_t i = 0; i < 128; ++i) {
-		if (!envFM_[i]->isUserInstrument())
+		if (!envFMUsers_[i]) {
 			envFM_[i] = std::make_shared<EnvelopeFM>(i);
-		if (!lfoFM_[i]->isUserInstrument())
+			envFM_[i]->setUserFlags(&envFMUsers_);
+		}
+		if (!lfoFMUsers_[i]) {
 			lfoFM_[i] = std::make_shared<LFOFM>(i);
+			lfoFM_[i]->setUserFlags(&lfoFMUsers_);
+		}
 		for (auto& p : opSeqFM_) {
-			if (!p.second[i]->isUserInstrument())
+			PropertyUserFlags& users = opSeqFMUsers_[static_cast<int>(p.first)];
+			if (!users[i]) {
 				p.second[i] = std::make_shared<CommandSequence>(i, 0);
+				p.second[i]->setUserFlags(&users);
+			}
 		}
-		if (!arpFM_[i]->isUserInstrument())
+		if (!arpFMUsers_[i]) {
 			arpFM_[i] = std::make_shared<CommandSequence>(i, 0, 48);
-		if (!ptFM_[i]->isUserInstrument())
+			arpFM_[i]->setUserFlags(&arpFMUsers_);
+		}
+		if (!ptFMUsers_[i]) {
 			ptFM_[i] = std::make_shared<CommandSequence>(i, 0, 127);
+			ptFM_[i]->setUserFlags(&ptFMUsers_);
+		}
 
-		if (!wfSSG_[i]->isUserInstrument())
+		if (!wfSSGUsers_[i]) {
 			wfSSG_[i] = std::make_shared<CommandSequence>(i, 0);
-		if (!tnSSG_[i]->isUserInstrument())
+			wfSSG_[i]->setUserFlags(&wfSSGUsers_);
+		}
+		if (!tnSSGUsers_[i]) {
 			tnSSG_[i] = std::make_shared<CommandSequence>(i, 0);
-		if (!envSSG_[i]->isUserInstrument())
+			tnSSG_[i]->setUserFlags(&tnSSGUsers_);
+		}
+		if (!envSSGUsers_[i]) {
 			envSSG_[i] = std::make_shared<CommandSequence>(i, 0, 15);
-		if (!arpSSG_[i]->isUserInstrument())
+			envSSG_[i]->setUserFlags(&envSSGUsers_);
+		}
+		if (!arpSSGUsers_[i]) {
 			arpSSG_[i] = std::make_shared<CommandSequence>(i, 0, 48);
-		if (!ptSSG_[i]->isUserInstrument())
+			arpSSG_[i]->setUserFlags(&arpSSGUsers_);
+		}
+		if (!ptSSGUsers_[i]) {
 			ptSSG_[i] = std::make_shared<CommandSequence>(i, 0, 127);
+			ptSSG_[i]->setUserFlags(&ptSSGUsers_);
+		}
 	}
 }
 
@@ -494,6 +487,18 @@ int InstrumentsManager::findFirstFreeInstrument() const
 	return -1;
 }
 
+/// Return:
+///		-1: no free property
+///		else: first property number which has no user instrument
+int InstrumentsManager::findFirstFreeProperty(const PropertyUserFlags& users)
+{
+	if (users.all()) return -1;
+	for (size_t i = 0; i < users.size(); ++i) {
+		if (!users[i]) return i;
+	}
+	return -1;
+}
+
 //----- FM methods -----
 void InstrumentsManager::setInstrumentFMEnvelope(int instNum, int envNum)
 {
@@ -547,11 +552,7 @@ std::vector<int> InstrumentsManager::getEnvelopeFMEntriedIndices() const
 
 int InstrumentsManager::findFirstFreeEnvelopeFM() const
 {
-	size_t i = 0;
-	for (size_t i = 0; i < envFM_.size(); ++i) {
-		if (!envFM_[i]->isUserInstrument()) return i;
-	}
-	return -1;
+	return findFirstFreeProperty(envFMUsers_);
 }
 
 void InstrumentsManager::setInstrumentFMLFOEnabled(int instNum, bool enabled)
@@ -609,10 +610,7 @@ std::vector<int> InstrumentsManager::getLFOFMEntriedIndices() const
 
 int InstrumentsManager::findFirstFreeLFOFM() const
 {
-	for (size_t i = 0; i < lfoFM_.size(); ++i) {
-		if (!lfoFM_[i]->isUserInstrument()) return i;
-	}
-	return -1;
+	return findFirstFreeProperty(lfoFMUsers_);
 }
 
 void InstrumentsManager::setInstrumentFMOperatorEnabled(int instNum, FMEnvelopeParameter param, bool enabled)
@@ -708,10 +706,7 @@ std::vector<int> InstrumentsManager::getOperatorSequenceFMEntriedIndices(FMEnvel
 
 int InstrumentsManager::findFirstFreeOperatorSequenceFM(FMEnvelopeParameter param) const
 {
-	for (size_t i = 0; i < opSeqFM_.at(param).size(); ++i) {
-		if (!opSeqFM_.at(param)[i]->isUserInstrument()) return i;
-	}
-	return -1;
+	return findFirstFreeProperty(opSeqFMUsers_[static_cast<int>(param)]);
 }
 
 void InstrumentsManager::setInstrumentFMArpeggioEnabled(int instNum, bool enabled)
@@ -817,10 +812,7 @@ std::vector<int> InstrumentsManager::getArpeggioFMEntriedIndices() const
 
 int InstrumentsManager::findFirstFreeArpeggioFM() const
 {
-	for (size_t i = 0; i < arpFM_.size(); ++i) {
-		if (!arpFM_[i]->isUserInstrument()) return i;
-	}
-	return -1;
+	return findFirstFreeProperty(arpFMUsers_);
 }
 
 void InstrumentsManager::setInstrumentFMPitchEnabled(int instNum, bool enabled)
@@ -931,10 +923,7 @@ std::vector<int> InstrumentsManager::getPitchFMEntriedIndices() const
 
 int InstrumentsManager::findFirstFreePitchFM() const
 {
-	for (size_t i = 0; i < ptFM_.size(); ++i) {
-		if (!ptFM_[i]->isUserInstrument()) return i;
-	}
-	return -1;
+	return findFirstFreeProperty(ptFMUsers_);
 }
 
 //----- SSG methods -----
@@ -1031,10 +1020,7 @@ std::vector<int> InstrumentsManager::getWaveFormSSGEntriedIndices() const
 
 int InstrumentsManager::findFirstFreeWaveFormSSG() const
 {
-	for (size_t i = 0; i < wfSSG_.size(); ++i) {
-		if (!wfSSG_[i]->isUserInstrument()) return i;
-	}
-	return -1;
+	return findFirstFreeProperty(wfSSGUsers_);
 }
 
 void InstrumentsManager::setInstrumentSSGToneNoiseEnabled(int instNum, bool enabled)
@@ -1130,10 +1116,7 @@ std::vector<int> InstrumentsManager::getToneNoiseSSGEntriedIndices() const
 
 int InstrumentsManager::findFirstFreeToneNoiseSSG() const
 {
-	for (size_t i = 0; i < tnSSG_.size(); ++i) {
-		if (!tnSSG_[i]->isUserInstrument()) return i;
-	}
-	return -1;
+	return findFirstFreeProperty(tnSSGUsers_);
 }
 
 void InstrumentsManager::setInstrumentSSGEnvelopeEnabled(int instNum, bool enabled)
@@ -1229,10 +1212,7 @@ std::vector<int> InstrumentsManager::getEnvelopeSSGEntriedIndices() const
 
 int InstrumentsManager::findFirstFreeEnvelopeSSG() const
 {
-	for (size_t i = 0; i < envSSG_.size(); ++i) {
-		if (!envSSG_[i]->isUserInstrument()) return i;
-	}
-	return -1;
+	return findFirstFreeProperty(envSSGUsers_);
 }
 
 void InstrumentsManager::setInstrumentSSGArpeggioEnabled(int instNum, bool enabled)
@@ -1338,10 +1318,7 @@ std::vector<int> InstrumentsManager::getArpeggioSSGEntriedIndices() const
 
 int InstrumentsManager::findFirstFreeArpeggioSSG() const
 {
-	for (size_t i = 0; i < arpSSG_.size(); ++i) {
-		if (!arpSSG_[i]->isUserInstrument()) return i;
-	}
-	return -1;
+	return findFirstFreeProperty(arpSSGUsers_);
 }
 
 void InstrumentsManager::setInstrumentSSGPitchEnabled(int instNum, bool enabled)
@@ -1447,8 +1424,5 @@ std::vector<int> InstrumentsManager::getPitchSSGEntriedIndices() const
 
 int InstrumentsManager::findFirstFreePitchSSG() const
 {
-	for (size_t i = 0; i < ptSSG_.size(); ++i) {
-		if (!ptSSG_[i]->isUserInstrument()) return i;
-	}
-	return -1;
+	return findFirstFreeProperty(ptSSGUsers_);
 }
@@ -41,6 +41,8 @@ public:
 private:
 	std::array<std::shared_ptr<AbstractInstrument>, 128> insts_;
 
+	static int findFirstFreeProperty(const PropertyUserFlags& users);
+
 	//----- FM methods -----
 public:
 	void setInstrumentFMEnvelope(int instNum, int envNum);
@@ -127,6 +129,11 @@ private:
 	std::array<std::shared_ptr<CommandSequence>, 128> arpFM_;
 	std::array<std::shared_ptr<CommandSequence>, 128> ptFM_;
 
+	// Property numbers which have user instruments
+	PropertyUserFlags envFMUsers_, lfoFMUsers_, arpFMUsers_, ptFMUsers_;
+	/// Indexed by FMEnvelopeParameter
+	std::array<PropertyUserFlags, FM_OPERATOR_SEQUENCE_PARAMETER_COUNT> opSeqFMUsers_;
+
 	std::vector<FMEnvelopeParameter> envFMParams_;
 
 	int cloneFMEnvelope(int srcNum);
@@ -233,6 +240,9 @@ private:
 	std::array<std::shared_ptr<CommandSequence>, 128> arpSSG_;
 	std::array<std::shared_ptr<CommandSequence>, 128> ptSSG_;
 
+	// Property numbers which have user instruments
+	PropertyUserFlags wfSSGUsers_, envSSGUsers_, tnSSGUsers_, arpSSGUsers_, ptSSGUsers_;
+
 	int cloneSSGWaveForm(int srcNum);
 	int cloneSSGToneNoise(int srcNum);
 	int cloneSSGEnvelope(int srcNum);
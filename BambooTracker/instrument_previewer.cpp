@@ -0,0 +1,354 @@
+#include "instrument_previewer.hpp"
+#include <cmath>
+#include <algorithm>
+#include <utility>
+#include "file_io.hpp"
+#include "binary_container.hpp"
+#include "binary_reader.hpp"
+#include "tick_counter.hpp"
+
+namespace
+{
+	/// Maximum duration of a chunk rendered at once [ms]
+	constexpr int RENDER_DURATION = 100;
+	/// The release is cut when all frames of ticks are under the level
+	constexpr float SILENT_LEVEL = 1.0f / 32768.0f;
+	constexpr int SILENT_TICKS_TO_CUT = 2;
+}
+
+std::vector<float> PreviewClip::getPeaks(size_t count) const
+{
+	std::vector<float> peaks(count, 0.0f);
+	size_t frames = getFrameCount();
+	if (!count || !frames) return peaks;
+
+	for (size_t i = 0; i < count; ++i) {
+		size_t begin = frames * i / count;
+		size_t end = std::max(frames * (i + 1) / count, begin + 1);
+		float peak = 0.0f;
+		for (size_t f = begin; f < end && f < frames; ++f) {
+			peak = std::max(peak, std::max(std::abs(samples[f << 1]), std::abs(samples[(f << 1) + 1])));
+		}
+		peaks[i] = peak;
+	}
+
+	return peaks;
+}
+
+bool InstrumentPreviewer::ClipKey::isSameSound(const ClipKey& other) const
+{
+	return (instNum == other.instNum && note == other.note && octave == other.octave);
+}
+
+bool InstrumentPreviewer::ClipKey::operator==(const ClipKey& other) const
+{
+	return (isSameSound(other) && data == other.data);
+}
+
+constexpr int InstrumentPreviewer::DEF_KEY_ON_TICKS;
+constexpr int InstrumentPreviewer::DEF_RELEASE_TICKS;
+constexpr size_t InstrumentPreviewer::MAX_CACHE_COUNT;
+
+InstrumentPreviewer::InstrumentPreviewer(int clock, int rate, int tickFreq)
+	: opnaCtrl_(std::make_unique<OPNAController>(clock, rate, RENDER_DURATION)),
+	  instMan_(std::make_shared<InstrumentsManager>()),
+	  rate_(rate),
+	  tickFreq_(tickFreq),
+	  keyOnTicks_(DEF_KEY_ON_TICKS),
+	  releaseTicks_(DEF_RELEASE_TICKS),
+	  generation_(0),
+	  hasPendingPlay_(false),
+	  isRendering_(false),
+	  isCanceled_(false),
+	  playFrame_(0),
+	  playRate_(rate)
+{
+}
+
+InstrumentPreviewer::~InstrumentPreviewer()
+{
+	std::shared_future<void> render;
+	{
+		std::lock_guard<std::mutex> lg(mutex_);
+		isCanceled_ = true;
+		queue_.clear();
+		render = render_;
+	}
+	if (render.valid()) render.wait();
+}
+
+/********** Render **********/
+std::shared_ptr<const PreviewClip> InstrumentPreviewer::request(std::weak_ptr<InstrumentsManager> instMan,
+																int instNum, Note note, int octave)
+{
+	if (!instMan.lock()->getInstrumentSharedPtr(instNum)) return nullptr;
+	return enqueue(makeKey(instMan, instNum, note, octave), false);
+}
+
+void InstrumentPreviewer::setRenderedCallback(std::function<void(int)> f)
+{
+	std::lock_guard<std::mutex> lg(mutex_);
+	renderedCallback_ = f;
+}
+
+bool InstrumentPreviewer::isRendering() const
+{
+	std::lock_guard<std::mutex> lg(mutex_);
+	return isRendering_;
+}
+
+void InstrumentPreviewer::waitForRendering()
+{
+	while (true) {
+		std::shared_future<void> render;
+		{
+			std::lock_guard<std::mutex> lg(mutex_);
+			if (!isRendering_) return;
+			render = render_;
+		}
+		render.wait();
+	}
+}
+
+void InstrumentPreviewer::clearCache()
+{
+	std::lock_guard<std::mutex> lg(mutex_);
+	discardClips();
+}
+
+void InstrumentPreviewer::setRate(int rate)
+{
+	{
+		std::lock_guard<std::mutex> lg(mutex_);
+		if (rate_ == rate) return;
+		rate_ = rate;
+		discardClips();
+	}
+	std::lock_guard<std::mutex> lg(playMutex_);
+	playRate_ = rate;
+	playClip_.reset();
+}
+
+void InstrumentPreviewer::setTickFrequency(int freq)
+{
+	std::lock_guard<std::mutex> lg(mutex_);
+	if (tickFreq_ == freq) return;
+	tickFreq_ = freq;
+	discardClips();
+}
+
+void InstrumentPreviewer::setLength(int keyOnTicks, int releaseTicks)
+{
+	std::lock_guard<std::mutex> lg(mutex_);
+	if (keyOnTicks_ == keyOnTicks && releaseTicks_ == releaseTicks) return;
+	keyOnTicks_ = keyOnTicks;
+	releaseTicks_ = releaseTicks;
+	discardClips();
+}
+
+InstrumentPreviewer::ClipKey InstrumentPreviewer::makeKey(std::weak_ptr<InstrumentsManager> instMan,
+														  int instNum, Note note, int octave) const
+{
+	BinaryContainer ctr;
+	FileIO::appendInstrument(ctr, instMan, instNum);
+	return { instNum, note, octave, ctr.getBytes(0) };
+}
+
+std::shared_ptr<const PreviewClip> InstrumentPreviewer::findClip(const ClipKey& key)
+{
+	auto it = std::find_if(cache_.begin(), cache_.end(),
+						   [&key](const std::pair<ClipKey, std::shared_ptr<const PreviewClip>>& p) {
+		return p.first == key;
+	});
+	if (it == cache_.end()) return nullptr;
+
+	cache_.splice(cache_.begin(), cache_, it);
+	return cache_.front().second;
+}
+
+std::shared_ptr<const PreviewClip> InstrumentPreviewer::enqueue(ClipKey key, bool isPlayed)
+{
+	std::lock_guard<std::mutex> lg(mutex_);
+	if (isPlayed) hasPendingPlay_ = false;
+	if (auto clip = findClip(key)) return clip;
+
+	if (isPlayed) {
+		hasPendingPlay_ = true;
+		pendingPlay_ = key;
+	}
+
+	auto it = std::find_if(queue_.begin(), queue_.end(),
+						   [&key](const ClipKey& k) { return k.isSameSound(key); });
+	if (it == queue_.end()) queue_.push_back(std::move(key));
+	else *it = std::move(key);
+
+	if (!isRendering_) {
+		isRendering_ = true;
+		render_ = std::async(std::launch::async, [this] { renderQueue(); }).share();
+	}
+
+	return nullptr;
+}
+
+void InstrumentPreviewer::discardClips()
+{
+	++generation_;
+	cache_.clear();
+}
+
+void InstrumentPreviewer::renderQueue()
+{
+	while (true) {
+		ClipKey key;
+		int rate, tickFreq, keyOnTicks, releaseTicks;
+		unsigned int generation;
+		{
+			std::lock_guard<std::mutex> lg(mutex_);
+			if (queue_.empty() || isCanceled_) {
+				isRendering_ = false;
+				return;
+			}
+			key = std::move(queue_.front());
+			queue_.pop_front();
+			rate = rate_;
+			tickFreq = tickFreq_;
+			keyOnTicks = keyOnTicks_;
+			releaseTicks = releaseTicks_;
+			generation = generation_;
+		}
+
+		std::shared_ptr<PreviewClip> clip = render(key, rate, tickFreq, keyOnTicks, releaseTicks);
+
+		std::function<void(int)> callback;
+		bool isPlayed = false;
+		{
+			std::lock_guard<std::mutex> lg(mutex_);
+			if (!clip || generation != generation_ || isCanceled_) continue;
+			if (hasPendingPlay_ && pendingPlay_ == key) {
+				hasPendingPlay_ = false;
+				isPlayed = true;
+			}
+			cache_.emplace_front(std::move(key), clip);
+			if (cache_.size() > MAX_CACHE_COUNT) cache_.pop_back();
+			callback = renderedCallback_;
+		}
+
+		if (isPlayed) play(clip);
+		if (callback) callback(clip->instNum);
+	}
+}
+
+std::shared_ptr<PreviewClip> InstrumentPreviewer::render(const ClipKey& key, int rate, int tickFreq,
+														 int keyOnTicks, int releaseTicks)
+{
+	instMan_->clearAll();
+	std::unique_ptr<AbstractInstrument> inst(
+				FileIO::loadInstrument(BinaryReader(key.data.data(), key.data.size()), instMan_, key.instNum));
+	if (!inst) return nullptr;
+	SoundSource src = inst->getSoundSource();
+	instMan_->addInstrument(std::move(inst));
+
+	if (opnaCtrl_->getRate() != rate) opnaCtrl_->setRate(rate);
+	opnaCtrl_->reset();
+
+	// Sound on the first channel as jam mode does
+	switch (src) {
+	case SoundSource::FM:
+		opnaCtrl_->setInstrumentFM(
+					0, std::dynamic_pointer_cast<InstrumentFM>(instMan_->getInstrumentSharedPtr(key.instNum)));
+		opnaCtrl_->keyOnFM(0, key.note, key.octave, 0, true);
+		break;
+	case SoundSource::SSG:
+		opnaCtrl_->setInstrumentSSG(
+					0, std::dynamic_pointer_cast<InstrumentSSG>(instMan_->getInstrumentSharedPtr(key.instNum)));
+		opnaCtrl_->keyOnSSG(0, key.note, key.octave, 0, true);
+		break;
+	default:
+		return nullptr;
+	}
+
+	auto clip = std::make_shared<PreviewClip>();
+	clip->instNum = key.instNum;
+	clip->note = key.note;
+	clip->octave = key.octave;
+	clip->rate = rate;
+	clip->keyOffFrame = TickCounter::getSampleIndexOfTick(keyOnTicks, rate, tickFreq);
+	clip->samples.reserve(TickCounter::getSampleIndexOfTick(keyOnTicks + releaseTicks, rate, tickFreq) << 1);
+
+	size_t maxFrames = static_cast<size_t>(rate) * RENDER_DURATION / 1000;
+	int silentTicks = 0;
+	for (int tick = 0; tick < keyOnTicks + releaseTicks; ++tick) {
+		if (isCanceled_) return nullptr;
+
+		// Interruption
+		if (tick) opnaCtrl_->tickEvent(src, 0);
+		if (tick == keyOnTicks) {
+			if (src == SoundSource::FM) opnaCtrl_->keyOffFM(0, true);
+			else opnaCtrl_->keyOffSSG(0, true);
+		}
+
+		size_t begin = clip->samples.size();
+		size_t frames = TickCounter::getSampleIndexOfTick(tick + 1, rate, tickFreq)
+						- TickCounter::getSampleIndexOfTick(tick, rate, tickFreq);
+		clip->samples.resize(begin + (frames << 1));
+		for (size_t f = 0; f < frames; ) {
+			size_t count = std::min(frames - f, maxFrames);
+			opnaCtrl_->getStreamSamples(&clip->samples[begin + (f << 1)], count);
+			f += count;
+		}
+
+		if (tick >= keyOnTicks) {
+			bool isSilent = std::all_of(clip->samples.begin() + static_cast<std::ptrdiff_t>(begin),
+										clip->samples.end(),
+										[](float s) { return std::abs(s) < SILENT_LEVEL; });
+			if (!isSilent) silentTicks = 0;
+			else if (++silentTicks == SILENT_TICKS_TO_CUT) break;
+		}
+	}
+
+	return clip;
+}
+
+/********** Playback **********/
+void InstrumentPreviewer::play(std::weak_ptr<InstrumentsManager> instMan, int instNum, Note note, int octave)
+{
+	if (!instMan.lock()->getInstrumentSharedPtr(instNum)) return;
+	if (auto clip = enqueue(makeKey(instMan, instNum, note, octave), true)) play(clip);
+}
+
+void InstrumentPreviewer::play(std::shared_ptr<const PreviewClip> clip)
+{
+	std::lock_guard<std::mutex> lg(playMutex_);
+	if (clip && clip->rate != playRate_) return;
+	playClip_ = clip;
+	playFrame_ = 0;
+}
+
+void InstrumentPreviewer::stop()
+{
+	{
+		std::lock_guard<std::mutex> lg(mutex_);
+		hasPendingPlay_ = false;
+	}
+	std::lock_guard<std::mutex> lg(playMutex_);
+	playClip_.reset();
+}
+
+bool InstrumentPreviewer::isPlaying() const
+{
+	std::lock_guard<std::mutex> lg(playMutex_);
+	return static_cast<bool>(playClip_);
+}
+
+void InstrumentPreviewer::mix(float* stream, size_t nSamples)
+{
+	std::lock_guard<std::mutex> lg(playMutex_);
+	if (!playClip_) return;
+
+	size_t count = std::min(nSamples, playClip_->getFrameCount() - playFrame_);
+	const float* src = playClip_->samples.data() + (playFrame_ << 1);
+	for (size_t i = 0, n = count << 1; i < n; ++i) stream[i] += src[i];
+
+	playFrame_ += count;
+	if (playFrame_ == playClip_->getFrameCount()) playClip_.reset();
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <future>
+#include <atomic>
+#include <functional>
+#include "opna_controller.hpp"
+#include "instruments_manager.hpp"
+#include "misc.hpp"
+
+/// Audition clip of an instrument
+struct PreviewClip
+{
+	int instNum;
+	Note note;
+	int octave;
+	int rate;
+	/// Interleaved stereo samples
+	std::vector<float> samples;
+	/// Frame index where the key is released
+	size_t keyOffFrame;
+
+	size_t getFrameCount() const { return samples.size() >> 1; }
+	/// Peak amplitudes of frames divided into the count, for waveform thumbnails
+	std::vector<float> getPeaks(size_t count) const;
+};
+
+/// Renderer of instrument audition clips on its own OPNA, apart from the playback chip.
+/// Instruments are copied on the calling thread and rendered on a worker thread.
+/// Clips are cached by the copied data, so an edited instrument is rendered again
+/// and the clip of a reverted instrument is reused
+class InstrumentPreviewer
+{
+public:
+	/// Create it on the thread which creates the playback chip,
+	/// because tables of the chip emulator are initialized at construction
+	InstrumentPreviewer(int clock, int rate, int tickFreq);
+	~InstrumentPreviewer();
+	InstrumentPreviewer(const InstrumentPreviewer&) = delete;
+	InstrumentPreviewer& operator=(const InstrumentPreviewer&) = delete;
+
+	/// Return the cached clip, or nullptr after queueing the rendering.
+	/// A queued request of the same instrument, note and octave is replaced
+	std::shared_ptr<const PreviewClip> request(std::weak_ptr<InstrumentsManager> instMan, int instNum,
+											   Note note, int octave);
+	/// Called on the worker thread with the instrument number when a clip is rendered
+	void setRenderedCallback(std::function<void(int)> f);
+	bool isRendering() const;
+	void waitForRendering();
+	void clearCache();
+
+	/// Cached clips are discarded by changing these
+	void setRate(int rate);
+	void setTickFrequency(int freq);
+	/// The key is released after keyOnTicks, and the release is rendered for releaseTicks at most
+	void setLength(int keyOnTicks, int releaseTicks);
+
+	/// Play the clip after it is rendered if it is not cached
+	void play(std::weak_ptr<InstrumentsManager> instMan, int instNum, Note note, int octave);
+	void play(std::shared_ptr<const PreviewClip> clip);
+	void stop();
+	bool isPlaying() const;
+	/// Add the playing clip to the stream
+	void mix(float* stream, size_t nSamples);
+
+	static constexpr int DEF_KEY_ON_TICKS = 30;
+	static constexpr int DEF_RELEASE_TICKS = 60;
+	static constexpr size_t MAX_CACHE_COUNT = 16;
+
+private:
+	struct ClipKey
+	{
+		int instNum;
+		Note note;
+		int octave;
+		/// Instrument in the instrument file format
+		std::vector<char> data;
+
+		bool isSameSound(const ClipKey& other) const;
+		bool operator==(const ClipKey& other) const;
+	};
+
+	/// Used only on the worker thread after construction
+	std::unique_ptr<OPNAController> opnaCtrl_;
+	std::shared_ptr<InstrumentsManager> instMan_;
+
+	/// Guards members below, except playback
+	mutable std::mutex mutex_;
+	int rate_, tickFreq_, keyOnTicks_, releaseTicks_;
+	/// Incremented when cached clips are discarded, to drop clips rendered with old settings
+	unsigned int generation_;
+	std::deque<ClipKey> queue_;
+	/// Most recently used first
+	std::list<std::pair<ClipKey, std::shared_ptr<const PreviewClip>>> cache_;
+	bool hasPendingPlay_;
+	ClipKey pendingPlay_;
+	std::function<void(int)> renderedCallback_;
+	bool isRendering_;
+	std::shared_future<void> render_;
+	std::atomic_bool isCanceled_;
+
+	/// Guards playback, which is mixed on the audio thread
+	mutable std::mutex playMutex_;
+	std::shared_ptr<const PreviewClip> playClip_;
+	size_t playFrame_;
+	int playRate_;
+
+	ClipKey makeKey(std::weak_ptr<InstrumentsManager> instMan, int instNum, Note note, int octave) const;
+	std::shared_ptr<const PreviewClip> findClip(const ClipKey& key);
+	/// Return the cached clip, or nullptr after queueing the key.
+	/// The clip is played after rendering if isPlayed is true
+	std::shared_ptr<const PreviewClip> enqueue(ClipKey key, bool isPlayed);
+	void discardClips();
+	void renderQueue();
+	std::shared_ptr<PreviewClip> render(const ClipKey& key, int rate, int tickFreq,
+										int keyOnTicks, int releaseTicks);
+};
@@ -0,0 +1,99 @@
+#include "atomic_file_writer.hpp"
+#ifdef _WIN32
+#include <algorithm>
+#include <windows.h>
+#else
+#include <cstdio>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef _WIN32
+namespace
+{
+	std::wstring toWide(const std::string& str)
+	{
+		// Path is UTF-8
+		int len = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, nullptr, 0);
+		if (len <= 0) return std::wstring();
+		std::wstring wstr(static_cast<size_t>(len), L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &wstr[0], len);
+		return wstr;
+	}
+}
+
+bool AtomicFileWriter::write(std::string path, const char* data, size_t size)
+{
+	std::wstring wpath = toWide(path);
+	std::wstring wtmp = toWide(path + ".tmp");
+	if (wpath.empty() || wtmp.empty()) return false;
+
+	HANDLE file = CreateFileW(wtmp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+							  FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	bool isWritten = true;
+	while (size && isWritten) {
+		DWORD len = static_cast<DWORD>(std::min<size_t>(size, 0x40000000));
+		DWORD written = 0;
+		isWritten = WriteFile(file, data, len, &written, nullptr);
+		data += written;
+		size -= written;
+	}
+	isWritten = isWritten && FlushFileBuffers(file);
+	CloseHandle(file);
+
+	if (!isWritten
+			|| !MoveFileExW(wtmp.c_str(), wpath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+		DeleteFileW(wtmp.c_str());
+		return false;
+	}
+	return true;
+}
+#else
+bool AtomicFileWriter::write(std::string path, const char* data, size_t size)
+{
+	std::string tmp = path + ".tmp";
+	// Replaced file keeps its permissions, new file follows umask as same as usual creation
+	struct stat st;
+	bool isExisting = !::stat(path.c_str(), &st);
+	int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd == -1) return false;
+	if (isExisting && ::fchmod(fd, st.st_mode & 07777)) {
+		::close(fd);
+		std::remove(tmp.c_str());
+		return false;
+	}
+
+	bool isWritten = true;
+	while (size && isWritten) {
+		ssize_t written = ::write(fd, data, size);
+		if (written == -1) {
+			isWritten = (errno == EINTR);
+			continue;
+		}
+		data += written;
+		size -= static_cast<size_t>(written);
+	}
+	// Flush data before rename so that the new name never refers to a partial file
+	isWritten = isWritten && !fsync(fd);
+	isWritten = !::close(fd) && isWritten;
+
+	if (!isWritten || std::rename(tmp.c_str(), path.c_str())) {
+		std::remove(tmp.c_str());
+		return false;
+	}
+
+	// Flush the directory entry so that the rename survives a crash
+	size_t sep = path.find_last_of('/');
+	std::string dir = (sep == std::string::npos) ? "." : (sep ? path.substr(0, sep) : "/");
+	int dirFd = ::open(dir.c_str(), O_RDONLY);
+	if (dirFd != -1) {
+		fsync(dirFd);	// Some file systems do not support it, but the file is already replaced
+		::close(dirFd);
+	}
+	return true;
+}
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/// Write a whole file through a temporary file and rename it over the destination.
+/// Readers and crashes see either the old file or the complete new one
+class AtomicFileWriter
+{
+public:
+	static bool write(std::string path, const char* data, size_t size);
+
+private:
+	AtomicFileWriter() {}
+};
@@ -1,5 +1,6 @@
 #include "binary_container.hpp"
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iterator>
 
@@ -72,38 +73,22 @@ void BinaryContainer::appendUint8(const uint8_t v)
 
 void BinaryContainer::appendInt16(const int16_t v)
 {
-	append({
-			   static_cast<char>(0x00ff & v),
-			   static_cast<char>(v >> 8),
-		   });
+	append(static_cast<uint16_t>(v), 2);
 }
 
 void BinaryContainer::appendUint16(const uint16_t v)
 {
-	append({
-			   static_cast<char>(0x00ff & v),
-			   static_cast<char>(v >> 8),
-		   });
+	append(static_cast<uint16_t>(v), 2);
 }
 
 void BinaryContainer::appendInt32(const int32_t v)
 {
-	append({
-			   static_cast<char>(0x000000ff & v),
-			   static_cast<char>(0x0000ff & (v >> 8)),
-			   static_cast<char>(0x00ff & (v >> 16)),
-			   static_cast<char>(v >> 24),
-		   });
+	append(static_cast<uint32_t>(v), 4);
 }
 
 void BinaryContainer::appendUint32(const uint32_t v)
 {
-	append({
-			   static_cast<char>(0x000000ff & v),
-			   static_cast<char>(0x0000ff & (v >> 8)),
-			   static_cast<char>(0x00ff & (v >> 16)),
-			   static_cast<char>(v >> 24),
-		   });
+	append(static_cast<uint32_t>(v), 4);
 }
 
 void BinaryContainer::appendChar(const char c)
@@ -111,9 +96,14 @@ void BinaryContainer::appendChar(const char c)
 	buf_.push_back(c);
 }
 
-void BinaryContainer::appendString(const std::string str)
+void BinaryContainer::appendString(const std::string& str)
 {
-	std::copy(str.begin(), str.end(), std::back_inserter(buf_));
+	buf_.insert(buf_.end(), str.begin(), str.end());
+}
+
+void BinaryContainer::appendBytes(const std::vector<char>& bytes)
+{
+	buf_.insert(buf_.end(), bytes.begin(), bytes.end());
 }
 
 void BinaryContainer::writeInt8(size_t offset, const int8_t v)
@@ -128,38 +118,22 @@ void BinaryContainer::writeUint8(size_t offset, const uint8_t v)
 
 void BinaryContainer::writeInt16(size_t offset, const int16_t v)
 {
-	write(offset, {
-			  static_cast<char>(0x00ff & v),
-			  static_cast<char>(v >> 8),
-		  });
+	write(offset, static_cast<uint16_t>(v), 2);
 }
 
 void BinaryContainer::writeUint16(size_t offset, const uint16_t v)
 {
-	write(offset, {
-			  static_cast<char>(0x00ff & v),
-			  static_cast<char>(v >> 8),
-		  });
+	write(offset, static_cast<uint16_t>(v), 2);
 }
 
 void BinaryContainer::writeInt32(size_t offset, const int32_t v)
 {
-	write(offset, {
-			  static_cast<char>(0x000000ff & v),
-			  static_cast<char>(0x0000ff & (v >> 8)),
-			  static_cast<char>(0x00ff & (v >> 16)),
-			  static_cast<char>(v >> 24),
-		  });
+	write(offset, static_cast<uint32_t>(v), 4);
 }
 
 void BinaryContainer::writeUint32(size_t offset, const uint32_t v)
 {
-	write(offset, {
-			  static_cast<char>(0x000000ff & v),
-			  static_cast<char>(0x0000ff & (v >> 8)),
-			  static_cast<char>(0x00ff & (v >> 16)),
-			  static_cast<char>(v >> 24),
-		  });
+	write(offset, static_cast<uint32_t>(v), 4);
 }
 
 void BinaryContainer::writeChar(size_t offset, const char c)
@@ -167,77 +141,75 @@ void BinaryContainer::writeChar(size_t offset, const char c)
 	buf_.at(offset) = c;
 }
 
-void BinaryContainer::writeString(size_t offset, const std::string str)
+void BinaryContainer::writeString(size_t offset, const std::string& str)
+{
+	if (!str.empty()) std::memcpy(&buf_.at(offset), str.data(), str.size());
+}
+
+int8_t BinaryContainer::readInt8(size_t offset) const
 {
-	std::copy(str.begin(), str.end(), buf_.begin() + offset);
+	return getReader().readInt8(offset);
 }
 
-int8_t BinaryContainer::readInt8(size_t offset)
+uint8_t BinaryContainer::readUint8(size_t offset) const
 {
-	return static_cast<int8_t>(buf_.at(offset));
+	return getReader().readUint8(offset);
 }
 
-uint8_t BinaryContainer::readUint8(size_t offset)
+int16_t BinaryContainer::readInt16(size_t offset) const
 {
-	return static_cast<uint8_t>(buf_.at(offset));
+	return getReader().readInt16(offset);
 }
 
-int16_t BinaryContainer::readInt16(size_t offset)
+uint16_t BinaryContainer::readUint16(size_t offset) const
 {
-	std::vector<unsigned char> data = read(offset, 2);
-	return static_cast<int16_t>(data[0] | (data[1] << 8));
+	return getReader().readUint16(offset);
 }
 
-uint16_t BinaryContainer::readUint16(size_t offset)
+int32_t BinaryContainer::readInt32(size_t offset) const
 {
-	std::vector<unsigned char> data = read(offset, 2);
-	return static_cast<uint16_t>(data[0] | (data[1] << 8));
+	return getReader().readInt32(offset);
 }
 
-int32_t BinaryContainer::readInt32(size_t offset)
+uint32_t BinaryContainer::readUint32(size_t offset) const
 {
-	std::vector<unsigned char> data = read(offset, 4);
-	return static_cast<int32_t>(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
+	return getReader().readUint32(offset);
 }
 
-uint32_t BinaryContainer::readUint32(size_t offset)
+char BinaryContainer::readChar(size_t offset) const
 {
-	std::vector<unsigned char> data = read(offset, 4);
-	return static_cast<uint32_t>(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
+	return getReader().readChar(offset);
 }
 
-char BinaryContainer::readChar(size_t offset)
+std::string BinaryContainer::readString(size_t offset, size_t length) const
 {
-	return buf_.at(offset);
+	return getReader().readString(offset, length);
 }
 
-std::string BinaryContainer::readString(size_t offset, size_t length)
+std::vector<char> BinaryContainer::getBytes(size_t offset) const
 {
-	return std::string(buf_.begin() + offset, buf_.begin() + offset + length);
+	return std::vector<char>(buf_.begin() + offset, buf_.end());
 }
 
-void BinaryContainer::append(std::vector<char> a)
+BinaryReader BinaryContainer::getReader() const
 {
-	if (isLE_)
-		std::copy(a.begin(), a.end(), std::back_inserter(buf_));
-	else
-		std::reverse_copy(a.begin(), a.end(), std::back_inserter(buf_));
+	return BinaryReader(buf_.data(), buf_.size(), isLE_);
 }
 
-void BinaryContainer::write(size_t offset, std::vector<char> a)
+void BinaryContainer::append(uint32_t v, size_t size)
 {
-	if (isLE_)
-		std::copy(a.begin(), a.end(), buf_.begin() + offset);
-	else
-		std::reverse_copy(a.begin(), a.end(), buf_.begin() + offset);
+	size_t offset = buf_.size();
+	buf_.resize(offset + size);	// No allocation while the capacity is reserved
+	write(offset, v, size);
 }
 
-std::vector<unsigned char> BinaryContainer::read(size_t offset, size_t size)
+void BinaryContainer::write(size_t offset, uint32_t v, size_t size)
 {
-	std::vector<unsigned char> data;
-	if (isLE_)
-		std::copy(buf_.begin() + offset, buf_.begin() + offset + size, std::back_inserter(data));
-	else
-		std::reverse_copy(buf_.begin() + offset, buf_.begin() + offset + size, std::back_inserter(data));
-	return data;
+	char* p = &buf_[offset];
+	if (isLE_) {
+		for (size_t i = 0; i < size; ++i, v >>= 8) p[i] = static_cast<char>(v & 0xff);
+	}
+	else {
+		for (size_t i = size; i > 0; --i, v >>= 8) p[i - 1] = static_cast<char>(v & 0xff);
+	}
 }
@@ -3,6 +3,7 @@
 #include <vector>
 #include <cstdint>
 #include <string>
+#include "binary_reader.hpp"
 
 class BinaryContainer
 {
@@ -25,7 +26,8 @@ public:
 	void appendInt32(const int32_t v);
 	void appendUint32(const uint32_t v);
 	void appendChar(const char c);
-	void appendString(const std::string str);
+	void appendString(const std::string& str);
+	void appendBytes(const std::vector<char>& bytes);
 
 	void writeInt8(size_t offset, const int8_t v);
 	void writeUint8(size_t offset, const uint8_t v);
@@ -34,22 +36,27 @@ public:
 	void writeInt32(size_t offset, const int32_t v);
 	void writeUint32(size_t offset, const uint32_t v);
 	void writeChar(size_t offset, const char c);
-	void writeString(size_t offset, const std::string str);
-
-	int8_t readInt8(size_t offset);
-	uint8_t readUint8(size_t offset);
-	int16_t readInt16(size_t offset);
-	uint16_t readUint16(size_t offset);
-	int32_t readInt32(size_t offset);
-	uint32_t readUint32(size_t offset);
-	char readChar(size_t offset);
-	std::string readString(size_t offset, size_t length);
+	void writeString(size_t offset, const std::string& str);
+
+	int8_t readInt8(size_t offset) const;
+	uint8_t readUint8(size_t offset) const;
+	int16_t readInt16(size_t offset) const;
+	uint16_t readUint16(size_t offset) const;
+	int32_t readInt32(size_t offset) const;
+	uint32_t readUint32(size_t offset) const;
+	char readChar(size_t offset) const;
+	std::string readString(size_t offset, size_t length) const;
+	/// Copy from the offset to the end
+	std::vector<char> getBytes(size_t offset) const;
+
+	/// The reader is valid until the container is modified
+	BinaryReader getReader() const;
 
 private:
 	std::vector<char> buf_;
 	bool isLE_;
 
-	void append(std::vector<char> a);
-	void write(size_t offset, std::vector<char> a);
-	std::vector<unsigned char> read(size_t offset, size_t size);
+	/// Store lower [size] bytes of the value in the container endian
+	void append(uint32_t v, size_t size);
+	void write(size_t offset, uint32_t v, size_t size);
 };
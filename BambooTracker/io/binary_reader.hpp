@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <stdexcept>
+
+/// Read-only view over contiguous binary data. It does not own the data.
+/// Reads out of range throw std::out_of_range
+class BinaryReader
+{
+public:
+	BinaryReader(const char* data, size_t size, bool isLittleEndian = true)
+		: data_(data), size_(size), isLE_(isLittleEndian) {}
+
+	size_t size() const { return size_; }
+	const char* data() const { return data_; }
+	bool isLittleEndian() const { return isLE_; }
+
+	int8_t readInt8(size_t offset) const { return static_cast<int8_t>(*at(offset, 1)); }
+	uint8_t readUint8(size_t offset) const { return static_cast<uint8_t>(*at(offset, 1)); }
+	int16_t readInt16(size_t offset) const { return static_cast<int16_t>(load(offset, 2)); }
+	uint16_t readUint16(size_t offset) const { return static_cast<uint16_t>(load(offset, 2)); }
+	int32_t readInt32(size_t offset) const { return static_cast<int32_t>(load(offset, 4)); }
+	uint32_t readUint32(size_t offset) const { return load(offset, 4); }
+	char readChar(size_t offset) const { return *at(offset, 1); }
+
+	std::string readString(size_t offset, size_t length) const
+	{
+		return std::string(at(offset, length), length);
+	}
+
+	/// Compare bytes with the string without making a copy
+	bool matchString(size_t offset, const char* str, size_t length) const
+	{
+		return (offset <= size_ && length <= size_ - offset && !std::memcmp(data_ + offset, str, length));
+	}
+
+	/// Compare with string literal such as section tags
+	template <size_t N>
+	bool matchString(size_t offset, const char (&str)[N]) const
+	{
+		return matchString(offset, str, N - 1);
+	}
+
+private:
+	const char* data_;
+	size_t size_;
+	bool isLE_;
+
+	const char* at(size_t offset, size_t length) const
+	{
+		if (offset > size_ || length > size_ - offset)
+			throw std::out_of_range("BinaryReader: read out of range");
+		return data_ + offset;
+	}
+
+	uint32_t load(size_t offset, size_t length) const
+	{
+		const unsigned char* p = reinterpret_cast<const unsigned char*>(at(offset, length));
+		uint32_t v = 0;
+		if (isLE_) {
+			for (size_t i = length; i > 0; --i) v = (v << 8) | p[i - 1];
+		}
+		else {
+			for (size_t i = 0; i < length; ++i) v = (v << 8) | p[i];
+		}
+		return v;
+	}
+};
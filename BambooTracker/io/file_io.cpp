@@ -1,6 +1,9 @@
 #include "file_io.hpp"
 #include <fstream>
+#include <algorithm>
+#include <stdexcept>
 #include "version.hpp"
+#include "lz_compressor.hpp"
 #include "misc.hpp"
 
 const FMEnvelopeParameter FileIO::ENV_FM_PARAMS[38] = {
@@ -45,16 +48,68 @@ const FMEnvelopeParameter FileIO::ENV_FM_PARAMS[38] = {
 };
 
 bool FileIO::saveModule(std::string path, std::weak_ptr<Module> mod,
-						std::weak_ptr<InstrumentsManager> instMan)
+						std::weak_ptr<InstrumentsManager> instMan, ModuleSaveCache* cache, int compressionLevel)
 {
-	BinaryContainer ctr;
+	BinaryContainer ctr(estimateModuleSize(mod));
+
+	ctr.appendString("BambooTrackerMod");
+	size_t eofOfs = ctr.size();
+	ctr.appendUint32(0);	// Dummy EOF offset
+	if (cache) cache->begin();
+	if (compressionLevel > 0) {
+		ctr.appendUint32(Version::ofCompressedModuleFileInBCD());
+		ctr.appendUint32(Version::ofModuleFileInBCD());
+		BinaryContainer secCtr;
+		appendModuleSectionsBeforeSongs(secCtr, mod, instMan);
+		appendCompressedBlock(ctr, secCtr, compressionLevel);
+	}
+	else {
+		ctr.appendUint32(Version::ofModuleFileInBCD());
+		appendModuleSectionsBeforeSongs(ctr, mod, instMan);
+	}
+	appendSongSection(ctr, mod, cache, compressionLevel);
+	ctr.writeUint32(eofOfs, ctr.size() - eofOfs);
+
+	mod.lock()->setFilePath(path);
+
+
+	if (!ctr.save(path)) return false;
+	if (cache) cache->finish();
+	return true;
+}
 
+std::future<bool> FileIO::saveModuleInBackground(std::string path, std::weak_ptr<Module> mod,
+												  std::weak_ptr<InstrumentsManager> instMan)
+{
+	// Instruments refer to the manager and are small, so they are serialized here.
+	// Patterns in the snapshot share steps with the module until they are edited,
+	// and songs which are not decoded yet are decoded from the snapshot on the worker
+	BinaryContainer ctr;
 	ctr.appendString("BambooTrackerMod");
 	size_t eofOfs = ctr.size();
 	ctr.appendUint32(0);	// Dummy EOF offset
 	ctr.appendUint32(Version::ofModuleFileInBCD());
+	appendModuleSectionsBeforeSongs(ctr, mod, instMan);
+	auto snapshot = std::make_shared<Module>(*mod.lock());
 
+	return std::async(std::launch::async, [path, eofOfs, snapshot, ctr = std::move(ctr)]() mutable {
+		try {
+			ctr.reserve(estimateModuleSize(snapshot));
+			appendSongSection(ctr, snapshot, nullptr, 0);
+			ctr.writeUint32(eofOfs, ctr.size() - eofOfs);
+
+			BinaryReader reader = ctr.getReader();
+			return AtomicFileWriter::write(path, reader.data(), reader.size());
+		}
+		catch (...) {
+			return false;
+		}
+	});
+}
 
+void FileIO::appendModuleSectionsBeforeSongs(BinaryContainer& ctr, std::weak_ptr<Module> mod,
+											 std::weak_ptr<InstrumentsManager> instMan)
+{
 	/***** Module section *****/
 	ctr.appendString("MODULE  ");
 	size_t modOfs = ctr.size();
@@ -626,14 +681,19 @@ bool FileIO::saveModule(std::string path, std::weak_ptr<Module> mod,
 		}
 	}
 	ctr.writeUint32(grooveOfs, ctr.size() - grooveOfs);
+}
 
-
+void FileIO::appendSongSection(BinaryContainer& ctr, std::weak_ptr<Module> mod, ModuleSaveCache* cache,
+							   int compressionLevel)
+{
 	/***** Song section *****/
 	ctr.appendString("SONG    ");
 	size_t songSecOfs = ctr.size();
 	ctr.appendUint32(0);	// Dummy song section offset
 	size_t songCnt = mod.lock()->getSongCount();
 	ctr.appendUint8(songCnt);
+	std::vector<int> stepIdcs;
+	stepIdcs.reserve(256);
 
 	// Song
 	for (size_t i = 0; i < songCnt; ++i) {
@@ -655,120 +715,218 @@ bool FileIO::saveModule(std::string path, std::weak_ptr<Module> mod,
 		default:									break;
 		}
 
-		// Track
+		// Track, compressed in a block for each track if needed
+		BinaryContainer trackCtr;
+		BinaryContainer& tctr = (compressionLevel > 0) ? trackCtr : ctr;
 		for (auto& attrib : style.trackAttribs) {
-			ctr.appendUint8(attrib.number);
-			size_t trackOfs = ctr.size();
-			ctr.appendUint32(0);	// Dummy track subblock offset
-			auto& track = sng.getTrack(attrib.number);
+			tctr.appendUint8(attrib.number);
+			size_t trackOfs = tctr.size();
+			tctr.appendUint32(0);	// Dummy track subblock offset
+			const Track& track = sng.getTrack(attrib.number);
 
 			// Order
 			size_t odrSize = track.getOrderSize();
-			ctr.appendUint8(odrSize - 1);
+			tctr.appendUint8(odrSize - 1);
 			for (size_t o = 0; o < odrSize; ++o)
-				ctr.appendUint8(track.getOrderData(o).patten);
+				tctr.appendUint8(track.getOrderData(o).patten);
 
 			// Pattern
 			for (auto& idx : track.getEditedPatternIndices()) {
-				ctr.appendUint8(idx);
-				size_t ptnOfs = ctr.size();
-				ctr.appendUint32(0);	// Dummy pattern subblock offset
+				tctr.appendUint8(idx);
+				size_t ptnOfs = tctr.size();
+				tctr.appendUint32(0);	// Dummy pattern subblock offset
 				auto& pattern = track.getPattern(idx);
 
 				// Step
-				std::vector<int> stepIdcs = pattern.getEditedStepIndices();
-				for (auto& sidx : stepIdcs) {
-					ctr.appendUint8(sidx);
-					size_t evFlagOfs = ctr.size();
-					ctr.appendUint16(0);	// Dummy set event flag
-					auto& step = pattern.getStep(sidx);
-					uint16_t eventFlag = 0;
-					int tmp = step.getNoteNumber();
-					if (tmp != -1) {
-						eventFlag |= 0x0001;
-						ctr.appendInt8(tmp);
-					}
-					tmp = step.getInstrumentNumber();
-					if (tmp != -1) {
-						eventFlag |= 0x0002;
-						ctr.appendUint8(tmp);
-					}
-					tmp = step.getVolume();
-					if (tmp != -1) {
-						eventFlag |= 0x0004;
-						ctr.appendUint8(tmp);
-					}
-					for (int i = 0; i < 4; ++i) {
-						std::string tmpstr = step.getEffectID(i);
-						if (tmpstr != "--") {
-							eventFlag |= (0x0008 << (i << 1));
-							ctr.appendString(tmpstr);
-						}
-						tmp = step.getEffectValue(i);
-						if (tmp != -1) {
-							eventFlag |= (0x0010 << (i << 1));
-							ctr.appendUint8(tmp);
-						}
-					}
-					ctr.writeUint16(evFlagOfs, eventFlag);
+				const std::vector<char>* block = cache ? cache->reusePattern(pattern.getRevision()) : nullptr;
+				if (block) {
+					tctr.appendBytes(*block);
+				}
+				else {
+					size_t stepOfs = tctr.size();
+					appendStepsInPattern(tctr, pattern, stepIdcs);
+					if (cache) cache->storePattern(pattern.getRevision(), tctr.getBytes(stepOfs));
 				}
 
-				ctr.writeUint32(ptnOfs, ctr.size() - ptnOfs);
+				tctr.writeUint32(ptnOfs, tctr.size() - ptnOfs);
 			}
 
-			ctr.writeUint32(trackOfs, ctr.size() - trackOfs);
+			tctr.writeUint32(trackOfs, tctr.size() - trackOfs);
+			if (compressionLevel > 0) {
+				appendCompressedBlock(ctr, trackCtr, compressionLevel);
+				trackCtr.clear();
+			}
 		}
 		ctr.writeUint32(songOfs, ctr.size() - songOfs);
 
 	}
 	ctr.writeUint32(songSecOfs, ctr.size() - songSecOfs);
+}
 
-	ctr.writeUint32(eofOfs, ctr.size() - eofOfs);
+void FileIO::appendStepsInPattern(BinaryContainer& ctr, const Pattern& pattern, std::vector<int>& stepIdcs)
+{
+	pattern.getEditedStepIndices(stepIdcs);
+	for (auto& sidx : stepIdcs) {
+		ctr.appendUint8(sidx);
+		size_t evFlagOfs = ctr.size();
+		ctr.appendUint16(0);	// Dummy set event flag
+		auto& step = pattern.getStep(sidx);
+		uint16_t eventFlag = 0;
+		int tmp = step.getNoteNumber();
+		if (tmp != -1) {
+			eventFlag |= 0x0001;
+			ctr.appendInt8(tmp);
+		}
+		tmp = step.getInstrumentNumber();
+		if (tmp != -1) {
+			eventFlag |= 0x0002;
+			ctr.appendUint8(tmp);
+		}
+		tmp = step.getVolume();
+		if (tmp != -1) {
+			eventFlag |= 0x0004;
+			ctr.appendUint8(tmp);
+		}
+		for (int i = 0; i < 4; ++i) {
+			std::string tmpstr = step.getEffectID(i);
+			if (tmpstr != "--") {
+				eventFlag |= (0x0008 << (i << 1));
+				ctr.appendString(tmpstr);
+			}
+			tmp = step.getEffectValue(i);
+			if (tmp != -1) {
+				eventFlag |= (0x0010 << (i << 1));
+				ctr.appendUint8(tmp);
+			}
+		}
+		ctr.writeUint16(evFlagOfs, eventFlag);
+	}
+}
 
-	mod.lock()->setFilePath(path);
+void FileIO::appendCompressedBlock(BinaryContainer& ctr, const BinaryContainer& src, int level)
+{
+	BinaryReader raw = src.getReader();
+	std::vector<char> data;
+	data.reserve(raw.size() / 2);
+	LZCompressor::compress(raw.data(), raw.size(), level, data);
+	ctr.appendUint32(raw.size());
+	ctr.appendUint32(data.size());
+	ctr.appendUint32(LZCompressor::checksum(data.data(), data.size()));
+	ctr.appendBytes(data);
+}
+
+size_t FileIO::checkCompressedBlock(const BinaryReader& ctr, size_t csr)
+{
+	size_t dataSize = ctr.readUint32(csr + 4);
+	uint32_t sum = ctr.readUint32(csr + 8);
+	csr += 12;
+	if (dataSize > ctr.size() - csr || LZCompressor::checksum(ctr.data() + csr, dataSize) != sum)
+		throw std::out_of_range("Broken compressed block");
+	return csr + dataSize;
+}
 
+size_t FileIO::readCompressedBlock(const BinaryReader& ctr, size_t csr, std::vector<char>& raw)
+{
+	size_t rawSize = ctr.readUint32(csr);
+	size_t dataSize = ctr.readUint32(csr + 4);
+	csr += 12;
+	// Each data byte is expanded to 255 bytes at most
+	if (dataSize > ctr.size() - csr || rawSize / 256 > dataSize) throw std::out_of_range("Broken compressed block");
+	raw.resize(rawSize);
+	if (!LZCompressor::decompress(ctr.data() + csr, dataSize, raw.data(), rawSize))
+		throw std::out_of_range("Broken compressed block");
+	return csr + dataSize;
+}
 
-	return ctr.save(path);
+size_t FileIO::estimateModuleSize(std::weak_ptr<Module> mod)
+{
+	// Instrument properties and grooves are small, so the container grows for them if needed
+	size_t size = 0x10000;
+
+	auto m = mod.lock();
+	for (size_t i = 0; i < m->getSongCount(); ++i) {
+		auto& sng = m->getSong(i);
+		// Edited step takes 18 bytes at most: index, event flag, note, instrument, volume and 4 effects
+		size_t ptnSize = 5 + 18 * sng.getDefaultPatternSize();
+		// Count patterns by orders not to scan all steps.
+		// Edited patterns which are not in orders are not counted
+		for (auto& attrib : sng.getStyle().trackAttribs) {
+			size_t odrSize = sng.getTrack(attrib.number).getOrderSize();
+			size += 6 + odrSize + odrSize * ptnSize;
+		}
+	}
+
+	return size;
 }
 
 bool FileIO::loadModuel(std::string path, std::weak_ptr<Module> mod,
 						std::weak_ptr<InstrumentsManager> instMan)
 {
-	BinaryContainer ctr;
+	// Encoded tracks are copied for decoders of songs, so the file is not kept mapped after loading
+	MappedFile file;
+
+	if (!file.open(path)) return false;
+	const BinaryReader ctr = file.getReader();
+
+	try {
+		size_t globCsr = 0;
+		if (!ctr.matchString(globCsr, "BambooTrackerMod")) return false;
+		globCsr += 16;
+		size_t eofOfs = ctr.readUint32(globCsr);
+		size_t eof = globCsr + eofOfs;
+		globCsr += 4;
+		size_t fileVersion = ctr.readUint32(globCsr);
+		globCsr += 4;
+
+		// Version of compressed container is reserved, and the version of sections follows it
+		if (fileVersion == Version::ofCompressedModuleFileInBCD()) {
+			size_t secVersion = ctr.readUint32(globCsr);
+			if (secVersion > Version::ofModuleFileInBCD()) return false;
+			globCsr += 4;
+			// Sections before songs are compressed in a block,
+			// and tracks in each song are decompressed when the song is decoded
+			std::vector<char> raw;
+			checkCompressedBlock(ctr, globCsr);
+			globCsr = readCompressedBlock(ctr, globCsr, raw);
+			if (!loadSectionsInModule(mod, instMan, BinaryReader(raw.data(), raw.size()), 0, raw.size(), false))
+				return false;
+			if (!loadSectionsInModule(mod, instMan, ctr, globCsr, eof, true)) return false;
+		}
+		else {
+			if (fileVersion > Version::ofModuleFileInBCD()) return false;
+			if (!loadSectionsInModule(mod, instMan, ctr, globCsr, eof, false)) return false;
+		}
+	}
+	catch (std::out_of_range&) {	// Broken file
+		return false;
+	}
 
-	if (!ctr.load(path)) return false;
+	mod.lock()->setFilePath(path);
 
-	size_t globCsr = 0;
-	if (ctr.readString(globCsr, 16) != "BambooTrackerMod") return false;
-	globCsr += 16;
-	size_t eofOfs = ctr.readUint32(globCsr);
-	size_t eof = globCsr + eofOfs;
-	globCsr += 4;
-	size_t fileVersion = ctr.readUint32(globCsr);
-	if (fileVersion > Version::ofModuleFileInBCD()) return false;
-	globCsr += 4;
+	return true;
+}
 
+bool FileIO::loadSectionsInModule(std::weak_ptr<Module> mod, std::weak_ptr<InstrumentsManager> instMan,
+								  const BinaryReader& ctr, size_t globCsr, size_t eof, bool isCompressedTracks)
+{
 	while (globCsr < eof) {
-		if (ctr.readString(globCsr, 8) == "MODULE  ")
+		if (ctr.matchString(globCsr, "MODULE  "))
 			globCsr = loadModuleSectionInModule(mod, ctr, globCsr + 8);
-		else if (ctr.readString(globCsr, 8) == "INSTRMNT")
+		else if (ctr.matchString(globCsr, "INSTRMNT"))
 			globCsr = loadInstrumentSectionInModule(instMan, ctr, globCsr + 8);
-		else if (ctr.readString(globCsr, 8) == "INSTPROP")
+		else if (ctr.matchString(globCsr, "INSTPROP"))
 			globCsr = loadInstrumentPropertySectionInModule(instMan, ctr, globCsr + 8);
-		else if (ctr.readString(globCsr, 8) == "GROOVE  ")
+		else if (ctr.matchString(globCsr, "GROOVE  "))
 			globCsr = loadGrooveSectionInModule(mod, ctr, globCsr + 8);
-		else if (ctr.readString(globCsr, 8) == "SONG    ")
-			globCsr = loadSongSectionInModule(mod, ctr, globCsr + 8);
+		else if (ctr.matchString(globCsr, "SONG    "))
+			globCsr = loadSongSectionInModule(mod, ctr, globCsr + 8, isCompressedTracks);
 		else
 			return false;
 	}
-
-	mod.lock()->setFilePath(path);
-
 	return true;
 }
 
-size_t FileIO::loadModuleSectionInModule(std::weak_ptr<Module> mod, BinaryContainer& ctr, size_t globCsr)
+size_t FileIO::loadModuleSectionInModule(std::weak_ptr<Module> mod, const BinaryReader& ctr, size_t globCsr)
 {
 	size_t modOfs = ctr.readUint32(globCsr);
 	size_t modCsr = globCsr + 4;
@@ -805,7 +963,7 @@ size_t FileIO::loadModuleSectionInModule(std::weak_ptr<Module> mod, BinaryContai
 }
 
 size_t FileIO::loadInstrumentSectionInModule(std::weak_ptr<InstrumentsManager> instMan,
-											 BinaryContainer& ctr, size_t globCsr)
+											 const BinaryReader& ctr, size_t globCsr)
 {
 	size_t instOfs = ctr.readUint32(globCsr);
 	size_t instCsr = globCsr + 4;
@@ -887,7 +1045,7 @@ size_t FileIO::loadInstrumentSectionInModule(std::weak_ptr<InstrumentsManager> i
 }
 
 size_t FileIO::loadInstrumentPropertySectionInModule(std::weak_ptr<InstrumentsManager> instMan,
-													 BinaryContainer& ctr, size_t globCsr)
+													 const BinaryReader& ctr, size_t globCsr)
 {
 	size_t instPropOfs = ctr.readUint32(globCsr);
 	size_t instPropCsr = globCsr + 4;
@@ -1745,7 +1903,7 @@ size_t FileIO::loadInstrumentPropertySectionInModule(std::weak_ptr<InstrumentsMa
 size_t FileIO::loadInstrumentPropertyOperatorSequence(FMEnvelopeParameter param,
 													  size_t instMemCsr,
 													  std::weak_ptr<InstrumentsManager> instMan,
-													  BinaryContainer& ctr)
+													  const BinaryReader& ctr)
 {
 	uint8_t idx = ctr.readUint8(instMemCsr++);
 	uint16_t ofs = ctr.readUint16(instMemCsr);
@@ -1803,7 +1961,7 @@ size_t FileIO::loadInstrumentPropertyOperatorSequence(FMEnvelopeParameter param,
 	return ofs + 1;
 }
 
-size_t FileIO::loadGrooveSectionInModule(std::weak_ptr<Module> mod, BinaryContainer& ctr, size_t globCsr)
+size_t FileIO::loadGrooveSectionInModule(std::weak_ptr<Module> mod, const BinaryReader& ctr, size_t globCsr)
 {
 	size_t grvOfs = ctr.readUint32(globCsr);
 	size_t grvCsr = globCsr + 4;
@@ -1823,7 +1981,8 @@ size_t FileIO::loadGrooveSectionInModule(std::weak_ptr<Module> mod, BinaryContai
 	return globCsr + grvOfs;
 }
 
-size_t FileIO::loadSongSectionInModule(std::weak_ptr<Module> mod, BinaryContainer& ctr, size_t globCsr)
+size_t FileIO::loadSongSectionInModule(std::weak_ptr<Module> mod, const BinaryReader& ctr, size_t globCsr,
+									   bool isCompressedTracks)
 {
 	size_t songOfs = ctr.readUint32(globCsr);
 	size_t songCsr = globCsr + 4;
@@ -1855,75 +2014,159 @@ size_t FileIO::loadSongSectionInModule(std::weak_ptr<Module> mod, BinaryContaine
 			break;
 		}
 		}
-		auto& song = mod.lock()->getSong(idx);
-		while (scsr < songCsr) {
-			// Song
-			uint8_t trackIdx = ctr.readUint8(scsr++);
-			auto& track = song.getTrack(trackIdx);
-			size_t trackOfs = ctr.readUint32(scsr);
-			size_t trackEnd = scsr + trackOfs;
-			size_t tcsr = scsr + 4;
-			uint8_t odrLen = ctr.readUint8(tcsr++) + 1;
-			for (uint8_t oi = 0; oi < odrLen; ++oi) {
-				if (!oi)
-					track.registerPatternToOrder(oi, ctr.readUint8(tcsr++));
-				else {
-					track.insertOrderBelow(oi - 1);
-					track.registerPatternToOrder(oi, ctr.readUint8(tcsr++));
+
+		// Tracks are decoded when the song is first accessed.
+		// They are checked here so that a broken song fails loading
+		if (scsr > songCsr || songCsr > ctr.size()) throw std::out_of_range("Broken song section");
+		Song& song = mod.lock()->getSong(idx);
+		size_t trackCnt = song.getTrackAttributes().size();
+		if (isCompressedTracks) {
+			// Only checksums of compressed tracks are checked here,
+			// and each track is decompressed into a reused buffer and parsed when the song is decoded
+			auto data = std::make_shared<std::vector<char>>(ctr.data() + scsr, ctr.data() + songCsr);
+			BinaryReader blocks(data->data(), data->size());
+			for (size_t bcsr = 0; bcsr < blocks.size();) bcsr = checkCompressedBlock(blocks, bcsr);
+			song.setDecoder([data, trackCnt, ptnSize](std::vector<Track>& tracks) {
+				BinaryReader blocks(data->data(), data->size());
+				std::vector<char> raw;
+				try {
+					for (size_t bcsr = 0; bcsr < blocks.size();) {
+						bcsr = readCompressedBlock(blocks, bcsr, raw);
+						BinaryReader tracksCtr(raw.data(), raw.size());
+						checkTracksInSong(tracksCtr, 0, tracksCtr.size(), trackCnt, ptnSize);
+						loadTracksInSong(tracks, tracksCtr, 0, tracksCtr.size());
+					}
 				}
+				catch (std::out_of_range&) {
+					// Data matching the checksum is broken only if it is forged,
+					// and the remaining tracks are left empty as accessors cannot report errors
+				}
+			});
+		}
+		else {
+			// Copy the encoded tracks because the file is closed after loading
+			auto data = std::make_shared<std::vector<char>>(ctr.data() + scsr, ctr.data() + songCsr);
+			checkTracksInSong(BinaryReader(data->data(), data->size()), 0, data->size(), trackCnt, ptnSize);
+			song.setDecoder([data](std::vector<Track>& tracks) {
+				loadTracksInSong(tracks, BinaryReader(data->data(), data->size()), 0, data->size());
+			});
+		}
+	}
+
+	return globCsr + songOfs;
+}
+
+void FileIO::checkTracksInSong(const BinaryReader& ctr, size_t csr, size_t end,
+							   size_t trackCnt, size_t ptnSize)
+{
+	// Same reads as loadTracksInSong
+	while (csr < end) {
+		if (ctr.readUint8(csr++) >= trackCnt) throw std::out_of_range("Broken track index");
+		size_t trackOfs = ctr.readUint32(csr);
+		size_t trackEnd = csr + trackOfs;
+		size_t tcsr = csr + 4;
+		tcsr += ctr.readUint8(tcsr) + 2u;	// Orders
+		if (tcsr > ctr.size()) throw std::out_of_range("Broken order");
+
+		while (tcsr < trackEnd) {
+			ctr.readUint8(tcsr++);
+			size_t ptnOfs = ctr.readUint32(tcsr);
+			size_t pcsr = tcsr + 4;
+			tcsr += ptnOfs;
+
+			while (pcsr < tcsr) {
+				if (ctr.readUint8(pcsr++) >= ptnSize) throw std::out_of_range("Broken step index");
+				uint16_t eventFlag = ctr.readUint16(pcsr);
+				pcsr += 2;
+				size_t len = 0;
+				if (eventFlag & 0x0001)	len += 1;	// Note
+				if (eventFlag & 0x0002)	len += 1;	// Instrument
+				if (eventFlag & 0x0004)	len += 1;	// Volume
+				for (int i = 0; i < 4; ++i) {
+					if (eventFlag & (0x0008 << (i << 1)))	len += 2;	// Effect ID
+					if (eventFlag & (0x0010 << (i << 1)))	len += 1;	// Effect value
+				}
+				if (len > ctr.size() - pcsr) throw std::out_of_range("Broken step");
+				pcsr += len;
 			}
+		}
 
-			// Pattern
-			while (tcsr < trackEnd) {
-				uint8_t ptnIdx = ctr.readUint8(tcsr++);
-				auto& pattern = track.getPattern(ptnIdx);
-				size_t ptnOfs = ctr.readUint32(tcsr);
-				size_t pcsr = tcsr + 4;
-				tcsr += ptnOfs;
+		csr += trackOfs;
+	}
+}
 
-				// Step
-				while (pcsr < tcsr) {
-					uint32_t stepIdx = ctr.readUint8(pcsr++);
-					auto& step = pattern.getStep(stepIdx);
-					uint16_t eventFlag = ctr.readUint16(pcsr);
+void FileIO::loadTracksInSong(std::vector<Track>& tracks, const BinaryReader& ctr, size_t csr, size_t end)
+{
+	while (csr < end) {
+		// Song
+		uint8_t trackIdx = ctr.readUint8(csr++);
+		auto& track = tracks.at(trackIdx);
+		size_t trackOfs = ctr.readUint32(csr);
+		size_t trackEnd = csr + trackOfs;
+		size_t tcsr = csr + 4;
+		int odrLen = ctr.readUint8(tcsr++) + 1;	// Up to 256
+		for (int oi = 0; oi < odrLen; ++oi) {
+			if (!oi)
+				track.registerPatternToOrder(oi, ctr.readUint8(tcsr++));
+			else {
+				track.insertOrderBelow(oi - 1);
+				track.registerPatternToOrder(oi, ctr.readUint8(tcsr++));
+			}
+		}
+
+		// Pattern
+		while (tcsr < trackEnd) {
+			uint8_t ptnIdx = ctr.readUint8(tcsr++);
+			auto& pattern = track.getPattern(ptnIdx);
+			size_t ptnOfs = ctr.readUint32(tcsr);
+			size_t pcsr = tcsr + 4;
+			tcsr += ptnOfs;
+
+			// Step
+			while (pcsr < tcsr) {
+				uint32_t stepIdx = ctr.readUint8(pcsr++);
+				auto& step = pattern.getStep(stepIdx);
+				uint16_t eventFlag = ctr.readUint16(pcsr);
+				pcsr += 2;
+				if (eventFlag & 0x0001)	step.setNoteNumber(ctr.readInt8(pcsr++));
+				if (eventFlag & 0x0002)	step.setInstrumentNumber(ctr.readUint8(pcsr++));
+				if (eventFlag & 0x0004)	step.setVolume(ctr.readUint8(pcsr++));
+				if (eventFlag & 0x0008)	{
+					step.setEffectID(0, ctr.readString(pcsr, 2));
+					pcsr += 2;
+				}
+				if (eventFlag & 0x0010)	step.setEffectValue(0, ctr.readUint8(pcsr++));
+				if (eventFlag & 0x0020)	{
+					step.setEffectID(1, ctr.readString(pcsr, 2));
+					pcsr += 2;
+				}
+				if (eventFlag & 0x0040)	step.setEffectValue(1, ctr.readUint8(pcsr++));
+				if (eventFlag & 0x0080)	{
+					step.setEffectID(2, ctr.readString(pcsr, 2));
 					pcsr += 2;
-					if (eventFlag & 0x0001)	step.setNoteNumber(ctr.readInt8(pcsr++));
-					if (eventFlag & 0x0002)	step.setInstrumentNumber(ctr.readUint8(pcsr++));
-					if (eventFlag & 0x0004)	step.setVolume(ctr.readUint8(pcsr++));
-					if (eventFlag & 0x0008)	{
-						step.setEffectID(0, ctr.readString(pcsr, 2));
-						pcsr += 2;
-					}
-					if (eventFlag & 0x0010)	step.setEffectValue(0, ctr.readUint8(pcsr++));
-					if (eventFlag & 0x0020)	{
-						step.setEffectID(1, ctr.readString(pcsr, 2));
-						pcsr += 2;
-					}
-					if (eventFlag & 0x0040)	step.setEffectValue(1, ctr.readUint8(pcsr++));
-					if (eventFlag & 0x0080)	{
-						step.setEffectID(2, ctr.readString(pcsr, 2));
-						pcsr += 2;
-					}
-					if (eventFlag & 0x0100)	step.setEffectValue(2, ctr.readUint8(pcsr++));
-					if (eventFlag & 0x0200)	{
-						step.setEffectID(3, ctr.readString(pcsr, 2));
-						pcsr += 2;
-					}
-					if (eventFlag & 0x0400)	step.setEffectValue(3, ctr.readUint8(pcsr++));
 				}
+				if (eventFlag & 0x0100)	step.setEffectValue(2, ctr.readUint8(pcsr++));
+				if (eventFlag & 0x0200)	{
+					step.setEffectID(3, ctr.readString(pcsr, 2));
+					pcsr += 2;
+				}
+				if (eventFlag & 0x0400)	step.setEffectValue(3, ctr.readUint8(pcsr++));
 			}
-
-			scsr += trackOfs;
 		}
-	}
 
-	return globCsr + songOfs;
+		csr += trackOfs;
+	}
 }
 
 bool FileIO::saveInstrument(std::string path, std::weak_ptr<InstrumentsManager> instMan, int instNum)
 {
 	BinaryContainer ctr;
+	appendInstrument(ctr, instMan, instNum);
+	return ctr.save(path);
+}
 
+void FileIO::appendInstrument(BinaryContainer& ctr, std::weak_ptr<InstrumentsManager> instMan, int instNum)
+{
 	ctr.appendString("BambooTrackerIst");
 	size_t eofOfs = ctr.size();
 	ctr.appendUint32(0);	// Dummy EOF offset
@@ -2408,1219 +2651,1232 @@ bool FileIO::saveInstrument(std::string path, std::weak_ptr<InstrumentsManager>
 	ctr.writeUint32(instPropOfs, ctr.size() - instPropOfs);
 
 	ctr.writeUint32(eofOfs, ctr.size() - eofOfs);
-
-	return ctr.save(path);
 }
 
 AbstractInstrument* FileIO::loadInstrument(std::string path, std::weak_ptr<InstrumentsManager> instMan, int instNum)
 {
-	BinaryContainer ctr;
-
-	if (!ctr.load(path)) return nullptr;
-
-	size_t globCsr = 0;
-	if (ctr.readString(globCsr, 16) != "BambooTrackerIst") return nullptr;
-	globCsr += 16;
-	size_t eofOfs = ctr.readUint32(globCsr);
-	globCsr += 4;
-	size_t fileVersion = ctr.readUint32(globCsr);
-	if (fileVersion > Version::ofInstrumentFileInBCD()) return nullptr;
-	globCsr += 4;
-
-
-	/***** Instrument section *****/
-	if (ctr.readString(globCsr, 8) != "INSTRMNT") return nullptr;
-	else {
-		globCsr += 8;
-		size_t instOfs = ctr.readUint32(globCsr);
-		size_t instCsr = globCsr + 4;
-		size_t nameLen = ctr.readUint32(instCsr);
-		instCsr += 4;
-		std::string name = u8"";
-		if (nameLen > 0) {
-			name = ctr.readString(instCsr, nameLen);
-			instCsr += nameLen;
-		}
-		AbstractInstrument* inst = nullptr;
-		switch (ctr.readUint8(instCsr++)) {
-		case 0x00:	// FM
-		{
-			inst = new InstrumentFM(instNum, name, instMan.lock().get());
-			dynamic_cast<InstrumentFM*>(inst)->setEnvelopeResetEnabled(
-						ctr.readUint8(instCsr++) ? true : false);
-			break;
-		}
-		case 0x01:	// SSG
-		{
-			inst = new InstrumentSSG(instNum, name, instMan.lock().get());
-			break;
-		}
-		}
-		globCsr += instOfs;
+	MappedFile file;
 
+	if (!file.open(path)) return nullptr;
+	return loadInstrument(file.getReader(), instMan, instNum);
+}
 
-		/***** Instrument property section *****/
-		if (ctr.readString(globCsr, 8) != "INSTPROP") return nullptr;
+AbstractInstrument* FileIO::loadInstrument(const BinaryReader& ctr, std::weak_ptr<InstrumentsManager> instMan,
+										   int instNum)
+{
+	try {
+		size_t globCsr = 0;
+		if (!ctr.matchString(globCsr, "BambooTrackerIst")) return nullptr;
+		globCsr += 16;
+		size_t eofOfs = ctr.readUint32(globCsr);
+		globCsr += 4;
+		size_t fileVersion = ctr.readUint32(globCsr);
+		if (fileVersion > Version::ofInstrumentFileInBCD()) return nullptr;
+		globCsr += 4;
+
+
+		/***** Instrument section *****/
+		if (!ctr.matchString(globCsr, "INSTRMNT")) return nullptr;
 		else {
 			globCsr += 8;
-			size_t instPropOfs = ctr.readUint32(globCsr);
-			size_t instPropCsr = globCsr + 4;
-			size_t instPropCsrTmp = instPropCsr;
-			globCsr += instPropOfs;
-			std::vector<int> nums;
-			// Check memory range
-			while (instPropCsr < globCsr) {
-				switch (ctr.readUint8(instPropCsr++)) {
-				case 0x00:	// FM envelope
-				{
-					nums.push_back(instMan.lock()->findFirstFreeEnvelopeFM());
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint8(instPropCsr);
-					break;
-				}
-				case 0x01:	// FM LFO
-				{
-					nums.push_back(instMan.lock()->findFirstFreeLFOFM());
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint8(instPropCsr);
-					break;
-				}
-				case 0x02:	// FM AL
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::AL));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x03:	// FM FB
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::FB));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x04:	// FM AR1
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::AR1));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x05:	// FM DR1
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DR1));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x06:	// FM SR1
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SR1));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x07:	// FM RR1
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::RR1));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x08:	// FM SL1
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SL1));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x09:	// FM TL1
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::TL1));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x0a:	// FM KS1
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::KS1));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x0b:	// FM ML1
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::ML1));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x0c:	// FM DT1
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DT1));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x0d:	// FM AR2
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::AR2));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x0e:	// FM DR2
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DR2));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x0f:	// FM SR2
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SR2));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x10:	// FM RR2
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::RR2));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x11:	// FM SL2
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SL2));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x12:	// FM TL2
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::TL2));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x13:	// FM KS2
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::KS2));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x14:	// FM ML2
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::ML2));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x15:	// FM DT2
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DT2));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x16:	// FM AR3
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::AR3));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x17:	// FM DR3
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DR3));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x18:	// FM SR3
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SR3));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x19:	// FM RR3
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::RR3));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x1a:	// FM SL3
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SL3));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x1b:	// FM TL3
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::TL3));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x1c:	// FM KS3
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::KS3));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x1d:	// FM ML3
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::ML3));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x1e:	// FM DT3
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DT3));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x1f:	// FM AR4
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::AR4));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x20:	// FM DR4
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DR4));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x21:	// FM SR4
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SR4));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x22:	// FM RR4
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::RR4));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x23:	// FM SL4
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SL4));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x24:	// FM TL4
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::TL4));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x25:	// FM KS4
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::KS4));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x26:	// FM ML4
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::ML4));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x27:	// FM DT4
-				{
-					nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DT4));
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x28:	// FM arpeggio
-				{
-					nums.push_back(instMan.lock()->findFirstFreeArpeggioFM());
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x29:	// FM pitch
-				{
-					nums.push_back(instMan.lock()->findFirstFreePitchFM());
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x30:	// SSG wave form
-				{
-					nums.push_back(instMan.lock()->findFirstFreeWaveFormSSG());
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x31:	// SSG tone/noise
-				{
-					nums.push_back(instMan.lock()->findFirstFreeToneNoiseSSG());
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x32:	// SSG envelope
-				{
-					nums.push_back(instMan.lock()->findFirstFreeEnvelopeSSG());
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x33:	// SSG arpeggio
-				{
-					nums.push_back(instMan.lock()->findFirstFreeArpeggioSSG());
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				case 0x34:	// SSG pitch
-				{
-					nums.push_back(instMan.lock()->findFirstFreePitchSSG());
-					if (nums.back() == -1) return nullptr;
-					instPropCsr += ctr.readUint16(instPropCsr);
-					break;
-				}
-				}
+			size_t instOfs = ctr.readUint32(globCsr);
+			size_t instCsr = globCsr + 4;
+			size_t nameLen = ctr.readUint32(instCsr);
+			instCsr += 4;
+			std::string name = u8"";
+			if (nameLen > 0) {
+				name = ctr.readString(instCsr, nameLen);
+				instCsr += nameLen;
 			}
-			// Read data
-			instPropCsr = instPropCsrTmp;
-			auto numIt = nums.begin();
-			while (instPropCsr < globCsr) {
-				switch (ctr.readUint8(instPropCsr++)) {
-				case 0x00:	// FM envelope
-				{
-					int idx = *numIt++;
-					dynamic_cast<InstrumentFM*>(inst)->setEnvelopeNumber(idx);
-					uint8_t ofs = ctr.readUint8(instPropCsr);
-					size_t csr = instPropCsr + 1;
-					uint8_t tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::AL, tmp >> 4);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::FB, tmp & 0x0f);
-					// Operator 1
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMOperatorEnabled(idx, 0, (0x20 & tmp) ? true : false);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::AR1, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::KS1, tmp >> 5);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DR1, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DT1, tmp >> 5);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SR1, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SL1, tmp >> 4);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::RR1, tmp & 0x0f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::TL1, tmp);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::ML1, tmp & 0x0f);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SSGEG1,
-														   (tmp & 0x80) ? -1 : ((tmp >> 4) & 0x07));
-					// Operator 2
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMOperatorEnabled(idx, 1, (0x20 & tmp) ? true : false);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::AR2, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::KS2, tmp >> 5);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DR2, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DT2, tmp >> 5);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SR2, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SL2, tmp >> 4);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::RR2, tmp & 0x0f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::TL2, tmp);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::ML2, tmp & 0x0f);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SSGEG2,
-														   (tmp & 0x80) ? -1 : ((tmp >> 4) & 0x07));
-					// Operator 3
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMOperatorEnabled(idx, 2, (0x20 & tmp) ? true : false);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::AR3, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::KS3, tmp >> 5);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DR3, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DT3, tmp >> 5);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SR3, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SL3, tmp >> 4);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::RR3, tmp & 0x0f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::TL3, tmp);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::ML3, tmp & 0x0f);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SSGEG3,
-														   (tmp & 0x80) ? -1 : ((tmp >> 4) & 0x07));
-					// Operator 4
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMOperatorEnabled(idx, 3, (0x20 & tmp) ? true : false);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::AR4, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::KS4, tmp >> 5);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DR4, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DT4, tmp >> 5);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SR4, tmp & 0x1f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SL4, tmp >> 4);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::RR4, tmp & 0x0f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::TL4, tmp);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::ML4, tmp & 0x0f);
-					instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SSGEG4,
-														   (tmp & 0x80) ? -1 : ((tmp >> 4) & 0x07));
-					instPropCsr += ofs;
-					break;
-				}
-				case 0x01:	// FM LFO
-				{
-					int idx = *numIt++;
-					auto fm = dynamic_cast<InstrumentFM*>(inst);
-					fm->setLFOEnabled(true);
-					fm->setLFONumber(idx);
-					uint8_t ofs = ctr.readUint8(instPropCsr);
-					size_t csr = instPropCsr + 1;
-					uint8_t tmp = ctr.readUint8(csr++);
-					instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::FREQ, tmp >> 4);
-					instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::PMS, tmp & 0x0f);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::AMS, tmp & 0x0f);
-					instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::AM1, (tmp & 0x10) ? true : false);
-					instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::AM2, (tmp & 0x20) ? true : false);
-					instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::AM3, (tmp & 0x40) ? true : false);
-					instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::AM4, (tmp & 0x80) ? true : false);
-					tmp = ctr.readUint8(csr++);
-					instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::COUNT, tmp);
-					instPropCsr += ofs;
-					break;
-				}
-				case 0x02:	// FM AL
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::AL, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x03:	// FM FB
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::FB, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x04:	// FM AR1
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::AR1, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x05:	// FM DR1
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::DR1, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x06:	// FM SR1
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::SR1, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x07:	// FM RR1
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::RR1, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x08:	// FM SL1
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::SL1, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x09:	// FM TL1
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::TL1, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x0a:	// FM KS1
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::KS1, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x0b:	// FM ML1
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::ML1, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x0c:	// FM DT1
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::DT1, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x0d:	// FM AR2
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::AR2, instPropCsr, instMan,
-									  ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x0e:	// FM DR2
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::DR2, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x0f:	// FM SR2
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::SR2, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x10:	// FM RR2
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::RR2, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x11:	// FM SL2
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::SL2, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x12:	// FM TL2
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::TL2, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x13:	// FM KS2
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::KS2, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x14:	// FM ML2
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::ML2, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x15:	// FM DT2
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::DT2, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x16:	// FM AR3
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::AR3, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x17:	// FM DR3
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::DR3, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x18:	// FM SR3
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::SR3, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x19:	// FM RR3
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::RR3, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x1a:	// FM SL3
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::SL3, instPropCsr, instMan, ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x1b:	// FM TL3
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::TL3, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x1c:	// FM KS3
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::KS3, instPropCsr, instMan, ctr, dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x1d:	// FM ML3
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::ML3, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x1e:	// FM DT3
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::DT3, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x1f:	// FM AR4
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::AR4, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x20:	// FM DR4
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::DR4, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x21:	// FM SR4
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::SR4, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x22:	// FM RR4
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::RR4, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x23:	// FM SL4
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::SL4, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x24:	// FM TL4
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::TL4, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x25:	// FM KS4
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::KS4, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x26:	// FM ML4
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::ML4, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x27:	// FM DT4
-				{
-					instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
-									  FMEnvelopeParameter::DT4, instPropCsr, instMan, ctr,
-									  dynamic_cast<InstrumentFM*>(inst), *numIt++);
-					break;
-				}
-				case 0x28:	// FM arpeggio
-				{
-					int idx = *numIt++;
-					auto fm = dynamic_cast<InstrumentFM*>(inst);
-					fm->setArpeggioEnabled(true);
-					fm->setArpeggioNumber(idx);
-					uint16_t ofs = ctr.readUint16(instPropCsr);
-					size_t csr = instPropCsr + 2;
-
-					uint16_t seqLen = ctr.readUint16(csr);
-					csr += 2;
-					for (uint16_t l = 0; l < seqLen; ++l) {
-						uint16_t data = ctr.readUint16(csr);
-						csr += 2;
-						int16_t subdata = ctr.readInt16(csr);
-						csr += 2;
-						if (l == 0)
-							instMan.lock()->setArpeggioFMSequenceCommand(idx, 0, data, subdata);
-						else
-							instMan.lock()->addArpeggioFMSequenceCommand(idx, data, subdata);
+			std::unique_ptr<AbstractInstrument> inst;
+			switch (ctr.readUint8(instCsr++)) {
+			case 0x00:	// FM
+			{
+				inst.reset(new InstrumentFM(instNum, name, instMan.lock().get()));
+				dynamic_cast<InstrumentFM*>(inst.get())->setEnvelopeResetEnabled(
+							ctr.readUint8(instCsr++) ? true : false);
+				break;
+			}
+			case 0x01:	// SSG
+			{
+				inst.reset(new InstrumentSSG(instNum, name, instMan.lock().get()));
+				break;
+			}
+			default:	// Unknown sound source
+				return nullptr;
+			}
+			globCsr += instOfs;
+
+
+			/***** Instrument property section *****/
+			if (!ctr.matchString(globCsr, "INSTPROP")) return nullptr;
+			else {
+				globCsr += 8;
+				size_t instPropOfs = ctr.readUint32(globCsr);
+				size_t instPropCsr = globCsr + 4;
+				size_t instPropCsrTmp = instPropCsr;
+				globCsr += instPropOfs;
+				std::vector<int> nums;
+				// Check memory range
+				bool isFM = (inst->getSoundSource() == SoundSource::FM);
+				while (instPropCsr < globCsr) {
+					// Properties of the other sound source are broken
+					if ((ctr.readUint8(instPropCsr) < 0x30) != isFM) return nullptr;
+					switch (ctr.readUint8(instPropCsr++)) {
+					case 0x00:	// FM envelope
+					{
+						nums.push_back(instMan.lock()->findFirstFreeEnvelopeFM());
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint8(instPropCsr);
+						break;
 					}
-
-					uint16_t loopCnt = ctr.readUint16(csr);
-					csr += 2;
-					if (loopCnt > 0) {
-						std::vector<int> begins, ends, times;
-						for (uint16_t l = 0; l < loopCnt; ++l) {
-							begins.push_back(ctr.readUint16(csr));
-							csr += 2;
-							ends.push_back(ctr.readUint16(csr));
-							csr += 2;
-							times.push_back(ctr.readUint8(csr++));
-						}
-						instMan.lock()->setArpeggioFMLoops(idx, begins, ends, times);
+					case 0x01:	// FM LFO
+					{
+						nums.push_back(instMan.lock()->findFirstFreeLFOFM());
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint8(instPropCsr);
+						break;
 					}
-
-					switch (ctr.readUint8(csr++)) {
-					case 0x00:	// No release
-						instMan.lock()->setArpeggioFMRelease(
-									idx, ReleaseType::NO_RELEASE, -1);
+					case 0x02:	// FM AL
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::AL));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x01:	// Fix
-						instMan.lock()->setArpeggioFMRelease(
-									idx, ReleaseType::FIX, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x03:	// FM FB
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::FB));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x02:	// Absolute
-						instMan.lock()->setArpeggioFMRelease(
-									idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x04:	// FM AR1
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::AR1));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x03:	// Relative
-						instMan.lock()->setArpeggioFMRelease(
-									idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x05:	// FM DR1
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DR1));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
 					}
-
-					instPropCsr += ofs;
-					break;
-				}
-				case 0x29:	// FM pitch
-				{
-					int idx = *numIt++;
-					auto fm = dynamic_cast<InstrumentFM*>(inst);
-					fm->setPitchEnabled(true);
-					fm->setPitchNumber(idx);
-					uint16_t ofs = ctr.readUint16(instPropCsr);
-					size_t csr = instPropCsr + 2;
-
-					uint16_t seqLen = ctr.readUint16(csr);
-					csr += 2;
-					for (uint16_t l = 0; l < seqLen; ++l) {
-						uint16_t data = ctr.readUint16(csr);
-						csr += 2;
-						int16_t subdata = ctr.readInt16(csr);
-						csr += 2;
-						if (l == 0)
-							instMan.lock()->setPitchFMSequenceCommand(idx, 0, data, subdata);
-						else
-							instMan.lock()->addPitchFMSequenceCommand(idx, data, subdata);
+					case 0x06:	// FM SR1
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SR1));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
 					}
-
-					uint16_t loopCnt = ctr.readUint16(csr);
-					csr += 2;
-					if (loopCnt > 0) {
-						std::vector<int> begins, ends, times;
-						for (uint16_t l = 0; l < loopCnt; ++l) {
-							begins.push_back(ctr.readUint16(csr));
-							csr += 2;
-							ends.push_back(ctr.readUint16(csr));
-							csr += 2;
-							times.push_back(ctr.readUint8(csr++));
-						}
-						instMan.lock()->setPitchFMLoops(idx, begins, ends, times);
+					case 0x07:	// FM RR1
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::RR1));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
 					}
-
-					switch (ctr.readUint8(csr++)) {
-					case 0x00:	// No release
-						instMan.lock()->setPitchFMRelease(
-									idx, ReleaseType::NO_RELEASE, -1);
+					case 0x08:	// FM SL1
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SL1));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x01:	// Fix
-						instMan.lock()->setPitchFMRelease(
-									idx, ReleaseType::FIX, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x09:	// FM TL1
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::TL1));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x02:	// Absolute
-						instMan.lock()->setPitchFMRelease(
-									idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x0a:	// FM KS1
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::KS1));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x03:	// Relative
-						instMan.lock()->setPitchFMRelease(
-									idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x0b:	// FM ML1
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::ML1));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
 					}
-
-					instPropCsr += ofs;
-					break;
-				}
-				case 0x30:	// SSG wave form
-				{
-					int idx = *numIt++;
-					auto ssg = dynamic_cast<InstrumentSSG*>(inst);
-					ssg->setWaveFormEnabled(true);
-					ssg->setWaveFormNumber(idx);
-					uint16_t ofs = ctr.readUint16(instPropCsr);
-					size_t csr = instPropCsr + 2;
-
-					uint16_t seqLen = ctr.readUint16(csr);
-					csr += 2;
-					for (uint16_t l = 0; l < seqLen; ++l) {
-						uint16_t data = ctr.readUint16(csr);
-						csr += 2;
-						int16_t subdata = ctr.readInt16(csr);
-						csr += 2;
-						if (l == 0)
-							instMan.lock()->setWaveFormSSGSequenceCommand(idx, 0, data, subdata);
-						else
-							instMan.lock()->addWaveFormSSGSequenceCommand(idx, data, subdata);
+					case 0x0c:	// FM DT1
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DT1));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
 					}
-
-					uint16_t loopCnt = ctr.readUint16(csr);
-					csr += 2;
-					if (loopCnt > 0) {
-						std::vector<int> begins, ends, times;
-						for (uint16_t l = 0; l < loopCnt; ++l) {
-							begins.push_back(ctr.readUint16(csr));
-							csr += 2;
-							ends.push_back(ctr.readUint16(csr));
-							csr += 2;
-							times.push_back(ctr.readUint8(csr++));
-						}
-						instMan.lock()->setWaveFormSSGLoops(idx, begins, ends, times);
+					case 0x0d:	// FM AR2
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::AR2));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
 					}
-
-					switch (ctr.readUint8(csr++)) {
-					case 0x00:	// No release
-						instMan.lock()->setWaveFormSSGRelease(
-									idx, ReleaseType::NO_RELEASE, -1);
+					case 0x0e:	// FM DR2
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DR2));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x01:	// Fix
-						instMan.lock()->setWaveFormSSGRelease(
-									idx, ReleaseType::FIX, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x0f:	// FM SR2
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SR2));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x02:	// Absolute
-						instMan.lock()->setWaveFormSSGRelease(
-									idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x10:	// FM RR2
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::RR2));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x03:	// Relative
-						instMan.lock()->setWaveFormSSGRelease(
-									idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x11:	// FM SL2
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SL2));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
 					}
-
-					instPropCsr += ofs;
-					break;
-				}
-				case 0x31:	// SSG tone/noise
-				{
-					int idx = *numIt++;
-					auto ssg = dynamic_cast<InstrumentSSG*>(inst);
-					ssg->setToneNoiseEnabled(true);
-					ssg->setToneNoiseNumber(idx);
-					uint16_t ofs = ctr.readUint16(instPropCsr);
-					size_t csr = instPropCsr + 2;
-
-					uint16_t seqLen = ctr.readUint16(csr);
-					csr += 2;
-					for (uint16_t l = 0; l < seqLen; ++l) {
-						uint16_t data = ctr.readUint16(csr);
-						csr += 2;
-						int16_t subdata = ctr.readInt16(csr);
-						csr += 2;
-						if (l == 0)
-							instMan.lock()->setToneNoiseSSGSequenceCommand(idx, 0, data, subdata);
-						else
-							instMan.lock()->addToneNoiseSSGSequenceCommand(idx, data, subdata);
+					case 0x12:	// FM TL2
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::TL2));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
 					}
-
-					uint16_t loopCnt = ctr.readUint16(csr);
-					csr += 2;
-					if (loopCnt > 0) {
-						std::vector<int> begins, ends, times;
-						for (uint16_t l = 0; l < loopCnt; ++l) {
-							begins.push_back(ctr.readUint16(csr));
-							csr += 2;
-							ends.push_back(ctr.readUint16(csr));
-							csr += 2;
-							times.push_back(ctr.readUint8(csr++));
-						}
-						instMan.lock()->setToneNoiseSSGLoops(idx, begins, ends, times);
+					case 0x13:	// FM KS2
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::KS2));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
 					}
-
-					switch (ctr.readUint8(csr++)) {
-					case 0x00:	// No release
-						instMan.lock()->setToneNoiseSSGRelease(
-									idx, ReleaseType::NO_RELEASE, -1);
+					case 0x14:	// FM ML2
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::ML2));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x01:	// Fix
-						instMan.lock()->setToneNoiseSSGRelease(
-									idx, ReleaseType::FIX, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x15:	// FM DT2
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DT2));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x02:	// Absolute
-						instMan.lock()->setToneNoiseSSGRelease(
-									idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x16:	// FM AR3
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::AR3));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
-					case 0x03:	// Relative
-						instMan.lock()->setToneNoiseSSGRelease(
-									idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
-						csr += 2;
+					}
+					case 0x17:	// FM DR3
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DR3));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
 						break;
 					}
-
-					instPropCsr += ofs;
-					break;
+					case 0x18:	// FM SR3
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SR3));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x19:	// FM RR3
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::RR3));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x1a:	// FM SL3
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SL3));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x1b:	// FM TL3
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::TL3));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x1c:	// FM KS3
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::KS3));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x1d:	// FM ML3
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::ML3));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x1e:	// FM DT3
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DT3));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x1f:	// FM AR4
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::AR4));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x20:	// FM DR4
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DR4));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x21:	// FM SR4
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SR4));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x22:	// FM RR4
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::RR4));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x23:	// FM SL4
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::SL4));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x24:	// FM TL4
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::TL4));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x25:	// FM KS4
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::KS4));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x26:	// FM ML4
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::ML4));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x27:	// FM DT4
+					{
+						nums.push_back(instMan.lock()->findFirstFreeOperatorSequenceFM(FMEnvelopeParameter::DT4));
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x28:	// FM arpeggio
+					{
+						nums.push_back(instMan.lock()->findFirstFreeArpeggioFM());
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x29:	// FM pitch
+					{
+						nums.push_back(instMan.lock()->findFirstFreePitchFM());
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x30:	// SSG wave form
+					{
+						nums.push_back(instMan.lock()->findFirstFreeWaveFormSSG());
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x31:	// SSG tone/noise
+					{
+						nums.push_back(instMan.lock()->findFirstFreeToneNoiseSSG());
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x32:	// SSG envelope
+					{
+						nums.push_back(instMan.lock()->findFirstFreeEnvelopeSSG());
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x33:	// SSG arpeggio
+					{
+						nums.push_back(instMan.lock()->findFirstFreeArpeggioSSG());
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					case 0x34:	// SSG pitch
+					{
+						nums.push_back(instMan.lock()->findFirstFreePitchSSG());
+						if (nums.back() == -1) return nullptr;
+						instPropCsr += ctr.readUint16(instPropCsr);
+						break;
+					}
+					}
 				}
-				case 0x32:	// SSG envelope
-				{
-					int idx = *numIt++;
-					auto ssg = dynamic_cast<InstrumentSSG*>(inst);
-					ssg->setEnvelopeEnabled(true);
-					ssg->setEnvelopeNumber(idx);
-					uint16_t ofs = ctr.readUint16(instPropCsr);
-					size_t csr = instPropCsr + 2;
-
-					uint16_t seqLen = ctr.readUint16(csr);
-					csr += 2;
-					for (uint16_t l = 0; l < seqLen; ++l) {
-						uint16_t data = ctr.readUint16(csr);
+				// Read data
+				instPropCsr = instPropCsrTmp;
+				auto numIt = nums.begin();
+				while (instPropCsr < globCsr) {
+					switch (ctr.readUint8(instPropCsr++)) {
+					case 0x00:	// FM envelope
+					{
+						int idx = *numIt++;
+						dynamic_cast<InstrumentFM*>(inst.get())->setEnvelopeNumber(idx);
+						uint8_t ofs = ctr.readUint8(instPropCsr);
+						size_t csr = instPropCsr + 1;
+						uint8_t tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::AL, tmp >> 4);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::FB, tmp & 0x0f);
+						// Operator 1
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMOperatorEnabled(idx, 0, (0x20 & tmp) ? true : false);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::AR1, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::KS1, tmp >> 5);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DR1, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DT1, tmp >> 5);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SR1, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SL1, tmp >> 4);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::RR1, tmp & 0x0f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::TL1, tmp);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::ML1, tmp & 0x0f);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SSGEG1,
+															   (tmp & 0x80) ? -1 : ((tmp >> 4) & 0x07));
+						// Operator 2
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMOperatorEnabled(idx, 1, (0x20 & tmp) ? true : false);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::AR2, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::KS2, tmp >> 5);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DR2, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DT2, tmp >> 5);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SR2, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SL2, tmp >> 4);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::RR2, tmp & 0x0f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::TL2, tmp);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::ML2, tmp & 0x0f);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SSGEG2,
+															   (tmp & 0x80) ? -1 : ((tmp >> 4) & 0x07));
+						// Operator 3
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMOperatorEnabled(idx, 2, (0x20 & tmp) ? true : false);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::AR3, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::KS3, tmp >> 5);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DR3, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DT3, tmp >> 5);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SR3, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SL3, tmp >> 4);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::RR3, tmp & 0x0f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::TL3, tmp);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::ML3, tmp & 0x0f);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SSGEG3,
+															   (tmp & 0x80) ? -1 : ((tmp >> 4) & 0x07));
+						// Operator 4
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMOperatorEnabled(idx, 3, (0x20 & tmp) ? true : false);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::AR4, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::KS4, tmp >> 5);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DR4, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::DT4, tmp >> 5);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SR4, tmp & 0x1f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SL4, tmp >> 4);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::RR4, tmp & 0x0f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::TL4, tmp);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::ML4, tmp & 0x0f);
+						instMan.lock()->setEnvelopeFMParameter(idx, FMEnvelopeParameter::SSGEG4,
+															   (tmp & 0x80) ? -1 : ((tmp >> 4) & 0x07));
+						instPropCsr += ofs;
+						break;
+					}
+					case 0x01:	// FM LFO
+					{
+						int idx = *numIt++;
+						auto fm = dynamic_cast<InstrumentFM*>(inst.get());
+						fm->setLFOEnabled(true);
+						fm->setLFONumber(idx);
+						uint8_t ofs = ctr.readUint8(instPropCsr);
+						size_t csr = instPropCsr + 1;
+						uint8_t tmp = ctr.readUint8(csr++);
+						instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::FREQ, tmp >> 4);
+						instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::PMS, tmp & 0x0f);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::AMS, tmp & 0x0f);
+						instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::AM1, (tmp & 0x10) ? true : false);
+						instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::AM2, (tmp & 0x20) ? true : false);
+						instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::AM3, (tmp & 0x40) ? true : false);
+						instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::AM4, (tmp & 0x80) ? true : false);
+						tmp = ctr.readUint8(csr++);
+						instMan.lock()->setLFOFMParameter(idx, FMLFOParameter::COUNT, tmp);
+						instPropCsr += ofs;
+						break;
+					}
+					case 0x02:	// FM AL
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::AL, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x03:	// FM FB
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::FB, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x04:	// FM AR1
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::AR1, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x05:	// FM DR1
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::DR1, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x06:	// FM SR1
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::SR1, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x07:	// FM RR1
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::RR1, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x08:	// FM SL1
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::SL1, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x09:	// FM TL1
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::TL1, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x0a:	// FM KS1
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::KS1, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x0b:	// FM ML1
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::ML1, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x0c:	// FM DT1
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::DT1, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x0d:	// FM AR2
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::AR2, instPropCsr, instMan,
+										  ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x0e:	// FM DR2
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::DR2, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x0f:	// FM SR2
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::SR2, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x10:	// FM RR2
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::RR2, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x11:	// FM SL2
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::SL2, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x12:	// FM TL2
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::TL2, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x13:	// FM KS2
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::KS2, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x14:	// FM ML2
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::ML2, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x15:	// FM DT2
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::DT2, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x16:	// FM AR3
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::AR3, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x17:	// FM DR3
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::DR3, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x18:	// FM SR3
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::SR3, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x19:	// FM RR3
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::RR3, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x1a:	// FM SL3
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::SL3, instPropCsr, instMan, ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x1b:	// FM TL3
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::TL3, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x1c:	// FM KS3
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::KS3, instPropCsr, instMan, ctr, dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x1d:	// FM ML3
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::ML3, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x1e:	// FM DT3
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::DT3, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x1f:	// FM AR4
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::AR4, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x20:	// FM DR4
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::DR4, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x21:	// FM SR4
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::SR4, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x22:	// FM RR4
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::RR4, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x23:	// FM SL4
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::SL4, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x24:	// FM TL4
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::TL4, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x25:	// FM KS4
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::KS4, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x26:	// FM ML4
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::ML4, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x27:	// FM DT4
+					{
+						instPropCsr += loadInstrumentPropertyOperatorSequenceForInstrument(
+										  FMEnvelopeParameter::DT4, instPropCsr, instMan, ctr,
+										  dynamic_cast<InstrumentFM*>(inst.get()), *numIt++);
+						break;
+					}
+					case 0x28:	// FM arpeggio
+					{
+						int idx = *numIt++;
+						auto fm = dynamic_cast<InstrumentFM*>(inst.get());
+						fm->setArpeggioEnabled(true);
+						fm->setArpeggioNumber(idx);
+						uint16_t ofs = ctr.readUint16(instPropCsr);
+						size_t csr = instPropCsr + 2;
+
+						uint16_t seqLen = ctr.readUint16(csr);
 						csr += 2;
-						int16_t subdata = ctr.readInt16(csr);
+						for (uint16_t l = 0; l < seqLen; ++l) {
+							uint16_t data = ctr.readUint16(csr);
+							csr += 2;
+							int16_t subdata = ctr.readInt16(csr);
+							csr += 2;
+							if (l == 0)
+								instMan.lock()->setArpeggioFMSequenceCommand(idx, 0, data, subdata);
+							else
+								instMan.lock()->addArpeggioFMSequenceCommand(idx, data, subdata);
+						}
+
+						uint16_t loopCnt = ctr.readUint16(csr);
 						csr += 2;
-						if (l == 0)
-							instMan.lock()->setEnvelopeSSGSequenceCommand(idx, 0, data, subdata);
-						else
-							instMan.lock()->addEnvelopeSSGSequenceCommand(idx, data, subdata);
-					}
+						if (loopCnt > 0) {
+							std::vector<int> begins, ends, times;
+							for (uint16_t l = 0; l < loopCnt; ++l) {
+								begins.push_back(ctr.readUint16(csr));
+								csr += 2;
+								ends.push_back(ctr.readUint16(csr));
+								csr += 2;
+								times.push_back(ctr.readUint8(csr++));
+							}
+							instMan.lock()->setArpeggioFMLoops(idx, begins, ends, times);
+						}
 
-					uint16_t loopCnt = ctr.readUint16(csr);
-					csr += 2;
-					if (loopCnt > 0) {
-						std::vector<int> begins, ends, times;
-						for (uint16_t l = 0; l < loopCnt; ++l) {
-							begins.push_back(ctr.readUint16(csr));
+						switch (ctr.readUint8(csr++)) {
+						case 0x00:	// No release
+							instMan.lock()->setArpeggioFMRelease(
+										idx, ReleaseType::NO_RELEASE, -1);
+							break;
+						case 0x01:	// Fix
+							instMan.lock()->setArpeggioFMRelease(
+										idx, ReleaseType::FIX, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						case 0x02:	// Absolute
+							instMan.lock()->setArpeggioFMRelease(
+										idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
 							csr += 2;
-							ends.push_back(ctr.readUint16(csr));
+							break;
+						case 0x03:	// Relative
+							instMan.lock()->setArpeggioFMRelease(
+										idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
 							csr += 2;
-							times.push_back(ctr.readUint8(csr++));
+							break;
 						}
-						instMan.lock()->setEnvelopeSSGLoops(idx, begins, ends, times);
-					}
 
-					switch (ctr.readUint8(csr++)) {
-					case 0x00:	// No release
-						instMan.lock()->setEnvelopeSSGRelease(
-									idx, ReleaseType::NO_RELEASE, -1);
+						instPropCsr += ofs;
 						break;
-					case 0x01:	// Fix
-						instMan.lock()->setEnvelopeSSGRelease(
-									idx, ReleaseType::FIX, ctr.readUint16(csr));
-						csr += 2;
-						break;
-					case 0x02:	// Absolute
-						instMan.lock()->setEnvelopeSSGRelease(
-									idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
+					}
+					case 0x29:	// FM pitch
+					{
+						int idx = *numIt++;
+						auto fm = dynamic_cast<InstrumentFM*>(inst.get());
+						fm->setPitchEnabled(true);
+						fm->setPitchNumber(idx);
+						uint16_t ofs = ctr.readUint16(instPropCsr);
+						size_t csr = instPropCsr + 2;
+
+						uint16_t seqLen = ctr.readUint16(csr);
 						csr += 2;
-						break;
-					case 0x03:	// Relative
-						instMan.lock()->setEnvelopeSSGRelease(
-									idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
+						for (uint16_t l = 0; l < seqLen; ++l) {
+							uint16_t data = ctr.readUint16(csr);
+							csr += 2;
+							int16_t subdata = ctr.readInt16(csr);
+							csr += 2;
+							if (l == 0)
+								instMan.lock()->setPitchFMSequenceCommand(idx, 0, data, subdata);
+							else
+								instMan.lock()->addPitchFMSequenceCommand(idx, data, subdata);
+						}
+
+						uint16_t loopCnt = ctr.readUint16(csr);
 						csr += 2;
+						if (loopCnt > 0) {
+							std::vector<int> begins, ends, times;
+							for (uint16_t l = 0; l < loopCnt; ++l) {
+								begins.push_back(ctr.readUint16(csr));
+								csr += 2;
+								ends.push_back(ctr.readUint16(csr));
+								csr += 2;
+								times.push_back(ctr.readUint8(csr++));
+							}
+							instMan.lock()->setPitchFMLoops(idx, begins, ends, times);
+						}
+
+						switch (ctr.readUint8(csr++)) {
+						case 0x00:	// No release
+							instMan.lock()->setPitchFMRelease(
+										idx, ReleaseType::NO_RELEASE, -1);
+							break;
+						case 0x01:	// Fix
+							instMan.lock()->setPitchFMRelease(
+										idx, ReleaseType::FIX, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						case 0x02:	// Absolute
+							instMan.lock()->setPitchFMRelease(
+										idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						case 0x03:	// Relative
+							instMan.lock()->setPitchFMRelease(
+										idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						}
+
+						instPropCsr += ofs;
 						break;
 					}
-
-					instPropCsr += ofs;
-					break;
-				}
-				case 0x33:	// SSG arpeggio
-				{
-					int idx = *numIt++;
-					auto ssg = dynamic_cast<InstrumentSSG*>(inst);
-					ssg->setArpeggioEnabled(true);
-					ssg->setArpeggioNumber(idx);
-					uint16_t ofs = ctr.readUint16(instPropCsr);
-					size_t csr = instPropCsr + 2;
-
-					uint16_t seqLen = ctr.readUint16(csr);
-					csr += 2;
-					for (uint16_t l = 0; l < seqLen; ++l) {
-						uint16_t data = ctr.readUint16(csr);
+					case 0x30:	// SSG wave form
+					{
+						int idx = *numIt++;
+						auto ssg = dynamic_cast<InstrumentSSG*>(inst.get());
+						ssg->setWaveFormEnabled(true);
+						ssg->setWaveFormNumber(idx);
+						uint16_t ofs = ctr.readUint16(instPropCsr);
+						size_t csr = instPropCsr + 2;
+
+						uint16_t seqLen = ctr.readUint16(csr);
 						csr += 2;
-						int16_t subdata = ctr.readInt16(csr);
+						for (uint16_t l = 0; l < seqLen; ++l) {
+							uint16_t data = ctr.readUint16(csr);
+							csr += 2;
+							int16_t subdata = ctr.readInt16(csr);
+							csr += 2;
+							if (l == 0)
+								instMan.lock()->setWaveFormSSGSequenceCommand(idx, 0, data, subdata);
+							else
+								instMan.lock()->addWaveFormSSGSequenceCommand(idx, data, subdata);
+						}
+
+						uint16_t loopCnt = ctr.readUint16(csr);
 						csr += 2;
-						if (l == 0)
-							instMan.lock()->setArpeggioSSGSequenceCommand(idx, 0, data, subdata);
-						else
-							instMan.lock()->addArpeggioSSGSequenceCommand(idx, data, subdata);
-					}
+						if (loopCnt > 0) {
+							std::vector<int> begins, ends, times;
+							for (uint16_t l = 0; l < loopCnt; ++l) {
+								begins.push_back(ctr.readUint16(csr));
+								csr += 2;
+								ends.push_back(ctr.readUint16(csr));
+								csr += 2;
+								times.push_back(ctr.readUint8(csr++));
+							}
+							instMan.lock()->setWaveFormSSGLoops(idx, begins, ends, times);
+						}
 
-					uint16_t loopCnt = ctr.readUint16(csr);
-					csr += 2;
-					if (loopCnt > 0) {
-						std::vector<int> begins, ends, times;
-						for (uint16_t l = 0; l < loopCnt; ++l) {
-							begins.push_back(ctr.readUint16(csr));
+						switch (ctr.readUint8(csr++)) {
+						case 0x00:	// No release
+							instMan.lock()->setWaveFormSSGRelease(
+										idx, ReleaseType::NO_RELEASE, -1);
+							break;
+						case 0x01:	// Fix
+							instMan.lock()->setWaveFormSSGRelease(
+										idx, ReleaseType::FIX, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						case 0x02:	// Absolute
+							instMan.lock()->setWaveFormSSGRelease(
+										idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
 							csr += 2;
-							ends.push_back(ctr.readUint16(csr));
+							break;
+						case 0x03:	// Relative
+							instMan.lock()->setWaveFormSSGRelease(
+										idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
 							csr += 2;
-							times.push_back(ctr.readUint8(csr++));
+							break;
 						}
-						instMan.lock()->setArpeggioSSGLoops(idx, begins, ends, times);
-					}
 
-					switch (ctr.readUint8(csr++)) {
-					case 0x00:	// No release
-						instMan.lock()->setArpeggioSSGRelease(
-									idx, ReleaseType::NO_RELEASE, -1);
-						break;
-					case 0x01:	// Fix
-						instMan.lock()->setArpeggioSSGRelease(
-									idx, ReleaseType::FIX, ctr.readUint16(csr));
-						csr += 2;
+						instPropCsr += ofs;
 						break;
-					case 0x02:	// Absolute
-						instMan.lock()->setArpeggioSSGRelease(
-									idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
+					}
+					case 0x31:	// SSG tone/noise
+					{
+						int idx = *numIt++;
+						auto ssg = dynamic_cast<InstrumentSSG*>(inst.get());
+						ssg->setToneNoiseEnabled(true);
+						ssg->setToneNoiseNumber(idx);
+						uint16_t ofs = ctr.readUint16(instPropCsr);
+						size_t csr = instPropCsr + 2;
+
+						uint16_t seqLen = ctr.readUint16(csr);
 						csr += 2;
-						break;
-					case 0x03:	// Relative
-						instMan.lock()->setArpeggioSSGRelease(
-									idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
+						for (uint16_t l = 0; l < seqLen; ++l) {
+							uint16_t data = ctr.readUint16(csr);
+							csr += 2;
+							int16_t subdata = ctr.readInt16(csr);
+							csr += 2;
+							if (l == 0)
+								instMan.lock()->setToneNoiseSSGSequenceCommand(idx, 0, data, subdata);
+							else
+								instMan.lock()->addToneNoiseSSGSequenceCommand(idx, data, subdata);
+						}
+
+						uint16_t loopCnt = ctr.readUint16(csr);
 						csr += 2;
+						if (loopCnt > 0) {
+							std::vector<int> begins, ends, times;
+							for (uint16_t l = 0; l < loopCnt; ++l) {
+								begins.push_back(ctr.readUint16(csr));
+								csr += 2;
+								ends.push_back(ctr.readUint16(csr));
+								csr += 2;
+								times.push_back(ctr.readUint8(csr++));
+							}
+							instMan.lock()->setToneNoiseSSGLoops(idx, begins, ends, times);
+						}
+
+						switch (ctr.readUint8(csr++)) {
+						case 0x00:	// No release
+							instMan.lock()->setToneNoiseSSGRelease(
+										idx, ReleaseType::NO_RELEASE, -1);
+							break;
+						case 0x01:	// Fix
+							instMan.lock()->setToneNoiseSSGRelease(
+										idx, ReleaseType::FIX, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						case 0x02:	// Absolute
+							instMan.lock()->setToneNoiseSSGRelease(
+										idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						case 0x03:	// Relative
+							instMan.lock()->setToneNoiseSSGRelease(
+										idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						}
+
+						instPropCsr += ofs;
 						break;
 					}
-
-					instPropCsr += ofs;
-					break;
-				}
-				case 0x34:	// SSG pitch
-				{
-					int idx = *numIt++;
-					auto ssg = dynamic_cast<InstrumentSSG*>(inst);
-					ssg->setPitchEnabled(true);
-					ssg->setPitchNumber(idx);
-					uint16_t ofs = ctr.readUint16(instPropCsr);
-					size_t csr = instPropCsr + 2;
-
-					uint16_t seqLen = ctr.readUint16(csr);
-					csr += 2;
-					for (uint16_t l = 0; l < seqLen; ++l) {
-						uint16_t data = ctr.readUint16(csr);
+					case 0x32:	// SSG envelope
+					{
+						int idx = *numIt++;
+						auto ssg = dynamic_cast<InstrumentSSG*>(inst.get());
+						ssg->setEnvelopeEnabled(true);
+						ssg->setEnvelopeNumber(idx);
+						uint16_t ofs = ctr.readUint16(instPropCsr);
+						size_t csr = instPropCsr + 2;
+
+						uint16_t seqLen = ctr.readUint16(csr);
 						csr += 2;
-						int16_t subdata = ctr.readInt16(csr);
+						for (uint16_t l = 0; l < seqLen; ++l) {
+							uint16_t data = ctr.readUint16(csr);
+							csr += 2;
+							int16_t subdata = ctr.readInt16(csr);
+							csr += 2;
+							if (l == 0)
+								instMan.lock()->setEnvelopeSSGSequenceCommand(idx, 0, data, subdata);
+							else
+								instMan.lock()->addEnvelopeSSGSequenceCommand(idx, data, subdata);
+						}
+
+						uint16_t loopCnt = ctr.readUint16(csr);
 						csr += 2;
-						if (l == 0)
-							instMan.lock()->setPitchSSGSequenceCommand(idx, 0, data, subdata);
-						else
-							instMan.lock()->addPitchSSGSequenceCommand(idx, data, subdata);
-					}
+						if (loopCnt > 0) {
+							std::vector<int> begins, ends, times;
+							for (uint16_t l = 0; l < loopCnt; ++l) {
+								begins.push_back(ctr.readUint16(csr));
+								csr += 2;
+								ends.push_back(ctr.readUint16(csr));
+								csr += 2;
+								times.push_back(ctr.readUint8(csr++));
+							}
+							instMan.lock()->setEnvelopeSSGLoops(idx, begins, ends, times);
+						}
 
-					uint16_t loopCnt = ctr.readUint16(csr);
-					csr += 2;
-					if (loopCnt > 0) {
-						std::vector<int> begins, ends, times;
-						for (uint16_t l = 0; l < loopCnt; ++l) {
-							begins.push_back(ctr.readUint16(csr));
+						switch (ctr.readUint8(csr++)) {
+						case 0x00:	// No release
+							instMan.lock()->setEnvelopeSSGRelease(
+										idx, ReleaseType::NO_RELEASE, -1);
+							break;
+						case 0x01:	// Fix
+							instMan.lock()->setEnvelopeSSGRelease(
+										idx, ReleaseType::FIX, ctr.readUint16(csr));
 							csr += 2;
-							ends.push_back(ctr.readUint16(csr));
+							break;
+						case 0x02:	// Absolute
+							instMan.lock()->setEnvelopeSSGRelease(
+										idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
 							csr += 2;
-							times.push_back(ctr.readUint8(csr++));
+							break;
+						case 0x03:	// Relative
+							instMan.lock()->setEnvelopeSSGRelease(
+										idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
+							csr += 2;
+							break;
 						}
-						instMan.lock()->setPitchSSGLoops(idx, begins, ends, times);
-					}
 
-					switch (ctr.readUint8(csr++)) {
-					case 0x00:	// No release
-						instMan.lock()->setPitchSSGRelease(
-									idx, ReleaseType::NO_RELEASE, -1);
+						instPropCsr += ofs;
 						break;
-					case 0x01:	// Fix
-						instMan.lock()->setPitchSSGRelease(
-									idx, ReleaseType::FIX, ctr.readUint16(csr));
+					}
+					case 0x33:	// SSG arpeggio
+					{
+						int idx = *numIt++;
+						auto ssg = dynamic_cast<InstrumentSSG*>(inst.get());
+						ssg->setArpeggioEnabled(true);
+						ssg->setArpeggioNumber(idx);
+						uint16_t ofs = ctr.readUint16(instPropCsr);
+						size_t csr = instPropCsr + 2;
+
+						uint16_t seqLen = ctr.readUint16(csr);
 						csr += 2;
-						break;
-					case 0x02:	// Absolute
-						instMan.lock()->setPitchSSGRelease(
-									idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
+						for (uint16_t l = 0; l < seqLen; ++l) {
+							uint16_t data = ctr.readUint16(csr);
+							csr += 2;
+							int16_t subdata = ctr.readInt16(csr);
+							csr += 2;
+							if (l == 0)
+								instMan.lock()->setArpeggioSSGSequenceCommand(idx, 0, data, subdata);
+							else
+								instMan.lock()->addArpeggioSSGSequenceCommand(idx, data, subdata);
+						}
+
+						uint16_t loopCnt = ctr.readUint16(csr);
 						csr += 2;
+						if (loopCnt > 0) {
+							std::vector<int> begins, ends, times;
+							for (uint16_t l = 0; l < loopCnt; ++l) {
+								begins.push_back(ctr.readUint16(csr));
+								csr += 2;
+								ends.push_back(ctr.readUint16(csr));
+								csr += 2;
+								times.push_back(ctr.readUint8(csr++));
+							}
+							instMan.lock()->setArpeggioSSGLoops(idx, begins, ends, times);
+						}
+
+						switch (ctr.readUint8(csr++)) {
+						case 0x00:	// No release
+							instMan.lock()->setArpeggioSSGRelease(
+										idx, ReleaseType::NO_RELEASE, -1);
+							break;
+						case 0x01:	// Fix
+							instMan.lock()->setArpeggioSSGRelease(
+										idx, ReleaseType::FIX, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						case 0x02:	// Absolute
+							instMan.lock()->setArpeggioSSGRelease(
+										idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						case 0x03:	// Relative
+							instMan.lock()->setArpeggioSSGRelease(
+										idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						}
+
+						instPropCsr += ofs;
 						break;
-					case 0x03:	// Relative
-						instMan.lock()->setPitchSSGRelease(
-									idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
+					}
+					case 0x34:	// SSG pitch
+					{
+						int idx = *numIt++;
+						auto ssg = dynamic_cast<InstrumentSSG*>(inst.get());
+						ssg->setPitchEnabled(true);
+						ssg->setPitchNumber(idx);
+						uint16_t ofs = ctr.readUint16(instPropCsr);
+						size_t csr = instPropCsr + 2;
+
+						uint16_t seqLen = ctr.readUint16(csr);
+						csr += 2;
+						for (uint16_t l = 0; l < seqLen; ++l) {
+							uint16_t data = ctr.readUint16(csr);
+							csr += 2;
+							int16_t subdata = ctr.readInt16(csr);
+							csr += 2;
+							if (l == 0)
+								instMan.lock()->setPitchSSGSequenceCommand(idx, 0, data, subdata);
+							else
+								instMan.lock()->addPitchSSGSequenceCommand(idx, data, subdata);
+						}
+
+						uint16_t loopCnt = ctr.readUint16(csr);
 						csr += 2;
+						if (loopCnt > 0) {
+							std::vector<int> begins, ends, times;
+							for (uint16_t l = 0; l < loopCnt; ++l) {
+								begins.push_back(ctr.readUint16(csr));
+								csr += 2;
+								ends.push_back(ctr.readUint16(csr));
+								csr += 2;
+								times.push_back(ctr.readUint8(csr++));
+							}
+							instMan.lock()->setPitchSSGLoops(idx, begins, ends, times);
+						}
+
+						switch (ctr.readUint8(csr++)) {
+						case 0x00:	// No release
+							instMan.lock()->setPitchSSGRelease(
+										idx, ReleaseType::NO_RELEASE, -1);
+							break;
+						case 0x01:	// Fix
+							instMan.lock()->setPitchSSGRelease(
+										idx, ReleaseType::FIX, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						case 0x02:	// Absolute
+							instMan.lock()->setPitchSSGRelease(
+										idx, ReleaseType::ABSOLUTE, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						case 0x03:	// Relative
+							instMan.lock()->setPitchSSGRelease(
+										idx, ReleaseType::RELATIVE, ctr.readUint16(csr));
+							csr += 2;
+							break;
+						}
+
+						instPropCsr += ofs;
 						break;
 					}
-
-					instPropCsr += ofs;
-					break;
-				}
+					}
 				}
 			}
-		}
 
 
-		return inst;
+			return inst.release();
+		}
+	}
+	catch (std::out_of_range&) {	// Broken file
+		return nullptr;
 	}
 }
 
 size_t FileIO::loadInstrumentPropertyOperatorSequenceForInstrument(FMEnvelopeParameter param,
 																 size_t instMemCsr,
 																 std::weak_ptr<InstrumentsManager> instMan,
-																 BinaryContainer& ctr,
+																 const BinaryReader& ctr,
 																 InstrumentFM* inst,
 																 int idx)
 {
@@ -3681,38 +3937,87 @@ size_t FileIO::loadInstrumentPropertyOperatorSequenceForInstrument(FMEnvelopePar
 	return ofs;
 }
 
-bool FileIO::writeWave(std::string path, std::vector<int16_t> samples, uint32_t sampRate)
+bool FileIO::writeWave(std::string path, std::vector<float> samples, uint32_t sampRate, WaveSampleFormat format)
 {
 	try {
+		// Convert samples to sink format
+		uint16_t fmtId = 1, bitSize = 16;
+		std::vector<char> data;
+		switch (format) {
+		case WaveSampleFormat::INT16:
+		{
+			fmtId = 1;	// PCM
+			bitSize = 16;
+			data.resize(samples.size() * 2);
+			int16_t* p = reinterpret_cast<int16_t*>(data.data());
+			for (const float& s : samples) {
+				*p++ = static_cast<int16_t>(std::min(std::max(s * 32768.0f, -32768.0f), 32767.0f));
+			}
+			break;
+		}
+		case WaveSampleFormat::INT24:
+		{
+			fmtId = 1;	// PCM
+			bitSize = 24;
+			data.resize(samples.size() * 3);
+			char* p = data.data();
+			for (const float& s : samples) {
+				int32_t v = static_cast<int32_t>(std::min(std::max(s * 8388608.0f, -8388608.0f), 8388607.0f));
+				*p++ = static_cast<char>(v & 0xff);
+				*p++ = static_cast<char>((v >> 8) & 0xff);
+				*p++ = static_cast<char>((v >> 16) & 0xff);
+			}
+			break;
+		}
+		case WaveSampleFormat::FLOAT32:
+		{
+			fmtId = 3;	// IEEE float
+			bitSize = 32;
+			data.resize(samples.size() * 4);
+			std::copy(samples.begin(), samples.end(), reinterpret_cast<float*>(data.data()));
+			break;
+		}
+		}
+
 		std::ofstream ofs(path, std::ios::binary);
 
 		// RIFF header
 		ofs.write("RIFF", 4);
-		uint32_t offset = samples.size() * sizeof(short) + 36;
+		uint32_t chunkOfs = (fmtId == 1) ? 16 : 18;	// Non-PCM has cbSize
+		uint32_t dataSize = data.size();
+		uint32_t offset = dataSize + chunkOfs + 20 + ((fmtId == 1) ? 0 : 12);
 		ofs.write(reinterpret_cast<char*>(&offset), 4);
 		ofs.write("WAVE", 4);
 
 		// fmt chunk
 		ofs.write("fmt ", 4);
-		uint32_t chunkOfs = 16;
 		ofs.write(reinterpret_cast<char*>(&chunkOfs), 4);
-		uint16_t fmtId = 1;
 		ofs.write(reinterpret_cast<char*>(&fmtId), 2);
 		uint16_t chCnt = 2;
 		ofs.write(reinterpret_cast<char*>(&chCnt), 2);
 		ofs.write(reinterpret_cast<char*>(&sampRate), 4);
-		uint16_t bitSize = sizeof(int16_t) * 8;
 		uint16_t blockSize = bitSize / 8 * chCnt;
 		uint32_t byteRate = blockSize * sampRate;
 		ofs.write(reinterpret_cast<char*>(&byteRate), 4);
 		ofs.write(reinterpret_cast<char*>(&blockSize), 2);
 		ofs.write(reinterpret_cast<char*>(&bitSize), 2);
 
+		if (fmtId != 1) {
+			uint16_t cbSize = 0;
+			ofs.write(reinterpret_cast<char*>(&cbSize), 2);
+
+			// fact chunk
+			ofs.write("fact", 4);
+			uint32_t factSize = 4;
+			ofs.write(reinterpret_cast<char*>(&factSize), 4);
+			uint32_t frameCnt = samples.size() / chCnt;
+			ofs.write(reinterpret_cast<char*>(&frameCnt), 4);
+		}
+
 		// Data chunk
 		ofs.write("data", 4);
-		uint32_t dataSize = samples.size() * bitSize / 8;
 		ofs.write(reinterpret_cast<char*>(&dataSize), 4);
-		ofs.write(reinterpret_cast<char*>(&samples[0]), static_cast<std::streamsize>(dataSize));
+		ofs.write(data.data(), static_cast<std::streamsize>(dataSize));
 
 		return true;
 	}
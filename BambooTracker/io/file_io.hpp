@@ -1,24 +1,42 @@
 #pragma once
 
 #include <memory>
+#include <future>
 #include <string>
 #include <vector>
 #include "module.hpp"
 #include "instruments_manager.hpp"
 #include "binary_container.hpp"
+#include "binary_reader.hpp"
+#include "mapped_file.hpp"
+#include "atomic_file_writer.hpp"
+#include "module_save_cache.hpp"
 #include "gd3_tag.hpp"
+#include "wave_sample_format.hpp"
 
 class FileIO
 {
 public:
+	/// Steps of patterns are reused from the cache if they are not edited after the last save.
+	///		compressionLevel: 0 (uncompressed), 1 (fastest) - 9 (smallest)
 	static bool saveModule(std::string path, std::weak_ptr<Module> mod,
-						   std::weak_ptr<InstrumentsManager> instMan);
+						   std::weak_ptr<InstrumentsManager> instMan, ModuleSaveCache* cache = nullptr,
+						   int compressionLevel = 0);
+	/// Songs are serialized on a worker thread from a snapshot of the module,
+	/// and the file is replaced atomically. The module path is not changed
+	static std::future<bool> saveModuleInBackground(std::string path, std::weak_ptr<Module> mod,
+													std::weak_ptr<InstrumentsManager> instMan);
 	static bool loadModuel(std::string path, std::weak_ptr<Module> mod,
 						   std::weak_ptr<InstrumentsManager> instMan);
 	static bool saveInstrument(std::string path, std::weak_ptr<InstrumentsManager> instMan, int instNum);
 	static AbstractInstrument* loadInstrument(std::string path, std::weak_ptr<InstrumentsManager> instMan,
 											  int instNum);
-	static bool writeWave(std::string path, std::vector<int16_t> samples, uint32_t rate);
+	/// Append the instrument in the instrument file format
+	static void appendInstrument(BinaryContainer& ctr, std::weak_ptr<InstrumentsManager> instMan, int instNum);
+	/// Load the instrument from data in the instrument file format. Return nullptr if the data is broken
+	static AbstractInstrument* loadInstrument(const BinaryReader& ctr, std::weak_ptr<InstrumentsManager> instMan,
+											  int instNum);
+	static bool writeWave(std::string path, std::vector<float> samples, uint32_t rate, WaveSampleFormat format);
 
 	static bool writeVgm(std::string path, std::vector<uint8_t> samples, uint32_t clock, uint32_t rate,
 						 bool loopFlag, uint32_t loopPoint, uint32_t loopSamples, uint32_t totalSamples,
@@ -31,19 +49,43 @@ private:
 
 	static const FMEnvelopeParameter ENV_FM_PARAMS[38];
 
-	static size_t loadModuleSectionInModule(std::weak_ptr<Module> mod, BinaryContainer& ctr, size_t globCsr);
+	/// Rough upper bound of the saved module size to reserve the container at once
+	static size_t estimateModuleSize(std::weak_ptr<Module> mod);
+
+	static void appendModuleSectionsBeforeSongs(BinaryContainer& ctr, std::weak_ptr<Module> mod,
+												std::weak_ptr<InstrumentsManager> instMan);
+	/// Tracks of each song are compressed if the level is over 0
+	static void appendSongSection(BinaryContainer& ctr, std::weak_ptr<Module> mod, ModuleSaveCache* cache,
+								  int compressionLevel);
+	static void appendStepsInPattern(BinaryContainer& ctr, const Pattern& pattern, std::vector<int>& stepIdcs);
+
+	/// Compressed block: raw size (4 bytes), data size (4 bytes), Adler-32 of data (4 bytes), data
+	static void appendCompressedBlock(BinaryContainer& ctr, const BinaryContainer& src, int level);
+	/// Check the checksum without decompressing the block. Return the cursor after the block
+	static size_t checkCompressedBlock(const BinaryReader& ctr, size_t csr);
+	/// Return the cursor after the block
+	static size_t readCompressedBlock(const BinaryReader& ctr, size_t csr, std::vector<char>& raw);
+
+	static bool loadSectionsInModule(std::weak_ptr<Module> mod, std::weak_ptr<InstrumentsManager> instMan,
+									 const BinaryReader& ctr, size_t globCsr, size_t eof, bool isCompressedTracks);
+	static size_t loadModuleSectionInModule(std::weak_ptr<Module> mod, const BinaryReader& ctr, size_t globCsr);
 	static size_t loadInstrumentSectionInModule(std::weak_ptr<InstrumentsManager> instMan,
-												BinaryContainer& ctr, size_t globCsr);
+												const BinaryReader& ctr, size_t globCsr);
 	static size_t loadInstrumentPropertySectionInModule(std::weak_ptr<InstrumentsManager> instMan,
-														BinaryContainer& ctr, size_t globCsr);
+														const BinaryReader& ctr, size_t globCsr);
 	static size_t loadInstrumentPropertyOperatorSequence(FMEnvelopeParameter param,
 														 size_t instMemCsr,
 														 std::weak_ptr<InstrumentsManager> instMan,
-														 BinaryContainer& ctr);
-	static size_t loadGrooveSectionInModule(std::weak_ptr<Module> mod, BinaryContainer& ctr, size_t globCsr);
-	static size_t loadSongSectionInModule(std::weak_ptr<Module> mod, BinaryContainer& ctr, size_t globCsr);
+														 const BinaryReader& ctr);
+	static size_t loadGrooveSectionInModule(std::weak_ptr<Module> mod, const BinaryReader& ctr, size_t globCsr);
+	static size_t loadSongSectionInModule(std::weak_ptr<Module> mod, const BinaryReader& ctr, size_t globCsr,
+										  bool isCompressedTracks);
+	/// Walk encoded tracks without building them. Throw std::out_of_range if they cannot be loaded
+	static void checkTracksInSong(const BinaryReader& ctr, size_t csr, size_t end,
+								  size_t trackCnt, size_t ptnSize);
+	static void loadTracksInSong(std::vector<Track>& tracks, const BinaryReader& ctr, size_t csr, size_t end);
 
 	static size_t loadInstrumentPropertyOperatorSequenceForInstrument(FMEnvelopeParameter param,
-			size_t instMemCsr, std::weak_ptr<InstrumentsManager> instMan, BinaryContainer& ctr,
+			size_t instMemCsr, std::weak_ptr<InstrumentsManager> instMan, const BinaryReader& ctr,
 																	InstrumentFM* inst, int idx);
 };
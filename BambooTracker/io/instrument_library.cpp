@@ -0,0 +1,498 @@
+#include "instrument_library.hpp"
+#include <cctype>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include "mapped_file.hpp"
+#include "binary_container.hpp"
+#include "atomic_file_writer.hpp"
+#include "envelope_fm.hpp"
+#include "version.hpp"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	const uint32_t INDEX_VERSION = 1;
+
+	struct FileStatus
+	{
+		std::string path;
+		int64_t modifiedTime;
+		uint64_t size;
+	};
+
+	/// FNV-1a 64
+	uint64_t hash(const char* data, size_t size)
+	{
+		uint64_t h = 0xcbf29ce484222325;
+		for (size_t i = 0; i < size; ++i) {
+			h ^= static_cast<unsigned char>(data[i]);
+			h *= 0x100000001b3;
+		}
+		return h;
+	}
+
+	std::string toLower(std::string str)
+	{
+		// Only ASCII letters are folded, other UTF-8 bytes are kept
+		for (auto& c : str) {
+			if (static_cast<unsigned char>(c) < 0x80) c = static_cast<char>(std::tolower(c));
+		}
+		return str;
+	}
+
+	bool isInstrumentFile(const std::string& name)
+	{
+		return (name.size() > 4 && toLower(name.substr(name.size() - 4)) == ".bti");
+	}
+
+#ifdef _WIN32
+	std::wstring toWide(const std::string& str)
+	{
+		// Path is UTF-8
+		int len = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, nullptr, 0);
+		if (len <= 0) return std::wstring();
+		std::wstring wstr(static_cast<size_t>(len), L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, &wstr[0], len);
+		return wstr;
+	}
+
+	std::string toUtf8(const wchar_t* wstr)
+	{
+		int len = WideCharToMultiByte(CP_UTF8, 0, wstr, -1, nullptr, 0, nullptr, nullptr);
+		if (len <= 1) return std::string();
+		std::string str(static_cast<size_t>(len), '\0');
+		WideCharToMultiByte(CP_UTF8, 0, wstr, -1, &str[0], len, nullptr, nullptr);
+		str.pop_back();	// Null character
+		return str;
+	}
+
+	/// Append files in the directory and push its subdirectories
+	void listDirectory(const std::string& dir, std::vector<FileStatus>& files, std::vector<std::string>& subdirs)
+	{
+		WIN32_FIND_DATAW data;
+		HANDLE find = FindFirstFileW(toWide(dir + "\\*").c_str(), &data);
+		if (find == INVALID_HANDLE_VALUE) return;
+		do {
+			std::string name = toUtf8(data.cFileName);
+			if (name.empty() || name == "." || name == "..") continue;
+			std::string path = dir + "\\" + name;
+			if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+				// Links are not followed to avoid cycles
+				if (!(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) subdirs.push_back(path);
+			}
+			else if (isInstrumentFile(name)) {
+				int64_t time = static_cast<int64_t>((static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32)
+													| data.ftLastWriteTime.dwLowDateTime);
+				uint64_t size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+				files.push_back({ path, time, size });
+			}
+		} while (FindNextFileW(find, &data));
+		FindClose(find);
+	}
+#else
+	/// Append files in the directory and push its subdirectories
+	void listDirectory(const std::string& dir, std::vector<FileStatus>& files, std::vector<std::string>& subdirs)
+	{
+		DIR* d = opendir(dir.c_str());
+		if (!d) return;
+		while (dirent* ent = readdir(d)) {
+			std::string name = ent->d_name;
+			if (name == "." || name == "..") continue;
+			std::string path = dir + "/" + name;
+			struct stat st;
+			if (lstat(path.c_str(), &st)) continue;
+			bool isLink = S_ISLNK(st.st_mode);
+			if (isLink && stat(path.c_str(), &st)) continue;	// Broken link
+			if (S_ISDIR(st.st_mode)) {
+				if (!isLink) subdirs.push_back(path);	// Links are not followed to avoid cycles
+			}
+			else if (S_ISREG(st.st_mode) && isInstrumentFile(name)) {
+#ifdef __APPLE__
+				const timespec& mtime = st.st_mtimespec;
+#else
+				const timespec& mtime = st.st_mtim;
+#endif
+				int64_t time = static_cast<int64_t>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec;
+				files.push_back({ path, time, static_cast<uint64_t>(st.st_size) });
+			}
+		}
+		closedir(d);
+	}
+#endif
+
+	inline void appendUint64(BinaryContainer& ctr, uint64_t v)
+	{
+		ctr.appendUint32(static_cast<uint32_t>(v));
+		ctr.appendUint32(static_cast<uint32_t>(v >> 32));
+	}
+
+	inline uint64_t readUint64(const BinaryReader& ctr, size_t csr)
+	{
+		return ctr.readUint32(csr) | (static_cast<uint64_t>(ctr.readUint32(csr + 4)) << 32);
+	}
+
+	inline void appendString(BinaryContainer& ctr, const std::string& str)
+	{
+		ctr.appendUint32(str.size());
+		ctr.appendString(str);
+	}
+
+	inline std::string readString(const BinaryReader& ctr, size_t& csr)
+	{
+		size_t len = ctr.readUint32(csr);
+		std::string str = ctr.readString(csr + 4, len);
+		csr += 4 + len;
+		return str;
+	}
+}
+
+int InstrumentLibraryEntry::getFMAlgorithm() const
+{
+	return fmEnvelope.empty() ? -1 : fmEnvelope[static_cast<int>(FMEnvelopeParameter::AL)];
+}
+
+InstrumentLibrary::InstrumentLibrary()
+	: isCanceled_(false)
+{
+}
+
+InstrumentLibrary::~InstrumentLibrary()
+{
+	cancelScan();
+}
+
+/***** Index file *****/
+bool InstrumentLibrary::loadIndex(std::string path)
+{
+	MappedFile file;
+	if (!file.open(path)) return false;
+	const BinaryReader ctr = file.getReader();
+
+	std::map<std::string, InstrumentLibraryEntry> entries;
+	std::map<std::string, std::pair<int64_t, uint64_t>> rejected;
+	try {
+		if (!ctr.matchString(0, "BambooTrackerLib")) return false;
+		size_t csr = 16;
+		// Entries are parsed again if the instrument file format is changed
+		if (ctr.readUint32(csr) != INDEX_VERSION || ctr.readUint32(csr + 4) != Version::ofInstrumentFileInBCD())
+			return false;
+		size_t cnt = ctr.readUint32(csr + 8);
+		csr += 12;
+		for (size_t i = 0; i < cnt; ++i) {
+			InstrumentLibraryEntry entry;
+			entry.path = readString(ctr, csr);
+			entry.modifiedTime = static_cast<int64_t>(readUint64(ctr, csr));
+			entry.fileSize = readUint64(ctr, csr + 8);
+			csr += 16;
+			entry.name = readString(ctr, csr);
+			uint8_t source = ctr.readUint8(csr++);
+			if (source > static_cast<uint8_t>(SoundSource::SSG)) return false;
+			entry.source = static_cast<SoundSource>(source);
+			if (entry.source == SoundSource::FM) {
+				for (int p = 0; p < FM_ENVELOPE_PARAMETER_COUNT; ++p)
+					entry.fmEnvelope.push_back(ctr.readInt8(csr++));
+				uint8_t enabled = ctr.readUint8(csr++);
+				for (int op = 0; op < 4; ++op) entry.fmOperatorEnabled.push_back((enabled >> op) & 1);
+			}
+			size_t propCnt = ctr.readUint16(csr);
+			csr += 2;
+			for (size_t p = 0; p < propCnt; ++p) {
+				entry.propertyHashes.emplace_back(ctr.readUint8(csr), readUint64(ctr, csr + 1));
+				csr += 9;
+			}
+			std::string key = entry.path;
+			entries.emplace(std::move(key), std::move(entry));
+		}
+		cnt = ctr.readUint32(csr);
+		csr += 4;
+		for (size_t i = 0; i < cnt; ++i) {
+			std::string path = readString(ctr, csr);
+			rejected[path] = std::make_pair(static_cast<int64_t>(readUint64(ctr, csr)), readUint64(ctr, csr + 8));
+			csr += 16;
+		}
+	}
+	catch (std::out_of_range&) {	// Broken index
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	entries_ = std::move(entries);
+	rejectedFiles_ = std::move(rejected);
+	return true;
+}
+
+bool InstrumentLibrary::saveIndex(std::string path) const
+{
+	BinaryContainer ctr;
+	ctr.appendString("BambooTrackerLib");
+	ctr.appendUint32(INDEX_VERSION);
+	ctr.appendUint32(Version::ofInstrumentFileInBCD());
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		ctr.appendUint32(entries_.size());
+		for (auto& pair : entries_) {
+			const InstrumentLibraryEntry& entry = pair.second;
+			appendString(ctr, entry.path);
+			appendUint64(ctr, static_cast<uint64_t>(entry.modifiedTime));
+			appendUint64(ctr, entry.fileSize);
+			appendString(ctr, entry.name);
+			ctr.appendUint8(static_cast<uint8_t>(entry.source));
+			if (entry.source == SoundSource::FM) {
+				for (auto& v : entry.fmEnvelope) ctr.appendInt8(v);
+				uint8_t enabled = 0;
+				for (int op = 0; op < 4; ++op) enabled |= (entry.fmOperatorEnabled[op] << op);
+				ctr.appendUint8(enabled);
+			}
+			ctr.appendUint16(entry.propertyHashes.size());
+			for (auto& prop : entry.propertyHashes) {
+				ctr.appendUint8(prop.first);
+				appendUint64(ctr, prop.second);
+			}
+		}
+		ctr.appendUint32(rejectedFiles_.size());
+		for (auto& pair : rejectedFiles_) {
+			appendString(ctr, pair.first);
+			appendUint64(ctr, static_cast<uint64_t>(pair.second.first));
+			appendUint64(ctr, pair.second.second);
+		}
+	}
+
+	BinaryReader reader = ctr.getReader();
+	return AtomicFileWriter::write(path, reader.data(), reader.size());
+}
+
+/***** Scan *****/
+bool InstrumentLibrary::scanInBackground(std::vector<std::string> dirs)
+{
+	if (isScanning()) return false;
+	if (scan_.valid()) scan_.get();
+	isCanceled_ = false;
+	scan_ = std::async(std::launch::async, [this, dirs] { return scan(dirs); });
+	return true;
+}
+
+bool InstrumentLibrary::isScanning() const
+{
+	return (scan_.valid() && scan_.wait_for(std::chrono::seconds(0)) != std::future_status::ready);
+}
+
+size_t InstrumentLibrary::waitForScan()
+{
+	return scan_.valid() ? scan_.get() : 0;
+}
+
+void InstrumentLibrary::cancelScan()
+{
+	isCanceled_ = true;
+	if (scan_.valid()) scan_.get();
+}
+
+size_t InstrumentLibrary::scan(std::vector<std::string> dirs)
+{
+	std::vector<FileStatus> files;
+	while (!dirs.empty()) {
+		if (isCanceled_) return 0;
+		std::string dir = dirs.back();
+		dirs.pop_back();
+		listDirectory(dir, files, dirs);
+	}
+
+	std::map<std::string, InstrumentLibraryEntry> prev;
+	std::map<std::string, std::pair<int64_t, uint64_t>> prevRejected;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		prev = entries_;
+		prevRejected = rejectedFiles_;
+	}
+
+	// Unchanged files keep their entries, so only new or edited files are read
+	std::map<std::string, InstrumentLibraryEntry> entries;
+	std::map<std::string, std::pair<int64_t, uint64_t>> rejected;
+	size_t parsedCnt = 0;
+	for (auto& file : files) {
+		if (isCanceled_) return 0;
+		auto status = std::make_pair(file.modifiedTime, file.size);
+		auto it = prev.find(file.path);
+		if (it != prev.end() && std::make_pair(it->second.modifiedTime, it->second.fileSize) == status) {
+			entries.emplace(file.path, std::move(it->second));
+			continue;
+		}
+		auto rit = prevRejected.find(file.path);
+		if (rit != prevRejected.end() && rit->second == status) {
+			rejected.insert(*rit);
+			continue;
+		}
+
+		InstrumentLibraryEntry entry;
+		++parsedCnt;
+		if (readEntry(file.path, entry)) {
+			entry.modifiedTime = file.modifiedTime;
+			entry.fileSize = file.size;
+			entries.emplace(file.path, std::move(entry));
+		}
+		else {
+			rejected.emplace(file.path, status);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	entries_ = std::move(entries);
+	rejectedFiles_ = std::move(rejected);
+	return parsedCnt;
+}
+
+/***** Query *****/
+size_t InstrumentLibrary::getEntryCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries_.size();
+}
+
+std::vector<InstrumentLibraryEntry> InstrumentLibrary::search(std::string keyword) const
+{
+	return searchIf(keyword, -1, -1);
+}
+
+std::vector<InstrumentLibraryEntry> InstrumentLibrary::search(std::string keyword, SoundSource source,
+															  int fmAlgorithm) const
+{
+	return searchIf(keyword, static_cast<int>(source), fmAlgorithm);
+}
+
+std::vector<InstrumentLibraryEntry> InstrumentLibrary::searchIf(std::string keyword, int source, int fmAlgorithm) const
+{
+	keyword = toLower(keyword);
+	std::vector<InstrumentLibraryEntry> list;
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto& pair : entries_) {
+		const InstrumentLibraryEntry& entry = pair.second;
+		if (source != -1 && static_cast<int>(entry.source) != source) continue;
+		if (fmAlgorithm != -1 && entry.getFMAlgorithm() != fmAlgorithm) continue;
+		if (!keyword.empty() && toLower(entry.name).find(keyword) == std::string::npos) continue;
+		list.push_back(entry);
+	}
+	return list;
+}
+
+std::vector<InstrumentLibraryEntry> InstrumentLibrary::findSameProperty(uint8_t type, uint64_t hash) const
+{
+	std::vector<InstrumentLibraryEntry> list;
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto& pair : entries_) {
+		auto& hashes = pair.second.propertyHashes;
+		if (std::find(hashes.begin(), hashes.end(), std::make_pair(type, hash)) != hashes.end())
+			list.push_back(pair.second);
+	}
+	return list;
+}
+
+bool InstrumentLibrary::getEntry(std::string path, InstrumentLibraryEntry& entry) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = entries_.find(path);
+	if (it == entries_.end()) return false;
+	entry = it->second;
+	return true;
+}
+
+/***** Instrument file *****/
+bool InstrumentLibrary::readEntry(std::string path, InstrumentLibraryEntry& entry)
+{
+	MappedFile file;
+	if (!file.open(path)) return false;
+	entry.path = path;
+	entry.modifiedTime = 0;
+	entry.fileSize = file.size();
+	try {
+		return readEntry(file.getReader(), entry);
+	}
+	catch (std::out_of_range&) {	// Broken file
+		return false;
+	}
+}
+
+bool InstrumentLibrary::readEntry(const BinaryReader& ctr, InstrumentLibraryEntry& entry)
+{
+	size_t globCsr = 0;
+	if (!ctr.matchString(globCsr, "BambooTrackerIst")) return false;
+	globCsr += 20;	// Skip EOF offset
+	if (ctr.readUint32(globCsr) > Version::ofInstrumentFileInBCD()) return false;
+	globCsr += 4;
+
+	/***** Instrument section *****/
+	if (!ctr.matchString(globCsr, "INSTRMNT")) return false;
+	globCsr += 8;
+	size_t instOfs = ctr.readUint32(globCsr);
+	size_t instCsr = globCsr + 4;
+	size_t nameLen = ctr.readUint32(instCsr);
+	instCsr += 4;
+	entry.name = ctr.readString(instCsr, nameLen);
+	instCsr += nameLen;
+	switch (ctr.readUint8(instCsr)) {
+	case 0x00:	entry.source = SoundSource::FM;		break;
+	case 0x01:	entry.source = SoundSource::SSG;	break;
+	default:	return false;
+	}
+	globCsr += instOfs;
+
+	/***** Instrument property section *****/
+	if (!ctr.matchString(globCsr, "INSTPROP")) return false;
+	globCsr += 8;
+	size_t instPropCsr = globCsr + 4;
+	size_t instPropEnd = globCsr + ctr.readUint32(globCsr);
+	entry.fmEnvelope.clear();
+	entry.fmOperatorEnabled.clear();
+	entry.propertyHashes.clear();
+	while (instPropCsr < instPropEnd) {
+		uint8_t type = ctr.readUint8(instPropCsr++);
+		// Property size includes its size field
+		size_t size;
+		if (type <= 0x01) size = ctr.readUint8(instPropCsr);		// FM envelope, LFO
+		else if (type <= 0x29 || (0x30 <= type && type <= 0x34)) size = ctr.readUint16(instPropCsr);
+		else return false;
+		if (!size || size > ctr.size() - instPropCsr) return false;
+		entry.propertyHashes.emplace_back(type, hash(ctr.data() + instPropCsr, size));
+
+		if (type == 0x00 && entry.source == SoundSource::FM) {
+			std::vector<int>& env = entry.fmEnvelope;
+			env.assign(FM_ENVELOPE_PARAMETER_COUNT, 0);
+			// Parameters of operators are placed in the same order
+			auto set = [&env](FMEnvelopeParameter op1Param, int op, int v) {
+				int offset = static_cast<int>(FMEnvelopeParameter::AR2) - static_cast<int>(FMEnvelopeParameter::AR1);
+				env[static_cast<int>(op1Param) + op * offset] = v;
+			};
+			size_t csr = instPropCsr + 1;
+			uint8_t tmp = ctr.readUint8(csr++);
+			env[static_cast<int>(FMEnvelopeParameter::AL)] = tmp >> 4;
+			env[static_cast<int>(FMEnvelopeParameter::FB)] = tmp & 0x0f;
+			for (int op = 0; op < 4; ++op) {
+				tmp = ctr.readUint8(csr++);
+				entry.fmOperatorEnabled.push_back((0x20 & tmp) ? true : false);
+				set(FMEnvelopeParameter::AR1, op, tmp & 0x1f);
+				tmp = ctr.readUint8(csr++);
+				set(FMEnvelopeParameter::KS1, op, tmp >> 5);
+				set(FMEnvelopeParameter::DR1, op, tmp & 0x1f);
+				tmp = ctr.readUint8(csr++);
+				set(FMEnvelopeParameter::DT1, op, tmp >> 5);
+				set(FMEnvelopeParameter::SR1, op, tmp & 0x1f);
+				tmp = ctr.readUint8(csr++);
+				set(FMEnvelopeParameter::SL1, op, tmp >> 4);
+				set(FMEnvelopeParameter::RR1, op, tmp & 0x0f);
+				tmp = ctr.readUint8(csr++);
+				set(FMEnvelopeParameter::TL1, op, tmp);
+				tmp = ctr.readUint8(csr++);
+				set(FMEnvelopeParameter::ML1, op, tmp & 0x0f);
+				env[static_cast<int>(FMEnvelopeParameter::SSGEG1) + op] = (tmp & 0x80) ? -1 : ((tmp >> 4) & 0x07);
+			}
+		}
+		instPropCsr += size;
+	}
+	// FM instrument always has its envelope
+	return (entry.source != SoundSource::FM || !entry.fmEnvelope.empty());
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <future>
+#include <atomic>
+#include <utility>
+#include "misc.hpp"
+#include "binary_reader.hpp"
+
+/// Metadata of an instrument file read without creating the instrument
+struct InstrumentLibraryEntry
+{
+	std::string path;
+	int64_t modifiedTime;
+	uint64_t fileSize;
+
+	std::string name;
+	SoundSource source;
+	/// FM envelope indexed by FMEnvelopeParameter, empty if the instrument is not FM
+	std::vector<int> fmEnvelope;
+	std::vector<bool> fmOperatorEnabled;
+	/// Pairs of the property type in the file and the hash of its data.
+	/// Instruments which have the same hash share the property
+	std::vector<std::pair<uint8_t, uint64_t>> propertyHashes;
+
+	/// -1 if the instrument is not FM
+	int getFMAlgorithm() const;
+};
+
+/// Index of instrument files (*.bti) in directories.
+/// Directories are scanned on a worker thread, and only files whose size or modified time
+/// is changed since the last scan are parsed. The index is kept in a file between sessions
+class InstrumentLibrary
+{
+public:
+	InstrumentLibrary();
+	~InstrumentLibrary();
+	InstrumentLibrary(const InstrumentLibrary&) = delete;
+	InstrumentLibrary& operator=(const InstrumentLibrary&) = delete;
+
+	/// Return false if the index is missing, broken or written by another version
+	bool loadIndex(std::string path);
+	bool saveIndex(std::string path) const;
+
+	/// Directories are scanned recursively, and entries of missing files are removed.
+	/// Queries return the previous entries until the scan finishes.
+	/// Return false if a scan is running
+	bool scanInBackground(std::vector<std::string> dirs);
+	bool isScanning() const;
+	/// Return the number of files parsed in the scan
+	size_t waitForScan();
+	/// The previous entries are kept
+	void cancelScan();
+
+	size_t getEntryCount() const;
+	/// Names are matched by the case-insensitive keyword, and entries are sorted by path.
+	///		fmAlgorithm: -1 (any)
+	std::vector<InstrumentLibraryEntry> search(std::string keyword) const;
+	std::vector<InstrumentLibraryEntry> search(std::string keyword, SoundSource source, int fmAlgorithm = -1) const;
+	std::vector<InstrumentLibraryEntry> findSameProperty(uint8_t type, uint64_t hash) const;
+	bool getEntry(std::string path, InstrumentLibraryEntry& entry) const;
+
+	/// Read sections of the file, instrument properties are only hashed
+	static bool readEntry(std::string path, InstrumentLibraryEntry& entry);
+
+private:
+	mutable std::mutex mutex_;
+	std::map<std::string, InstrumentLibraryEntry> entries_;
+	/// Files which are not instruments, with the modified time and the size
+	std::map<std::string, std::pair<int64_t, uint64_t>> rejectedFiles_;
+	std::future<size_t> scan_;
+	std::atomic_bool isCanceled_;
+
+	size_t scan(std::vector<std::string> dirs);
+	std::vector<InstrumentLibraryEntry> searchIf(std::string keyword, int source, int fmAlgorithm) const;
+
+	static bool readEntry(const BinaryReader& ctr, InstrumentLibraryEntry& entry);
+};
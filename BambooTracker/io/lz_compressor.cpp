@@ -0,0 +1,160 @@
+#include "lz_compressor.hpp"
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	const size_t MIN_MATCH = 4;
+	const size_t MAX_OFFSET = 0xffff;
+	const int MAX_HASH_BITS = 16;
+	const int MIN_HASH_BITS = 10;
+
+	inline uint32_t hash(const char* p, int bits)
+	{
+		uint32_t v;
+		std::memcpy(&v, p, 4);
+		return (v * 2654435761u) >> (32 - bits);
+	}
+
+	/// Token nibble 15 is continued by bytes of 255 and the last byte
+	inline void appendLength(std::vector<char>& dst, size_t len)
+	{
+		for (; len >= 255; len -= 255) dst.push_back(static_cast<char>(255));
+		dst.push_back(static_cast<char>(len));
+	}
+
+	/// Match length is 0 in the last sequence, and it has no offset
+	void appendSequence(std::vector<char>& dst, const char* lit, size_t litLen, size_t offset, size_t matchLen)
+	{
+		size_t mlCode = matchLen ? matchLen - MIN_MATCH : 0;
+		dst.push_back(static_cast<char>((std::min<size_t>(litLen, 15) << 4) | std::min<size_t>(mlCode, 15)));
+		if (litLen >= 15) appendLength(dst, litLen - 15);
+		dst.insert(dst.end(), lit, lit + litLen);
+		if (!matchLen) return;
+		dst.push_back(static_cast<char>(offset & 0xff));
+		dst.push_back(static_cast<char>(offset >> 8));
+		if (mlCode >= 15) appendLength(dst, mlCode - 15);
+	}
+
+	inline bool readLength(const unsigned char*& pos, const unsigned char* end, size_t& len)
+	{
+		unsigned char b;
+		do {
+			if (pos == end) return false;
+			b = *pos++;
+			len += b;
+		} while (b == 255);
+		return true;
+	}
+}
+
+void LZCompressor::compress(const char* src, size_t size, int level, std::vector<char>& dst)
+{
+	// Each level doubles candidates searched in the hash chain
+	int depth = 1 << (std::min(std::max(level, 1), 9) - 1);
+
+	// Small data uses a small table since it is cleared for each call
+	int bits = MIN_HASH_BITS;
+	while (bits < MAX_HASH_BITS && (static_cast<size_t>(1) << bits) < size) ++bits;
+	std::vector<int32_t> head(static_cast<size_t>(1) << bits, -1);
+	std::vector<int32_t> chain(size);
+	auto insert = [&](size_t pos) {
+		uint32_t h = hash(src + pos, bits);
+		chain[pos] = head[h];
+		head[h] = static_cast<int32_t>(pos);
+	};
+
+	size_t anchor = 0;
+	size_t pos = 0;
+	while (pos + MIN_MATCH <= size) {
+		size_t bestLen = 0, bestOfs = 0;
+		int32_t cand = head[hash(src + pos, bits)];
+		for (int d = 0; d < depth && cand >= 0 && pos - cand <= MAX_OFFSET; ++d) {
+			size_t len = 0;
+			size_t maxLen = size - pos;
+			while (len < maxLen && src[cand + len] == src[pos + len]) ++len;
+			if (len > bestLen) {
+				bestLen = len;
+				bestOfs = pos - cand;
+				if (len == maxLen) break;
+			}
+			cand = chain[cand];
+		}
+		insert(pos);
+
+		if (bestLen < MIN_MATCH) {
+			++pos;
+			continue;
+		}
+
+		appendSequence(dst, src + anchor, pos - anchor, bestOfs, bestLen);
+		size_t end = pos + bestLen;
+		for (++pos; pos < end && pos + MIN_MATCH <= size; ++pos) insert(pos);
+		pos = anchor = end;
+	}
+
+	appendSequence(dst, src + anchor, size - anchor, 0, 0);
+}
+
+bool LZCompressor::decompress(const char* src, size_t srcSize, char* dst, size_t dstSize)
+{
+	auto in = reinterpret_cast<const unsigned char*>(src);
+	const unsigned char* inEnd = in + srcSize;
+	char *out = dst, *outEnd = dst + dstSize;
+	while (true) {
+		if (in == inEnd) return false;
+		unsigned char token = *in++;
+		size_t litLen = token >> 4;
+		if (litLen == 15 && !readLength(in, inEnd, litLen)) return false;
+		if (litLen > static_cast<size_t>(inEnd - in) || litLen > static_cast<size_t>(outEnd - out)) return false;
+		if (litLen <= 16 && inEnd - in >= 16 && outEnd - out >= 16)
+			std::memcpy(out, in, 16);	// Fixed size copy is faster for short runs
+		else if (litLen)	// Output may be null if it is empty
+			std::memcpy(out, in, litLen);
+		in += litLen;
+		out += litLen;
+		if (in == inEnd) break;	// Last sequence has no match
+
+		if (inEnd - in < 2) return false;
+		size_t offset = in[0] | (in[1] << 8);
+		in += 2;
+		size_t matchLen = token & 0x0f;
+		if (matchLen == 15 && !readLength(in, inEnd, matchLen)) return false;
+		matchLen += MIN_MATCH;
+		if (!offset || offset > static_cast<size_t>(out - dst) || matchLen > static_cast<size_t>(outEnd - out))
+			return false;
+
+		const char* match = out - offset;
+		if (offset >= 8 && static_cast<size_t>(outEnd - out) >= matchLen + 8) {
+			// Each 8 bytes are written before they are read
+			for (size_t j = 0; j < matchLen; j += 8) std::memcpy(out + j, match + j, 8);
+		}
+		else if (offset >= matchLen) {
+			std::memcpy(out, match, matchLen);
+		}
+		else {
+			// Overlapped match repeats the last bytes
+			for (size_t j = 0; j < matchLen; ++j) out[j] = match[j];
+		}
+		out += matchLen;
+	}
+	return (out == outEnd);
+}
+
+uint32_t LZCompressor::checksum(const char* data, size_t size)
+{
+	auto p = reinterpret_cast<const unsigned char*>(data);
+	uint32_t a = 1, b = 0;
+	while (size) {
+		// Sums do not overflow in 5552 bytes before the modulo
+		size_t n = std::min<size_t>(size, 5552);
+		size -= n;
+		for (; n; --n) {
+			a += *p++;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+	return (b << 16) | a;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// LZ77 codec for module files in a byte-oriented format like LZ4 blocks.
+/// Each sequence is a token with literal and match lengths in nibbles, extra length bytes,
+/// literals and the 2-byte offset of a match within the last 64 KiB.
+/// Bytes are not entropy coded, so decoding is faster than parsing the decoded data
+class LZCompressor
+{
+public:
+	/// Append compressed data to the buffer.
+	///		level: 1 (fastest) - 9 (smallest)
+	static void compress(const char* src, size_t size, int level, std::vector<char>& dst);
+	/// Return false if the data is broken or is not decoded to the size
+	static bool decompress(const char* src, size_t srcSize, char* dst, size_t dstSize);
+	/// Adler-32 of the data
+	static uint32_t checksum(const char* data, size_t size);
+
+private:
+	LZCompressor() {}
+};
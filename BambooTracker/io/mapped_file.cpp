@@ -0,0 +1,118 @@
+#include "mapped_file.hpp"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: data_(nullptr),
+	  size_(0)
+#ifdef _WIN32
+	  , mapping_(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(std::string path)
+{
+	close();
+
+	// Path is UTF-8
+	int len = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+	if (len <= 0) return false;
+	std::wstring wpath(static_cast<size_t>(len), L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wpath[0], len);
+
+	HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fsize;
+	if (!GetFileSizeEx(file, &fsize) || !fsize.QuadPart) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);	// The mapping keeps the file open
+	if (!mapping) return false;
+
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data) {
+		CloseHandle(mapping);
+		return false;
+	}
+
+	mapping_ = mapping;
+	data_ = static_cast<const char*>(data);
+	size_ = static_cast<size_t>(fsize.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data_) UnmapViewOfFile(data_);
+	if (mapping_) CloseHandle(mapping_);
+	data_ = nullptr;
+	mapping_ = nullptr;
+	size_ = 0;
+}
+#else
+bool MappedFile::open(std::string path)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd == -1) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) == -1 || st.st_size <= 0) {
+		::close(fd);
+		return false;
+	}
+
+	size_t size = static_cast<size_t>(st.st_size);
+	void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);	// The mapping keeps the file open
+	if (data == MAP_FAILED) return false;
+
+	// Sections are parsed from the head to the end
+	madvise(data, size, MADV_SEQUENTIAL);
+
+	data_ = static_cast<const char*>(data);
+	size_ = size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data_) munmap(const_cast<char*>(data_), size_);
+	data_ = nullptr;
+	size_ = 0;
+}
+#endif
+
+bool MappedFile::isOpen() const
+{
+	return (data_ != nullptr);
+}
+
+size_t MappedFile::size() const
+{
+	return size_;
+}
+
+BinaryReader MappedFile::getReader() const
+{
+	return BinaryReader(data_, size_);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "binary_reader.hpp"
+
+/// Read-only memory mapping of a whole file.
+/// Pages are read on access, so parsing a part of the file does not read the rest
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(std::string path);
+	void close();
+	bool isOpen() const;
+	size_t size() const;
+
+	/// The reader is valid until the file is closed
+	BinaryReader getReader() const;
+
+private:
+	const char* data_;
+	size_t size_;
+#ifdef _WIN32
+	void* mapping_;
+#endif
+};
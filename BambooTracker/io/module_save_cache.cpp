@@ -0,0 +1,38 @@
+#include "module_save_cache.hpp"
+#include <utility>
+
+void ModuleSaveCache::begin()
+{
+	// Take back blocks of the save which was interrupted
+	for (auto& pair : curPtns_) lastPtns_[pair.first] = std::move(pair.second);
+	curPtns_.clear();
+}
+
+const std::vector<char>* ModuleSaveCache::reusePattern(uint64_t revision)
+{
+	auto cur = curPtns_.find(revision);
+	if (cur != curPtns_.end()) return &cur->second;
+
+	auto last = lastPtns_.find(revision);
+	if (last == lastPtns_.end()) return nullptr;
+	auto& block = curPtns_[revision] = std::move(last->second);
+	lastPtns_.erase(last);
+	return &block;
+}
+
+void ModuleSaveCache::storePattern(uint64_t revision, std::vector<char> block)
+{
+	curPtns_[revision] = std::move(block);
+}
+
+void ModuleSaveCache::finish()
+{
+	lastPtns_.swap(curPtns_);
+	curPtns_.clear();
+}
+
+void ModuleSaveCache::clear()
+{
+	lastPtns_.clear();
+	curPtns_.clear();
+}
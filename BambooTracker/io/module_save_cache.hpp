@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+/// Encoded pattern subblocks of the last save, keyed by pattern revision.
+/// Patterns not edited after the last save are copied from here instead of encoding steps again
+class ModuleSaveCache
+{
+public:
+	/// Called at the start of each save
+	void begin();
+	/// Return nullptr if the pattern has been edited after the last save.
+	/// The block is kept for the next save
+	const std::vector<char>* reusePattern(uint64_t revision);
+	void storePattern(uint64_t revision, std::vector<char> block);
+	/// Called after the save succeeded. Blocks of patterns not saved this time are dropped
+	void finish();
+	void clear();
+
+private:
+	std::unordered_map<uint64_t, std::vector<char>> lastPtns_, curPtns_;
+};
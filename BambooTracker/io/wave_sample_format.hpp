@@ -0,0 +1,8 @@
+#pragma once
+
+enum class WaveSampleFormat : int
+{
+	INT16,
+	INT24,
+	FLOAT32
+};
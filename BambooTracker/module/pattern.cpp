@@ -1,13 +1,22 @@
 #include "pattern.hpp"
+#include <atomic>
+
+namespace
+{
+	// Patterns are also built on the autosave thread
+	std::atomic<uint64_t> revisionCounter(0);
+}
 
 Pattern::Pattern(int n, size_t defSize)
-	: num_(n), size_(defSize), steps_(defSize), usedCnt_(0)
+	: num_(n), size_(defSize), steps_(std::make_shared<std::vector<Step>>(defSize)), usedCnt_(0)
 {
+	renewRevision();
 }
 
-Pattern::Pattern(int n, size_t size, std::vector<Step> steps)
+Pattern::Pattern(int n, size_t size, std::shared_ptr<std::vector<Step>> steps)
 	: num_(n), size_(size), steps_(steps), usedCnt_(0)
 {
+	renewRevision();
 }
 
 void Pattern::setNumber(int n)
@@ -37,15 +46,23 @@ int Pattern::getUsedCount() const
 
 Step& Pattern::getStep(int n)
 {
-	return steps_.at(n);
+	detach();
+	renewRevision();
+	return steps_->at(n);
+}
+
+const Step& Pattern::getStep(int n) const
+{
+	return steps_->at(n);
 }
 
 size_t Pattern::getSize() const
 {
 	for (size_t i = 0; i < size_; ++i) {
-		if (steps_[i].checkEffectID("0B") != -1
-				|| steps_[i].checkEffectID("0C") != -1
-				|| steps_[i].checkEffectID("0D") != -1)
+		const Step& step = (*steps_)[i];
+		if (step.checkEffectID("0B") != -1
+				|| step.checkEffectID("0C") != -1
+				|| step.checkEffectID("0D") != -1)
 			return i + 1;
 	}
 	return size_;
@@ -55,29 +72,38 @@ void Pattern::changeSize(size_t size)
 {
 	if (0 < size && size <= 256) {
 		size_ = size;
-		if (steps_.size() < size) steps_.resize(size);
+		renewRevision();
+		if (steps_->size() < size) {
+			detach();
+			steps_->resize(size);
+		}
 	}
 }
 
 void Pattern::insertStep(int n)
 {
-	if (n < size_)
-		steps_.emplace(steps_.begin() + n);
+	if (n < size_) {
+		detach();
+		renewRevision();
+		steps_->emplace(steps_->begin() + n);
+	}
 }
 
 void Pattern::deletePreviousStep(int n)
 {
 	if (!n) return;
 
-	steps_.erase(steps_.begin() + n - 1);
-	if (steps_.size() < size_)
-		steps_.resize(size_);
+	detach();
+	renewRevision();
+	steps_->erase(steps_->begin() + n - 1);
+	if (steps_->size() < size_)
+		steps_->resize(size_);
 }
 
 bool Pattern::existCommand() const
 {
 	for (size_t i = 0; i < size_; ++i) {
-		if (steps_.at(i).existCommand())
+		if (steps_->at(i).existCommand())
 			return true;
 	}
 	return false;
@@ -86,18 +112,24 @@ bool Pattern::existCommand() const
 std::vector<int> Pattern::getEditedStepIndices() const
 {
 	std::vector<int> list;
+	getEditedStepIndices(list);
+	return list;
+}
+
+void Pattern::getEditedStepIndices(std::vector<int>& list) const
+{
+	list.clear();
 	for (size_t i = 0; i < size_; ++i) {
-		if (steps_.at(i).existCommand())
+		if (steps_->at(i).existCommand())
 			list.push_back(i);
 	}
-	return list;
 }
 
 std::set<int> Pattern::getRegisteredInstruments() const
 {
 	std::set<int> set;
 	for (size_t i = 0; i < size_; ++i) {
-		int n = steps_.at(i).getInstrumentNumber();
+		int n = steps_->at(i).getInstrumentNumber();
 		if (n > -1) set.insert(n);
 	}
 	return set;
@@ -110,5 +142,22 @@ Pattern Pattern::clone(int asNumber)
 
 void Pattern::clear()
 {
-	steps_ = std::vector<Step>(size_);
+	steps_ = std::make_shared<std::vector<Step>>(size_);
+	renewRevision();
+}
+
+uint64_t Pattern::getRevision() const
+{
+	return revision_;
+}
+
+void Pattern::detach()
+{
+	if (steps_.use_count() > 1)
+		steps_ = std::make_shared<std::vector<Step>>(*steps_);
+}
+
+void Pattern::renewRevision()
+{
+	revision_ = ++revisionCounter;
 }
@@ -2,7 +2,9 @@
 
 #include <vector>
 #include <set>
+#include <memory>
 #include <cstddef>
+#include <cstdint>
 #include "step.hpp"
 
 class Pattern
@@ -17,7 +19,9 @@ public:
 	int usedCountDown();
 	int getUsedCount() const;
 
+	/// Copy shared steps before returning the step to edit
 	Step& getStep(int n);
+	const Step& getStep(int n) const;
 
 	size_t getSize() const;
 	void changeSize(size_t size);
@@ -27,17 +31,27 @@ public:
 
 	bool existCommand() const;
 	std::vector<int> getEditedStepIndices() const;
+	/// Reuse the list buffer
+	void getEditedStepIndices(std::vector<int>& list) const;
 	std::set<int> getRegisteredInstruments() const;
 
+	/// Steps are shared until either pattern is edited
 	Pattern clone(int asNumber);
 
 	void clear();
 
+	/// Renewed on each edit and unique in the process,
+	/// so patterns with the same revision have the same steps
+	uint64_t getRevision() const;
+
 private:
 	int num_;
 	size_t size_;
-	std::vector<Step> steps_;
+	std::shared_ptr<std::vector<Step>> steps_;	// Copy on write
 	int usedCnt_;
+	uint64_t revision_;
 
-	Pattern(int n, size_t size, std::vector<Step> steps);
+	Pattern(int n, size_t size, std::shared_ptr<std::vector<Step>> steps);
+	void detach();
+	void renewRevision();
 };
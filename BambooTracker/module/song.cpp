@@ -9,24 +9,60 @@ Song::Song(int number, SongType songType, std::string title, bool isUsedTempo,
 	  tempo_(tempo),
 	  groove_(groove),
 	  speed_(speed),
-	  defPtnSize_(defaultPatternSize)
+	  defPtnSize_(defaultPatternSize),
+	  isDecoded_(false)
 {
-	switch (songType) {
-	case SongType::STD:
-		tracks_.reserve(15);
-		for (int i = 0; i < 6; ++i) {
-			tracks_.emplace_back(i, SoundSource::FM, i, defaultPatternSize);
-		}
-		for (int i = 0; i < 3; ++i) {
-			tracks_.emplace_back(i + 6, SoundSource::SSG, i, defaultPatternSize);
-		}
-		for (int i = 0; i < 6; ++i) {
-			tracks_.emplace_back(i + 9, SoundSource::DRUM, i, defaultPatternSize);
-		}
-		break;
-	case SongType::FMEX:
-		// UNDONE: FM extend mode
-		break;
+}
+
+Song::Song(const Song& other)
+	: isDecoded_(false)
+{
+	assign(other);
+}
+
+Song::Song(Song&& other)
+	: isDecoded_(false)
+{
+	assign(other);
+}
+
+Song& Song::operator=(const Song& other)
+{
+	if (this != &other) assign(other);
+	return *this;
+}
+
+Song& Song::operator=(Song&& other)
+{
+	if (this != &other) assign(other);
+	return *this;
+}
+
+void Song::assign(const Song& other)
+{
+	num_ = other.num_;
+	type_ = other.type_;
+	title_ = other.title_;
+	isUsedTempo_ = other.isUsedTempo_;
+	tempo_ = other.tempo_;
+	groove_ = other.groove_;
+	speed_ = other.speed_;
+	defPtnSize_ = other.defPtnSize_;
+
+	std::lock(decodeMutex_, other.decodeMutex_);
+	std::lock_guard<std::mutex> lg(decodeMutex_, std::adopt_lock);
+	std::lock_guard<std::mutex> lgOther(other.decodeMutex_, std::adopt_lock);
+	tracks_ = other.tracks_;
+	decoder_ = other.decoder_;
+	isDecoded_.store(other.isDecoded_.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+void Song::createTracks() const
+{
+	std::vector<TrackAttribute> attribs = getTrackAttributes();
+	tracks_.reserve(attribs.size());
+	for (auto& attrib : attribs) {
+		tracks_.emplace_back(attrib.number, attrib.source, attrib.channelInSource, defPtnSize_);
 	}
 }
 
@@ -92,6 +128,7 @@ int Song::getSpeed() const
 
 void Song::setDefaultPatternSize(size_t size)
 {
+	decode();
 	defPtnSize_ = size;
 	for (auto& t : tracks_) {
 		t.changeDefaultPatternSize(size);
@@ -116,19 +153,41 @@ SongStyle Song::getStyle() const
 std::vector<TrackAttribute> Song::getTrackAttributes() const
 {
 	std::vector<TrackAttribute> ret;
-	for (auto& track : tracks_) {
-		ret.push_back(track.getAttribute());
+	switch (type_) {
+	case SongType::STD:
+		ret.reserve(15);
+		for (int i = 0; i < 6; ++i) {
+			ret.push_back({ i, SoundSource::FM, i });
+		}
+		for (int i = 0; i < 3; ++i) {
+			ret.push_back({ i + 6, SoundSource::SSG, i });
+		}
+		for (int i = 0; i < 6; ++i) {
+			ret.push_back({ i + 9, SoundSource::DRUM, i });
+		}
+		break;
+	case SongType::FMEX:
+		// UNDONE: FM extend mode
+		break;
 	}
 	return ret;
 }
 
 Track& Song::getTrack(int num)
 {
+	decode();
+	return tracks_.at(num);
+}
+
+const Track& Song::getTrack(int num) const
+{
+	decode();
 	return tracks_.at(num);
 }
 
 std::vector<OrderData> Song::getOrderData(int order)
 {
+	decode();
 	std::vector<OrderData> ret;
 	for (auto& track : tracks_) {
 		ret.push_back(track.getOrderData(order));
@@ -138,6 +197,7 @@ std::vector<OrderData> Song::getOrderData(int order)
 
 size_t Song::getOrderSize() const
 {
+	decode();
 	return tracks_[0].getOrderSize();
 }
 
@@ -149,6 +209,7 @@ bool Song::canAddNewOrder() const
 void Song::insertOrderBelow(int order)
 {
 	if (!canAddNewOrder()) return;
+	decode();
 	for (auto& track : tracks_) {
 		track.insertOrderBelow(order);
 	}
@@ -156,6 +217,7 @@ void Song::insertOrderBelow(int order)
 
 void Song::deleteOrder(int order)
 {
+	decode();
 	for (auto& track : tracks_) {
 		track.deleteOrder(order);
 	}
@@ -163,6 +225,7 @@ void Song::deleteOrder(int order)
 
 void Song::swapOrder(int a, int b)
 {
+	decode();
 	for (auto& track : tracks_) {
 		track.swapOrder(a, b);
 	}
@@ -170,6 +233,7 @@ void Song::swapOrder(int a, int b)
 
 std::set<int> Song::getRegisteredInstruments() const
 {
+	decode();
 	std::set<int> set;
 	for (auto& track : tracks_) {
 		for (auto& n : track.getRegisteredInstruments()) {
@@ -181,5 +245,33 @@ std::set<int> Song::getRegisteredInstruments() const
 
 void Song::clearUnusedPatterns()
 {
+	decode();
 	for (auto& track : tracks_) track.clearUnusedPatterns();
 }
+
+void Song::setDecoder(std::function<void(std::vector<Track>&)> decoder)
+{
+	std::lock_guard<std::mutex> lg(decodeMutex_);
+	decoder_ = decoder;
+	std::vector<Track>().swap(tracks_);
+	isDecoded_.store(false, std::memory_order_release);
+}
+
+bool Song::isDecoded() const
+{
+	return isDecoded_.load(std::memory_order_acquire);
+}
+
+void Song::decode() const
+{
+	if (isDecoded_.load(std::memory_order_acquire)) return;
+
+	std::lock_guard<std::mutex> lg(decodeMutex_);
+	if (isDecoded_.load(std::memory_order_relaxed)) return;
+	createTracks();
+	if (decoder_) {
+		decoder_(tracks_);
+		decoder_ = nullptr;
+	}
+	isDecoded_.store(true, std::memory_order_release);
+}
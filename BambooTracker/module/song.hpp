@@ -3,6 +3,9 @@
 #include <vector>
 #include <set>
 #include <string>
+#include <functional>
+#include <atomic>
+#include <mutex>
 #include "track.hpp"
 #include "misc.hpp"
 
@@ -13,6 +16,11 @@ class Song
 public:
 	Song(int number, SongType songType = SongType::STD, std::string title = u8"", bool isUsedTempo = true,
 		 int tempo = 150, int groove = 0, int speed = 6, size_t defaultPatternSize = 64);
+	/// Copies of an undecoded song share the decoder, so the copy can be decoded on another thread
+	Song(const Song& other);
+	Song(Song&& other);
+	Song& operator=(const Song& other);
+	Song& operator=(Song&& other);
 
 	void setNumber(int n);
 	int getNumber() const;
@@ -29,9 +37,11 @@ public:
 	void setDefaultPatternSize(size_t size);
 	size_t getDefaultPatternSize() const;
 
+	/// Style is fixed by the song type, so tracks are not decoded
 	SongStyle getStyle() const;
 	std::vector<TrackAttribute> getTrackAttributes() const;
 	Track& getTrack(int num);
+	const Track& getTrack(int num) const;
 
 	std::vector<OrderData> getOrderData(int order);
 	size_t getOrderSize() const;
@@ -44,6 +54,12 @@ public:
 
 	void clearUnusedPatterns();
 
+	/// Set the function to fill tracks when they are first accessed.
+	/// It must only read data which is not changed after this call,
+	/// and the data must be checked beforehand since accessors cannot report errors
+	void setDecoder(std::function<void(std::vector<Track>&)> decoder);
+	bool isDecoded() const;
+
 private:
 	int num_;
 	SongType type_;
@@ -54,7 +70,16 @@ private:
 	int speed_;
 	size_t defPtnSize_;
 
-	std::vector<Track> tracks_;
+	// Tracks are built on first access
+	mutable std::vector<Track> tracks_;
+	mutable std::function<void(std::vector<Track>&)> decoder_;
+	mutable std::atomic_bool isDecoded_;
+	/// Guards decoding and copying of tracks and decoder
+	mutable std::mutex decodeMutex_;
+
+	void createTracks() const;
+	void decode() const;
+	void assign(const Song& other);
 };
 
 struct SongStyle
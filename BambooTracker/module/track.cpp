@@ -2,26 +2,53 @@
 #include <utility>
 
 Track::Track(int number, SoundSource source, int channelInSource, int defPattenSize)
-	: attrib_(std::make_unique<TrackAttribute>())
+	: attrib_(std::make_unique<TrackAttribute>()),
+	  patterns_(256),
+	  defPtnSize_(defPattenSize),
+	  emptyPtn_(-1, defPattenSize),
+	  indexedRevs_(256, 0)
 {	
 	attrib_->number = number;
 	attrib_->source = source;
 	attrib_->channelInSource = channelInSource;
 
 	for (int i = 0; i < 256; ++i) {
-		patterns_.emplace_back(i, defPattenSize);
+		freePtns_.insert(freePtns_.end(), i);
 	}
 
-	patterns_[0].usedCountUp();
+	allocatePattern(0).usedCountUp();
 	order_.push_back(0);	// Set first order
 }
 
+Track::Track(const Track& other)
+	: attrib_(std::make_unique<TrackAttribute>(*other.attrib_)),
+	  order_(other.order_),
+	  patterns_(256),
+	  freePtns_(other.freePtns_),
+	  defPtnSize_(other.defPtnSize_),
+	  emptyPtn_(other.emptyPtn_),
+	  indexedRevs_(other.indexedRevs_),
+	  editedPtns_(other.editedPtns_),
+	  ptnInsts_(other.ptnInsts_),
+	  instRefCnt_(other.instRefCnt_)
+{
+	for (size_t i = 0; i < 256; ++i) {
+		if (other.patterns_[i]) patterns_[i] = std::make_unique<Pattern>(*other.patterns_[i]);
+	}
+}
+
+Track& Track::operator=(const Track& other)
+{
+	if (this != &other) *this = Track(other);
+	return *this;
+}
+
 TrackAttribute Track::getAttribute() const
 {
 	return *attrib_;
 }
 
-OrderData Track::getOrderData(int order)
+OrderData Track::getOrderData(int order) const
 {
 	OrderData res;
 	res.trackAttribute = getAttribute();
@@ -37,7 +64,13 @@ size_t Track::getOrderSize() const
 
 Pattern& Track::getPattern(int num)
 {
-	return patterns_.at(num);
+	return allocatePattern(num);
+}
+
+const Pattern& Track::getPattern(int num) const
+{
+	auto& ptn = patterns_.at(num);
+	return ptn ? *ptn : emptyPtn_;
 }
 
 Pattern& Track::getPatternFromOrderNumber(int num)
@@ -45,13 +78,23 @@ Pattern& Track::getPatternFromOrderNumber(int num)
 	return getPattern(order_.at(num));
 }
 
+const Pattern& Track::getPatternFromOrderNumber(int num) const
+{
+	return getPattern(order_.at(num));
+}
+
 int Track::searchFirstUneditedUnusedPattern() const
 {
-	for (size_t i = 0; i < patterns_.size(); ++i) {
-		if (!patterns_[i].existCommand() && !patterns_[i].getUsedCount())
+	updateIndex();
+
+	// Unallocated patterns are unedited and unused,
+	// so only allocated patterns before the first free one are checked
+	int end = freePtns_.empty() ? 256 : *freePtns_.begin();
+	for (int i = 0; i < end; ++i) {
+		if (!patterns_[i]->getUsedCount() && !editedPtns_.count(i))
 			return i;
 	}
-	return -1;
+	return freePtns_.empty() ? -1 : end;
 }
 
 int Track::clonePattern(int num)
@@ -59,35 +102,29 @@ int Track::clonePattern(int num)
 	int n = searchFirstUneditedUnusedPattern();
 	if (n == -1) return num;
 	else {
-		patterns_.at(n) = patterns_.at(num).clone(n);
+		getPattern(n) = allocatePattern(num).clone(n);
 		return n;
 	}
 }
 
 std::vector<int> Track::getEditedPatternIndices() const
 {
-	std::vector<int> list;
-	for (size_t i = 0; i < 256; ++i) {
-		if (patterns_[i].existCommand()) list.push_back(i);
-	}
-	return list;
+	updateIndex();
+	return std::vector<int>(editedPtns_.begin(), editedPtns_.end());
 }
 
 std::set<int> Track::getRegisteredInstruments() const
 {
+	updateIndex();
 	std::set<int> set;
-	for (auto& pattern : patterns_) {
-		for (auto& n : pattern.getRegisteredInstruments()) {
-			set.insert(n);
-		}
-	}
+	for (auto& pair : instRefCnt_) set.insert(set.end(), pair.first);
 	return set;
 }
 
 void Track::registerPatternToOrder(int order, int pattern)
 {
-	patterns_.at(pattern).usedCountUp();
-	patterns_.at(order_.at(order)).usedCountDown();
+	allocatePattern(pattern).usedCountUp();
+	allocatePattern(order_.at(order)).usedCountDown();
 	order_.at(order) = pattern;
 }
 
@@ -98,12 +135,12 @@ void Track::insertOrderBelow(int order)
 
 	if (order == order_.size() - 1) order_.push_back(n);
 	else order_.insert(order_.begin() + order + 1, n);
-	patterns_[n].usedCountUp();
+	allocatePattern(n).usedCountUp();
 }
 
 void Track::deleteOrder(int order)
 {
-	patterns_.at(order_.at(order)).usedCountDown();
+	allocatePattern(order_.at(order)).usedCountDown();
 	order_.erase(order_.begin() + order);
 }
 
@@ -114,15 +151,57 @@ void Track::swapOrder(int a, int b)
 
 void Track::changeDefaultPatternSize(size_t size)
 {
-	for (auto& ptn : patterns_) {
-		ptn.changeSize(size);
+	if (0 < size && size <= 256) defPtnSize_ = size;
+	emptyPtn_.changeSize(size);
+	for (size_t i = 0; i < 256; ++i) {
+		if (patterns_[i]) patterns_[i]->changeSize(size);
 	}
 }
 
 void Track::clearUnusedPatterns()
 {
+	// Keep the slots so that sizes of cleared patterns are kept
 	for (size_t i = 0; i < 256; ++i) {
-		if (!patterns_[i].getUsedCount() && patterns_[i].existCommand())
-			patterns_[i].clear();
+		if (patterns_[i] && !patterns_[i]->getUsedCount() && patterns_[i]->existCommand()) {
+			patterns_[i]->clear();
+		}
+	}
+}
+
+Pattern& Track::allocatePattern(int num)
+{
+	auto& ptn = patterns_.at(num);
+	if (!ptn) {
+		ptn = std::make_unique<Pattern>(num, defPtnSize_);
+		freePtns_.erase(num);
+	}
+	return *ptn;
+}
+
+void Track::updateIndex() const
+{
+	// Revisions are renewed on every edit of patterns,
+	// so edits through kept references are also caught
+	for (int n = 0; n < 256; ++n) {
+		auto& ptn = patterns_[n];
+		uint64_t rev = ptn ? ptn->getRevision() : 0;
+		if (rev == indexedRevs_[n]) continue;
+		indexedRevs_[n] = rev;
+
+		auto it = ptnInsts_.find(n);
+		if (it != ptnInsts_.end()) {
+			for (int inst : it->second) {
+				if (!--instRefCnt_[inst]) instRefCnt_.erase(inst);
+			}
+			ptnInsts_.erase(it);
+		}
+		editedPtns_.erase(n);
+
+		if (!ptn || !ptn->existCommand()) continue;
+		editedPtns_.insert(n);
+		std::set<int> insts = ptn->getRegisteredInstruments();
+		if (insts.empty()) continue;
+		for (int inst : insts) ++instRefCnt_[inst];
+		ptnInsts_.emplace(n, std::move(insts));
 	}
 }
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <set>
+#include <map>
 #include <memory>
 #include "pattern.hpp"
 #include "misc.hpp"
@@ -13,11 +14,20 @@ class Track
 {
 public:
 	Track(int number, SoundSource source, int channelInSource, int defPattenSize);
+	/// Copied patterns share steps with the source until either is edited
+	Track(const Track& other);
+	Track& operator=(const Track& other);
+	Track(Track&&) = default;
+	Track& operator=(Track&&) = default;
 	TrackAttribute getAttribute() const;
-	OrderData getOrderData(int order);
+	OrderData getOrderData(int order) const;
 	size_t getOrderSize() const;
+	/// Allocate the pattern if it has not been used
 	Pattern& getPattern(int num);
+	/// Unallocated pattern is served as an empty pattern
+	const Pattern& getPattern(int num) const;
 	Pattern& getPatternFromOrderNumber(int num);
+	const Pattern& getPatternFromOrderNumber(int num) const;
 	int searchFirstUneditedUnusedPattern() const;
 	int clonePattern(int num);
 	std::vector<int> getEditedPatternIndices() const;
@@ -36,7 +46,21 @@ private:
 	std::unique_ptr<TrackAttribute> attrib_;
 
 	std::vector<int> order_;
-	std::vector<Pattern> patterns_;
+	// Patterns are allocated on first write or order reference
+	std::vector<std::unique_ptr<Pattern>> patterns_;
+	std::set<int> freePtns_;	// Unallocated pattern numbers
+	size_t defPtnSize_;
+	Pattern emptyPtn_;
+
+	// Usage index of edited patterns and instruments
+	// Patterns whose revision differs from the indexed one are reindexed in the next query
+	mutable std::vector<uint64_t> indexedRevs_;	// 0 = not indexed
+	mutable std::set<int> editedPtns_;
+	mutable std::map<int, std::set<int>> ptnInsts_;
+	mutable std::map<int, int> instRefCnt_;	// Number of patterns using each instrument
+
+	Pattern& allocatePattern(int num);
+	void updateIndex() const;
 };
 
 struct TrackAttribute
@@ -7,45 +7,6 @@ OPNAController::OPNAController(int clock, int rate, int duration)
 			std::make_unique<chip::LinearResampler>())
 {	
 	for (int ch = 0; ch < 6; ++ch) {
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::AL, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::FB, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::AR1, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::DR1, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::SR1, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::RR1, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::SL1, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::TL1, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::KS1, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::ML1, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::DT1, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::AR2, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::DR2, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::SR2, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::RR2, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::SL2, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::TL2, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::KS2, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::ML2, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::DT2, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::AR3, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::DR3, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::SR3, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::RR3, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::SL3, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::TL3, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::KS3, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::ML3, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::DT3, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::AR4, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::DR4, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::SR4, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::RR4, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::SL4, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::TL1, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::KS4, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::ML4, nullptr);
-		opSeqItFM_[ch].emplace(FMEnvelopeParameter::DT4, nullptr);
-
 		isMuteFM_[ch] = false;
 	}
 
@@ -87,7 +48,7 @@ void OPNAController::tickEvent(SoundSource src, int ch, bool isStep)
 }
 
 /********** Stream samples **********/
-void OPNAController::getStreamSamples(int16_t* container, size_t nSamples)
+void OPNAController::getStreamSamples(float* container, size_t nSamples)
 {
 	opna_.mix(container, nSamples);
 }
@@ -119,6 +80,12 @@ void OPNAController::setExportContainer(std::shared_ptr<chip::ExportContainerInt
 	opna_.setExportContainer(cntr);
 }
 
+/********** Output monitor **********/
+void OPNAController::setOutputMonitor(std::shared_ptr<chip::OutputMonitor> monitor)
+{
+	opna_.setOutputMonitor(monitor);
+}
+
 //---------- FM ----------//
 /********** Key on-off **********/
 void OPNAController::keyOnFM(int ch, Note note, int octave, int pitch, bool isJam)
@@ -212,11 +179,16 @@ void OPNAController::setInstrumentFM(int ch, std::shared_ptr<InstrumentFM> inst)
 
 	writeFMEnvelopeToRegistersFromInstrument(ch);
 	if (isKeyOnFM_[ch] && lfoStartCntFM_[ch] == -1) writeFMLFOAllRegisters(ch);
-	for (auto& p : opSeqItFM_[ch]) {
-		if (refInstFM_[ch]->getOperatorSequenceEnabled(p.first))
-			p.second = refInstFM_[ch]->getOperatorSequenceSequenceIterator(p.first);
-		else
-			p.second.reset();
+	opSeqFlagsFM_[ch] = 0;
+	for (int i = 0; i < FM_OPERATOR_SEQUENCE_PARAMETER_COUNT; ++i) {
+		auto param = static_cast<FMEnvelopeParameter>(i);
+		if (refInstFM_[ch]->getOperatorSequenceEnabled(param)) {
+			opSeqItFM_[ch][i] = refInstFM_[ch]->getOperatorSequenceSequenceIterator(param);
+			opSeqFlagsFM_[ch] |= (1ULL << i);
+		}
+		else {
+			opSeqItFM_[ch][i].reset();
+		}
 	}
 	if (!isArpEffFM_[ch]) {
 		if (refInstFM_[ch]->getArpeggioEnabled())
@@ -239,9 +211,11 @@ void OPNAController::updateInstrumentFM(int instNum)
 		if (refInstFM_[ch] && refInstFM_[ch]->getNumber() == instNum) {
 			writeFMEnvelopeToRegistersFromInstrument(ch);
 			if (isKeyOnFM_[ch] && lfoStartCntFM_[ch] == -1) writeFMLFOAllRegisters(ch);
-			for (auto& p : opSeqItFM_[ch]) {
-				if (!refInstFM_[ch]->getOperatorSequenceEnabled(p.first))
-					p.second.reset();
+			for (int i = 0; i < FM_OPERATOR_SEQUENCE_PARAMETER_COUNT; ++i) {
+				if (!refInstFM_[ch]->getOperatorSequenceEnabled(static_cast<FMEnvelopeParameter>(i))) {
+					opSeqItFM_[ch][i].reset();
+					opSeqFlagsFM_[ch] &= ~(1ULL << i);
+				}
 			}
 			if (!refInstFM_[ch]->getArpeggioEnabled()) arpItFM_[ch].reset();
 			if (!refInstFM_[ch]->getPitchEnabled()) ptItFM_[ch].reset();
@@ -461,9 +435,10 @@ void OPNAController::initFM()
 
 		// Init sequence
 		hasPreSetTickEventFM_[ch] = false;
-		for (auto& p : opSeqItFM_[ch]) {
-			p.second.reset();
+		for (auto& it : opSeqItFM_[ch]) {
+			it.reset();
 		}
+		opSeqFlagsFM_[ch] = 0;
 		arpItFM_[ch].reset();
 		ptItFM_[ch].reset();
 		needToneSetFM_[ch] = false;
@@ -1091,18 +1066,21 @@ void OPNAController::tickEventFM(int ch, bool isStep)
 
 void OPNAController::checkOperatorSequenceFM(int ch, int type)
 {
-	for (auto& p : opSeqItFM_[ch]) {
-		if (p.second) {
+	uint64_t flags = opSeqFlagsFM_[ch];
+	for (int i = 0; flags; ++i, flags >>= 1) {
+		if (flags & 1) {
+			auto& it = opSeqItFM_[ch][i];
 			int t;
 			switch (type) {
-			case 0:	t = p.second->next();		break;
-			case 1:	t = p.second->front();		break;
-			case 2:	t = p.second->next(true);	break;
+			case 0:	t = it->next();		break;
+			case 1:	t = it->front();		break;
+			case 2:	t = it->next(true);	break;
 			}
 			if (t != -1) {
-				int d = p.second->getCommandType();
-				if (d != envFM_[ch]->getParameterValue(p.first)) {
-					writeFMEnveropeParameterToRegister(ch, p.first, d);
+				auto param = static_cast<FMEnvelopeParameter>(i);
+				int d = it->getCommandType();
+				if (d != envFM_[ch]->getParameterValue(param)) {
+					writeFMEnveropeParameterToRegister(ch, param, d);
 				}
 			}
 		}
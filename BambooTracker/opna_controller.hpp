@@ -2,7 +2,6 @@
 
 #include <cstdint>
 #include <memory>
-#include <map>
 #include <deque>
 #include "opna.hpp"
 #include "instrument.hpp"
@@ -34,7 +33,7 @@ public:
 	void tickEvent(SoundSource src, int ch, bool isStep = false);
 
 	// Stream samples
-	void getStreamSamples(int16_t* container, size_t nSamples);
+	void getStreamSamples(float* container, size_t nSamples);
 
 	// Stream details
 	int getRate() const;
@@ -45,6 +44,9 @@ public:
 	// Export
 	void setExportContainer(std::shared_ptr<chip::ExportContainerInterface> cntr = nullptr);
 
+	// Output monitor
+	void setOutputMonitor(std::shared_ptr<chip::OutputMonitor> monitor = nullptr);
+
 
 private:
 	chip::OPNA opna_;
@@ -112,7 +114,10 @@ private:
 	int lfoStartCntFM_[6];
 	bool hasPreSetTickEventFM_[6];
 	bool needToneSetFM_[6];
-	std::map<FMEnvelopeParameter, std::unique_ptr<CommandSequence::Iterator>> opSeqItFM_[6];
+	/// Indexed by FMEnvelopeParameter
+	std::unique_ptr<CommandSequence::Iterator> opSeqItFM_[6][FM_OPERATOR_SEQUENCE_PARAMETER_COUNT];
+	/// Bit flags of opSeqItFM_ which have an iterator, to skip idle channels in each tick
+	uint64_t opSeqFlagsFM_[6];
 	std::unique_ptr<SequenceIteratorInterface> arpItFM_[6];
 	std::unique_ptr<CommandSequence::Iterator> ptItFM_[6];
 	bool isArpEffFM_[6];
@@ -1,6 +1,7 @@
 #include "audio_stream.hpp"
 #include <QSysInfo>
 #include <QAudio>
+#include "audio_profiler.hpp"
 
 AudioStream::AudioStream(uint32_t rate, uint32_t duration, uint32_t intrRate, QString device)
 {
@@ -13,12 +14,12 @@ AudioStream::AudioStream(uint32_t rate, uint32_t duration, uint32_t intrRate, QS
 	format_.setSampleSize(16);   // int16
 	format_.setSampleType(QAudioFormat::SignedInt);
 
-	audio_ = std::make_unique<QAudioOutput>(info_, format_);
+	createAudioOutput();
 	mixer_ = std::make_unique<AudioStreamMixier>(rate, duration, intrRate);
 	QObject::connect(mixer_.get(), &AudioStreamMixier::streamInterrupted,
 					 this, [&]() { emit streamInterrupted(); }, Qt::DirectConnection);
 	QObject::connect(mixer_.get(), &AudioStreamMixier::bufferPrepared,
-					 this, [&](int16_t *container, size_t nSamples) {
+					 this, [&](float *container, size_t nSamples) {
 		emit bufferPrepared(container, nSamples);
 	}, Qt::DirectConnection);
 
@@ -46,7 +47,7 @@ void AudioStream::setRate(uint32_t rate)
 {
 	stop();
 	format_.setSampleRate(rate);
-	audio_ = std::make_unique<QAudioOutput>(info_, format_);
+	createAudioOutput();
 	mixer_->setRate(rate);
 	start();
 }
@@ -69,7 +70,7 @@ void AudioStream::setDevice(QString device)
 {
 	stop();
 	setDeviceFromString(device);
-	audio_ = std::make_unique<QAudioOutput>(info_, format_);
+	createAudioOutput();
 	start();
 }
 
@@ -86,3 +87,13 @@ void AudioStream::setDeviceFromString(QString device)
 		}
 	}
 }
+
+void AudioStream::createAudioOutput()
+{
+	audio_ = std::make_unique<QAudioOutput>(info_, format_);
+	QObject::connect(audio_.get(), &QAudioOutput::stateChanged,
+					 this, [&](QAudio::State state) {
+		if (state == QAudio::IdleState && audio_->error() == QAudio::UnderrunError)
+			AudioProfiler::countUnderrun();
+	});
+}
@@ -27,7 +27,7 @@ public:
 
 signals:
 	void streamInterrupted();
-	void bufferPrepared(int16_t *container, size_t nSamples);
+	void bufferPrepared(float *container, size_t nSamples);
 
 private:
 	QAudioDeviceInfo info_;
@@ -36,4 +36,5 @@ private:
 	std::unique_ptr<AudioStreamMixier> mixer_;
 
 	void setDeviceFromString(QString device);
+	void createAudioOutput();
 };
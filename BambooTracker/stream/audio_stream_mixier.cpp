@@ -1,11 +1,14 @@
 #include "audio_stream_mixier.hpp"
 #include <algorithm>
+#include <chrono>
+#include "audio_profiler.hpp"
 
 AudioStreamMixier::AudioStreamMixier(uint32_t rate, uint32_t duration, uint32_t intrRate, QObject* parent) :
 	QIODevice(parent),
 	rate_(rate),
 	duration_(duration),
 	intrRate_(intrRate),
+	intrCountFracSum_(0),
 	intrCountRest_(0),
 	isFirstRead_(true)
 {
@@ -61,10 +64,15 @@ void AudioStreamMixier::updateBufferSampleSize()
 void AudioStreamMixier::updateIntrruptCount()
 {
 	intrCount_ = rate_ / intrRate_;
+	intrCountFrac_ = rate_ % intrRate_;
+	intrCountFracSum_ = 0;
 }
 
 qint64 AudioStreamMixier::readData(char* data, qint64 maxlen)
 {
+	auto begin = std::chrono::steady_clock::now();
+	bool isFirst = isFirstRead_;
+
 	qint64 generatedCount;
 	if (isFirstRead_) {   // Fill device buffer in first read
 		generatedCount = maxlen >> 2;
@@ -74,12 +82,18 @@ qint64 AudioStreamMixier::readData(char* data, qint64 maxlen)
 		generatedCount = std::min(bufferSampleSize_, (maxlen >> 2));
 	}
 	size_t requiredCount = static_cast<size_t>(generatedCount);
-	int16_t* destPtr = reinterpret_cast<int16_t*>(data);
+	if (buffer_.size() < (requiredCount << 1)) buffer_.resize(requiredCount << 1);
+	float* destPtr = buffer_.data();
 
 	size_t count;
 	while (requiredCount) {
 		if (!intrCountRest_) {	// Interruption
 			intrCountRest_ = intrCount_;    // Set counts to next interruption
+			intrCountFracSum_ += intrCountFrac_;
+			if (intrCountFracSum_ >= intrRate_) {
+				intrCountFracSum_ -= intrRate_;
+				++intrCountRest_;
+			}
 			emit streamInterrupted();
 		}
 
@@ -92,6 +106,19 @@ qint64 AudioStreamMixier::readData(char* data, qint64 maxlen)
 		destPtr += (count << 1);	// Move head
 	}
 
+	// Convert to device format
+	int16_t* dev = reinterpret_cast<int16_t*>(data);
+	for (size_t i = 0, n = static_cast<size_t>(generatedCount << 1); i < n; ++i) {
+		dev[i] = static_cast<int16_t>(std::min(std::max(buffer_[i] * 32768.0f, -32768.0f), 32767.0f));
+	}
+
+	auto ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+										std::chrono::steady_clock::now() - begin).count());
+	AudioProfiler::record(AudioStage::STREAM_READ, ns);
+	// The first read fills whole device buffer, so it is not a deadline
+	if (!isFirst && ns * rate_ > static_cast<uint64_t>(generatedCount) * 1000000000)
+		AudioProfiler::countDeadlineMiss();
+
 	return generatedCount << 2; // Return generated bytes count
 }
 
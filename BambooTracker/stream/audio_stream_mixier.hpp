@@ -3,6 +3,7 @@
 #include <QObject>
 #include <QIODevice>
 #include <cstdint>
+#include <vector>
 
 class AudioStreamMixier : public QIODevice
 {
@@ -25,7 +26,7 @@ public:
 
 signals:	
 	void streamInterrupted();
-	void bufferPrepared(int16_t *container, size_t nSamples);
+	void bufferPrepared(float *container, size_t nSamples);
 
 private:
 	size_t rate_;
@@ -33,11 +34,18 @@ private:
 	qint64 bufferSampleSize_;
 
 	size_t intrRate_;
+	/// Samples per interruption is intrCount_ + intrCountFrac_ / intrRate_.
+	/// The fraction is accumulated to intrCountFracSum_ so that ticks do not drift
 	size_t intrCount_;
+	size_t intrCountFrac_;
+	size_t intrCountFracSum_;
 	size_t intrCountRest_;
 
 	bool isFirstRead_;
 
+	/// Float samples which are converted to int16 when passed to the device
+	std::vector<float> buffer_;
+
 	void updateBufferSampleSize();
 	void updateIntrruptCount();
 };
@@ -5,7 +5,8 @@ TickCounter::TickCounter() :
 	tempo_(150),    // Dummy set
 	tickRate_(60),	// NTSC
 	nextGroovePos_(-1),
-	defStepSize_(6)    // Dummy set
+	defStepSize_(6),    // Dummy set
+	tickDifSum_(0)
 {
 	updateTickDIf();
 }
@@ -75,8 +76,10 @@ int TickCounter::countUp()
 
 void TickCounter::updateTickDIf()
 {
-	float strictTicksPerStepByBpm = 10.0 * tickRate_ * defStepSize_ / (tempo_ << 2);
-	tickDif_ = strictTicksPerStepByBpm - static_cast<float>(defStepSize_);
+	// Strict ticks per step by bpm: 10 * tickRate * stepSize / (4 * tempo)
+	int64_t stepSize = static_cast<int64_t>(defStepSize_);
+	tickDifDenom_ = static_cast<int64_t>(tempo_) << 2;
+	tickDif_ = 10 * static_cast<int64_t>(tickRate_) * stepSize - stepSize * tickDifDenom_;
 }
 
 void TickCounter::resetCount()
@@ -85,13 +88,43 @@ void TickCounter::resetCount()
 	tickDifSum_ = 0;
 }
 
+uint64_t TickCounter::getTickCountToStep(size_t step) const
+{
+	if (nextGroovePos_ == -1 || grooves_.empty()) {	// Use speed when the groove is empty
+		// Integer division truncates toward zero as same as resetRest
+		int64_t n = static_cast<int64_t>(step);
+		return static_cast<uint64_t>(n * static_cast<int64_t>(defStepSize_) + n * tickDif_ / tickDifDenom_);
+	}
+	else {
+		size_t len = grooves_.size();
+		uint64_t sum = 0;
+		for (int g : grooves_) sum += static_cast<uint64_t>(g);
+		uint64_t ticks = (step / len) * sum;
+		for (size_t i = 0, pos = nextGroovePos_; i < step % len; ++i, pos = (pos + 1) % len) {
+			ticks += static_cast<uint64_t>(grooves_[pos]);
+		}
+		return ticks;
+	}
+}
+
+uint64_t TickCounter::getSampleIndexOfStep(size_t step, uint32_t sampleRate) const
+{
+	return getSampleIndexOfTick(getTickCountToStep(step), sampleRate, static_cast<uint32_t>(tickRate_));
+}
+
+uint64_t TickCounter::getSampleIndexOfTick(uint64_t tick, uint32_t sampleRate, uint32_t tickRate)
+{
+	// Equal to the interruption made by accumulating the fraction of sampleRate / tickRate
+	return tick * sampleRate / tickRate;
+}
+
 void TickCounter::resetRest()
 {
-	if (nextGroovePos_ == -1) {
+	if (nextGroovePos_ == -1 || grooves_.empty()) {
 		tickDifSum_ += tickDif_;
-		int castedTickDifSum = static_cast<int>(tickDifSum_);
+		int64_t castedTickDifSum = tickDifSum_ / tickDifDenom_;
 		restTickToNextStep_ = defStepSize_ + castedTickDifSum;
-		tickDifSum_ -= castedTickDifSum;
+		tickDifSum_ -= castedTickDifSum * tickDifDenom_;
 	}
 	else {
 		restTickToNextStep_ = grooves_.at(nextGroovePos_);
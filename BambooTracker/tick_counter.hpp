@@ -17,6 +17,14 @@ public:
 	int countUp();
 	void resetCount();
 
+	/// Tick count from the head of the first step to the head of the given step
+	/// after resetCount, while tempo, speed and groove are unchanged
+	uint64_t getTickCountToStep(size_t step) const;
+	/// Sample index of the head of the given step by the same condition
+	uint64_t getSampleIndexOfStep(size_t step, uint32_t sampleRate) const;
+	/// Sample index of the head of the given tick when ticks are interrupted at tickRate
+	static uint64_t getSampleIndexOfTick(uint64_t tick, uint32_t sampleRate, uint32_t tickRate);
+
 private:
 	bool isPlaySong_;
 	int tempo_;
@@ -27,8 +35,11 @@ private:
 	size_t defStepSize_;
 	size_t restTickToNextStep_;
 
-	float tickDif_;
-	float tickDifSum_;
+	/// Difference between strict ticks per step and step size is tickDif_ / tickDifDenom_.
+	/// The sum is kept as a numerator over the same denominator so that it never drifts
+	int64_t tickDif_;
+	int64_t tickDifDenom_;
+	int64_t tickDifSum_;
 
 	void updateTickDIf();
 	void resetRest();
@@ -12,6 +12,12 @@ public:
 	static uint32_t ofModuleFileInBCD();
 	static std::string ofModuleFileInString();
 
+	/// Container of the module file whose sections are compressed.
+	/// Sections inside it are the module file version.
+	/// Loaders detect the container by this exact version,
+	/// so it is reserved and the module file version must stay below it
+	static uint32_t ofCompressedModuleFileInBCD();
+
 	static uint32_t ofInstrumentFileInBCD();
 	static std::string ofInstrumentFileInString();
 
@@ -26,6 +32,12 @@ private:
 	static constexpr unsigned int modFileMinor		= 0;
 	static constexpr unsigned int modFileRevision	= 0;
 
+	// Compressed module file version
+	static constexpr unsigned int compModFileMajor		= 2;
+	static constexpr unsigned int compModFileMinor		= 0;
+	static constexpr unsigned int compModFileRevision	= 0;
+	static_assert(modFileMajor < compModFileMajor, "Compressed module file version is reserved");
+
 	// Instrument file version
 	static constexpr unsigned int instFileMajor		= 1;
 	static constexpr unsigned int instFileMinor		= 0;
@@ -57,6 +69,11 @@ inline std::string Version::ofModuleFileInString()
 	return toString(modFileMajor, modFileMinor, modFileRevision);
 }
 
+inline uint32_t Version::ofCompressedModuleFileInBCD()
+{
+	return toBCD(compModFileMajor, compModFileMinor, compModFileRevision);
+}
+
 inline uint32_t Version::ofInstrumentFileInBCD()
 {
 	return toBCD(instFileMajor, instFileMinor, instFileRevision);